@@ -2,12 +2,25 @@
 #define AI_H
 
 #include "types.h"
+#include "readback.h"
+#include "mailbox.h"
+#include "snapshot_ring.h"
+#include "astar.h"
+#include "dstar_lite.h"
+#include "distance_field.h"
+#include "thread_pool.h"
+#include "ray_fan.h"
+#include "lookahead.h"
+#include "territory.h"
+#include "ai_profiler.h"
+#include "ai_budget.h"
+#include "simulation.h"
 #include <vector>
 #include <random>
 #include <thread>
 #include <mutex>
-
-class Game;
+#include <condition_variable>
+#include <atomic>
 
 class AI {
 public:
@@ -16,7 +29,7 @@ public:
         bool hasDanger;
         bool greenVisible;
         Vec2 hitPos;
-        std::string color;
+        CellType cell; // what the line ran into, Empty for nothing
     };
 
     struct RaycastResult {
@@ -27,66 +40,110 @@ public:
         Vec2 rightDir;
     };
 
-    struct PathNode {
-        Vec2 pos;
-        float gCost;
-        float fCost;
-        std::shared_ptr<PathNode> parent;
-
-        bool operator>(const PathNode& other) const { return fCost > other.fCost; }
-    };
-
-    AI(const GameConfig& config, Game& game);
+    AI(const GameConfig& config, Simulation& sim, int self); // self is the player slot it drives
     ~AI();
 
     bool getMode() const { return modeEnabled; }
     void setMode(bool enabled) { modeEnabled = enabled; }
     void resetFlash() { flashUsed = false; }
-    void startUpdate(Player& aiPlayer, const Player& opponent, const Collectible& collectible,
-                     const std::vector<Circle>& circles, float dt, std::mt19937& rng, Game& game,
-                     const std::vector<unsigned char>& framebuffer, int drawableWidth, int drawableHeight, SDL_Color);
-    void waitForUpdate();
-    void applyUpdate(Player& aiPlayer);
+    // Show the AI the world after a tick. With AI_WORKER the worker thread thinks about a copy
+    // while the game steps and draws; without it the decision is made before this returns.
+    void post(Simulation& sim, const PixelSnapshot& framebuffer, int drawableWidth, int drawableHeight);
+    void applyUpdate(const Player& aiPlayer, InputFrame& input); // steers its player slot toward the latest decision, never waits
+    void addReadbackRegions(const Player& aiPlayer, const Collectible& collectible, ReadbackManager& readback) const;
+    AIProfiler& getProfiler() { return profiler; }
+    const AIProfiler& getProfiler() const { return profiler; }
 
 private:
-    void simulateControllerInput(const Player& aiPlayer, const Collectible& collectible,
-                                const std::vector<Circle>& circles, const Player& opponent,
-                                float dt, std::mt19937& rng, Game& game,
-                                const std::vector<unsigned char>& framebuffer, int drawableWidth, int drawableHeight,
-                                float& leftTrigger, float& rightTrigger, bool& aButton);
+    // The world as posted: a Simulation holding only what can be seen, and the pixels under it.
+    // The worker only reads it; slots are refilled with what changed since they were last used.
+    struct World {
+        Simulation view;
+        std::vector<unsigned char> pixels;
+        int drawableWidth;
+        int drawableHeight;
+    };
+
+    struct Decision {
+        Vec2 targetDir;
+        float steer;  // right trigger minus left, held as is instead of turning to targetDir
+        bool steered; // the lookahead search chose steer
+        bool aButton;
+        bool valid;
+    };
+
+    void workerLoop();
+    void feedPlanner(const Simulation& sim);
+    void buildField(const Simulation& sim);
+    Decision think(const Simulation& sim, const PixelSnapshot& framebuffer, int drawableWidth, int drawableHeight);
+    void searchAhead(const Simulation& sim, const PixelSnapshot& framebuffer, int drawableWidth, int drawableHeight,
+                     Decision& decision);
     Vec2 calculateTargetDirection(const Player& aiPlayer, const Collectible& collectible,
                                   const std::vector<Circle>& circles, const Player& opponent,
-                                  std::mt19937& rng, Game& game, float currentTimeSec,
-                                  const std::vector<unsigned char>& framebuffer, int drawableWidth, int drawableHeight);
-    RaycastResult raycastForward(const Player& aiPlayer, Game& game, float currentTimeSec,
-                                 const std::vector<unsigned char>& framebuffer, int drawableWidth, int drawableHeight);
+                                  const Simulation& sim, float currentTimeSec,
+                                  const PixelSnapshot& framebuffer, int drawableWidth, int drawableHeight);
+    RaycastResult raycastForward(const Player& aiPlayer, const Simulation& sim, float currentTimeSec,
+                                 const PixelSnapshot& framebuffer, int drawableWidth, int drawableHeight);
     LineCheckResult checkLine(const Vec2& start, const Vec2& dir, float maxDistance, const Vec2& playerDir,
-                              Game& game, float currentTimeSec, const std::vector<unsigned char>& framebuffer,
+                              const Simulation& sim, float currentTimeSec, const PixelSnapshot& framebuffer,
                               int drawableWidth, int drawableHeight) const;
-    std::string getPixelColor(const Vec2& pos, Game& game, float currentTimeSec,
-                              const std::vector<unsigned char>& framebuffer, int drawableWidth, int drawableHeight) const;
+    LineCheckResult castSegments(const Vec2& start, const Vec2& dir, float maxDistance, const Simulation& sim) const;
+    CellType sampleCell(const Vec2& pos, const Simulation& sim, const PixelSnapshot& framebuffer,
+                        int drawableWidth, int drawableHeight) const;
+    const Player& own(const Simulation& sim) const { return self == 0 ? sim.player1 : sim.player2; }
+    const Player& rival(const Simulation& sim) const { return self == 0 ? sim.player2 : sim.player1; }
     float heuristic(const Vec2& a, const Vec2& b) const;
-    bool isPositionSafe(const Vec2& pos, const std::vector<Circle>& circles, const Player& opponent, Game& game);
-    std::vector<Vec2> findPathAStar(const Vec2& start, const Vec2& goal, const std::vector<Circle>& circles,
-                                    const Player& opponent, Game& game, const std::vector<unsigned char>& framebuffer,
-                                    int drawableWidth, int drawableHeight);
+    bool isPositionSafe(const Vec2& pos, const std::vector<Circle>& circles, const Player& opponent, const Simulation& sim);
+    const std::vector<Vec2>& findPathAStar(const Vec2& start, const Vec2& goal, const std::vector<Circle>& circles,
+                                           const Player& opponent, const Simulation& sim, const PixelSnapshot& framebuffer,
+                                           int drawableWidth, int drawableHeight);
 
     const GameConfig& config;
-    Game* game;
-    std::vector<unsigned char> framebuffer;
+    Simulation* sim;
+    int self;
+    std::mt19937 rng; // own stream so the AI's choices do not shift the world's
+    PixelSnapshot framebuffer;
     int drawableWidth;
     int drawableHeight;
-    bool flashUsed;
+    std::atomic<bool> flashUsed; // set on the main thread, read by the worker
     bool modeEnabled;
-    float leftTrigger;
-    float rightTrigger;
-    bool aButton;
-    std::thread updateThread;
-    std::mutex mutex;
-    bool updateReady;
-    Vec2 newDirection;
+    bool aButton; // calculateTargetDirection wants the flash
     float currentTimeSec;
+    float tickDt; // length of the tick being decided
     int frameCount;
+    GridAStar astar;     // pixel mode, and when the planner knows no route
+    DStarLite planner;   // keeps its search between decisions
+    ThreadPool pool;     // helpers for the distance field
+    DistanceField field; // clearance to trails and circles, refreshed once per decision
+    RayFan fan;          // grid mode rays, batched for the direction sweep
+    Lookahead lookahead; // AI_MODE=1
+    Territory territory; // grid mode, weighs the sweep's directions
+    float territoryMicros; // what the last territory map cost, to skip one that would not fit; 0 before the first
+    uint64_t territoryTick; // when the map was made, it only weighs directions while recent
+    AIBudget budget;     // AI_DIFFICULTY, restarted by each decision
+    mutable AIProfiler profiler; // AI_PROFILE, counted from the const ray casts too
+    std::vector<Vec2> sweepDirs;
+    std::vector<LineCheckResult> sweepLines; // by direction, valid where sweepCast is set
+    std::vector<uint8_t> sweepCast;
+    std::vector<int> passIndices; // the directions one sweep pass casts
+    std::vector<Vec2> passDirs;
+    std::vector<RayFan::Hit> sweepHits;
+    std::vector<Vec2> path; // last path found, storage kept between searches
+    std::vector<Vec2> plannedCircles; // where things were when the planner last heard
+    Vec2 plannedOpponent;
+    Vec2 plannedSelf;
+    uint32_t plannedMask;
+    uint64_t plannedTrailChanges; // sequence number of the next trail change to feed the planner
+    std::atomic<uint64_t> consumedTrailChanges; // the same, for the main thread to drop what was read
+
+    // Main thread to worker and back; the mutex only parks the worker while the mailbox is empty
+    SnapshotRing<World> worlds;
+    Mailbox<Decision> decisions;
+    Decision current; // latest decision the main thread has fetched
+    std::thread worker;
+    std::mutex wakeMutex;
+    std::condition_variable wake;
+    std::atomic<bool> stopping;
 };
 
 #endif // AI_H
\ No newline at end of file
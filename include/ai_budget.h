@@ -0,0 +1,52 @@
+#ifndef AI_BUDGET_H
+#define AI_BUDGET_H
+
+#include "types.h"
+#include <chrono>
+
+// What one search may spend: points expanded and a wall clock deadline. The search stops at
+// whichever comes first and answers with the best it has found.
+struct SearchLimit {
+    int nodes; // 0 = no limit
+    std::chrono::steady_clock::time_point deadline; // time_point::max() = no limit
+
+    static SearchLimit unlimited() { return SearchLimit{0, std::chrono::steady_clock::time_point::max()}; }
+    // The clock is read every CLOCK_EVERY expansions
+    bool reached(int expanded) const {
+        if (nodes > 0 && expanded >= nodes) return true;
+        return expanded % CLOCK_EVERY == 0 && deadline != std::chrono::steady_clock::time_point::max() &&
+               std::chrono::steady_clock::now() >= deadline;
+    }
+
+    static constexpr int CLOCK_EVERY = 64;
+};
+
+// AI_DIFFICULTY as compute. Each tier is a wall time per decision and a cap on the points a
+// path search expands. The AI answers coarse first and refines while the decision has time,
+// so a slow machine gets a weaker opponent at the same tick rate instead of late decisions.
+class AIBudget {
+public:
+    struct Tier {
+        const char* name;
+        float micros; // per decision, 0 = no limit
+        int nodes;    // per path search, 0 = no limit
+    };
+
+    explicit AIBudget(const GameConfig& config);
+
+    void start(); // a decision begins now
+    bool expired() const;
+    float remainingMicros() const; // infinity with no time limit
+    SearchLimit searchLimit() const { return SearchLimit{tier.nodes, until}; }
+    std::chrono::steady_clock::time_point deadline() const { return until; }
+    const Tier& getTier() const { return tier; }
+
+    // AI_DIFFICULTY 1-4, or 0 for AI_DECISION_BUDGET_US and AI_ASTAR_BUDGET as set
+    static Tier tierFor(const GameConfig& config);
+
+private:
+    Tier tier;
+    std::chrono::steady_clock::time_point until;
+};
+
+#endif // AI_BUDGET_H
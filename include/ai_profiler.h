@@ -0,0 +1,117 @@
+#ifndef AI_PROFILER_H
+#define AI_PROFILER_H
+
+#include "types.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Where the AI's time goes. Scope timers record each phase of a decision and counters add up
+// the work done in it. Every series keeps its last WINDOW values for rolling percentiles (the
+// debug overlay) and a log-scale histogram of the whole session (the CSV written at exit).
+// Timing is skipped entirely while the profiler is off.
+class AIProfiler {
+public:
+    enum Phase {
+        COPY,      // post() copying the world for the worker
+        PREPARE,   // planner repairs and the distance field
+        PLAN,      // findPathAStar
+        RAYCAST,   // raycastForward
+        TERRITORY, // who reaches where first
+        SWEEP,     // the direction sweep in calculateTargetDirection
+        SEARCH,    // lookahead rollouts
+        DECISION,  // all of think()
+        PHASE_COUNT
+    };
+    enum Counter {
+        NODES,    // path points expanded
+        RAYS,     // lines cast
+        SAMPLES,  // grid cells or pixels sampled
+        ROLLOUTS, // lookahead playouts
+        COUNTER_COUNT
+    };
+
+    struct Summary {
+        uint64_t count;
+        double mean;
+        float p50, p95, p99, max;
+    };
+
+    // Times a phase from construction to the end of the enclosing block
+    class Scope {
+    public:
+        Scope(AIProfiler& profiler, Phase phase)
+            : profiler(profiler), phase(phase), running(profiler.isEnabled()),
+              start(running ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point()) {}
+        ~Scope() {
+            if (running) {
+                profiler.record(phase, std::chrono::duration<float, std::micro>(std::chrono::steady_clock::now() - start).count());
+            }
+        }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        AIProfiler& profiler;
+        Phase phase;
+        bool running;
+        std::chrono::steady_clock::time_point start;
+    };
+
+    explicit AIProfiler(bool enabled);
+
+    bool isEnabled() const { return enabled.load(std::memory_order_relaxed); }
+    void setEnabled(bool on) { enabled.store(on, std::memory_order_relaxed); }
+    void record(Phase phase, float micros);
+    // Counts go to the decision in progress, from the thread making it
+    void count(Counter counter, int amount) {
+        if (isEnabled()) pending[counter] += amount;
+    }
+    void endDecision(); // the counts so far become one value per counter
+
+    Summary phase(Phase phase) const;       // over the last WINDOW decisions
+    Summary counter(Counter counter) const;
+    Summary sessionPhase(Phase phase) const; // over the whole session, from the histogram
+    Summary sessionCounter(Counter counter) const;
+    // Non-empty histogram buckets of a phase as (upper bound in microseconds, count)
+    std::vector<std::pair<float, uint64_t>> histogram(Phase phase) const;
+    void merge(const AIProfiler& other); // session histograms only, for adding up several games
+    bool writeCsv(const std::string& path) const;
+
+    static const char* phaseName(Phase phase);
+    static const char* counterName(Counter counter);
+
+    static constexpr int WINDOW = 256;
+    static constexpr int BUCKETS = 256;        // log scale, 8 per doubling
+    static constexpr int BUCKETS_PER_DOUBLING = 8;
+    static constexpr float BUCKET_FLOOR = 0.0625f; // smallest bucket above zero
+
+private:
+    struct Series {
+        std::array<float, WINDOW> recent;
+        int filled;
+        int nextSlot;
+        std::array<uint64_t, BUCKETS> buckets;
+        uint64_t count;
+        double total;
+        float max;
+    };
+
+    void add(Series& series, float value);
+    Summary rolling(const Series& series) const;
+    Summary session(const Series& series) const;
+    static int bucketOf(float value);
+    static float bucketTop(int bucket);
+
+    std::atomic<bool> enabled;
+    mutable std::mutex mutex; // phases are timed on the main thread and the worker, read by the overlay
+    std::array<Series, PHASE_COUNT> phases;
+    std::array<Series, COUNTER_COUNT> counters;
+    std::array<int64_t, COUNTER_COUNT> pending;
+};
+
+#endif // AI_PROFILER_H
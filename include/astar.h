@@ -0,0 +1,119 @@
+#ifndef ASTAR_H
+#define ASTAR_H
+
+#include "types.h"
+#include "ai_budget.h"
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// A* over a square lattice of points spacing apart, lined up with the start point.
+// Per-point costs, parents and heap positions live in flat arrays sized to the board and
+// reused between searches; a generation stamp marks which entries belong to this search,
+// so nothing is cleared or allocated per search once the arrays have grown.
+// A search stops at its SearchLimit and then returns the path to the point that got closest
+// to the goal.
+class GridAStar {
+public:
+    struct Result {
+        int expanded;     // points taken off the heap
+        bool reachedGoal; // false: path leads to the closest point found
+    };
+
+    GridAStar(const GameConfig& config, float spacing);
+
+    // Fills path with lattice points from start toward goal (start first). passable(pos) says
+    // whether a point may be entered. path is left empty when no step away from start was possible.
+    template <typename Passable>
+    Result findPath(const Vec2& start, const Vec2& goal, float width, float height, Passable passable,
+                    const SearchLimit& limit, std::vector<Vec2>& path);
+
+private:
+    void prepare(const Vec2& start, float width, float height);
+    Vec2 position(int node) const {
+        return Vec2(origin.x + (node % cols) * spacing, origin.y + (node / cols) * spacing);
+    }
+    bool fresh(int node) const { return stamp[node] == generation; }
+    void open(int node, float gCost, float fCost, int parentNode);
+    int popBest();
+    void siftUp(size_t i);
+    void siftDown(size_t i);
+    void tracePath(int node, std::vector<Vec2>& path) const;
+
+    const GameConfig& config;
+    float spacing;
+    Vec2 origin; // lattice point nearest (0, 0)
+    int cols;
+    int rows;
+    std::vector<float> g;
+    std::vector<float> f;
+    std::vector<int32_t> parent;
+    std::vector<int32_t> heapPos; // index in heap, or CLOSED
+    std::vector<uint32_t> stamp;  // generation that last touched the point
+    std::vector<int32_t> heap;    // binary min-heap of points by f
+    uint32_t generation;
+
+    static constexpr int32_t CLOSED = -1;
+    static constexpr int32_t NO_PARENT = -1;
+};
+
+template <typename Passable>
+GridAStar::Result GridAStar::findPath(const Vec2& start, const Vec2& goal, float width, float height, Passable passable,
+                                      const SearchLimit& limit, std::vector<Vec2>& path) {
+    static const int DX[8] = {1, -1, 0, 0, 1, 1, -1, -1};
+    static const int DY[8] = {0, 0, 1, -1, 1, -1, 1, -1};
+    const float DIAGONAL = spacing * std::sqrt(2.0f);
+
+    path.clear();
+    prepare(start, width, height);
+    Result result{0, false};
+
+    int startNode = static_cast<int>(std::lround((start.y - origin.y) / spacing)) * cols +
+                    static_cast<int>(std::lround((start.x - origin.x) / spacing));
+    open(startNode, 0.0f, (goal - start).magnitude(), NO_PARENT);
+    int best = startNode;
+    float bestH = (goal - start).magnitude();
+
+    while (!heap.empty() && !limit.reached(result.expanded)) {
+        int current = popBest();
+        ++result.expanded;
+        Vec2 currentPos = position(current);
+        float h = (goal - currentPos).magnitude();
+        if (h < spacing) {
+            best = current;
+            result.reachedGoal = true;
+            break;
+        }
+        if (h < bestH) {
+            bestH = h;
+            best = current;
+        }
+
+        int cx = current % cols;
+        int cy = current / cols;
+        for (int k = 0; k < 8; ++k) {
+            int nx = cx + DX[k];
+            int ny = cy + DY[k];
+            if (nx < 0 || ny < 0 || nx >= cols || ny >= rows) continue;
+            int next = ny * cols + nx;
+            if (fresh(next) && heapPos[next] == CLOSED) continue;
+            float gCost = g[current] + (k < 4 ? spacing : DIAGONAL);
+            if (fresh(next) && gCost >= g[next]) continue;
+            // Only test what the search actually reaches, and each point once
+            Vec2 nextPos = position(next);
+            if (!fresh(next) && !passable(nextPos)) {
+                stamp[next] = generation;
+                heapPos[next] = CLOSED;
+                continue;
+            }
+            open(next, gCost, gCost + (goal - nextPos).magnitude(), current);
+        }
+    }
+
+    if (best != startNode) {
+        tracePath(best, path);
+    }
+    return result;
+}
+
+#endif // ASTAR_H
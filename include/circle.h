@@ -2,22 +2,24 @@
 #define CIRCLE_H
 
 #include "types.h"
+#include "grid.h"
+#include "segment_index.h"
 #include <vector>
 #include <random>
-#include <chrono>
 
-class Game;
+class Simulation;
 
 class CircleManager {
 public:
     CircleManager(const GameConfig& config);
-    void spawnInitialCircle(std::mt19937& rng, std::vector<Circle>& circles, const Game& game);
+    void spawnInitialCircle(std::mt19937& rng, std::vector<Circle>& circles, const Simulation& sim);
     void updateCircles(float dt, std::vector<Circle>& circles, std::mt19937& rng, float currentTimeSec,
-                      std::chrono::steady_clock::time_point& lastCircleSpawn, Game& game);
-    void clearTrails(const std::vector<Circle>& circles, Player& player1, Player& player2);
+                      float& lastCircleSpawn, Simulation& sim);
+    void clearTrails(std::vector<Circle>& circles, Simulation& sim);
 
 private:
     const GameConfig& config;
+    std::vector<uint32_t> hits; // reused so frames that erase nothing do not allocate
 };
 
 #endif // CIRCLE_H
\ No newline at end of file
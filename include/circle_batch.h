@@ -0,0 +1,36 @@
+#ifndef CIRCLE_BATCH_H
+#define CIRCLE_BATCH_H
+
+#include "gl_ext.h"
+#include <SDL2/SDL.h>
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "types.h"
+
+// Filled circles collected over a frame and drawn as one triangle list: first all in black,
+// erasing what is under them, then all in their own colors. The positions go up once and are
+// drawn twice. Outlines come from unit-circle tables made once per level of detail; a circle
+// uses the fewest segments that keep its edge within MAX_EDGE_ERROR of round.
+class CircleBatch {
+public:
+    CircleBatch();
+    void add(float x, float y, float radius, const SDL_Color& color);
+    int flush(); // draws what was added, returns the draw calls issued
+    bool empty() const { return positions.empty(); }
+    void shutdown(); // call while the GL context is still alive
+
+private:
+    static constexpr float MAX_EDGE_ERROR = 0.5f; // ortho units between a chord and the true edge
+    static constexpr std::array<int, 8> LEVELS = {8, 12, 16, 20, 24, 32, 48, 64};
+
+    static size_t levelFor(float radius);
+
+    std::array<std::vector<Vec2>, LEVELS.size()> unitCircles; // LEVELS[i] + 1 points, the last repeats the first
+    std::vector<float> positions;  // x, y per vertex
+    std::vector<uint8_t> colors;   // r, g, b, a per vertex
+    GLuint vbo;
+    size_t capacity; // bytes the buffer object holds
+};
+
+#endif // CIRCLE_BATCH_H
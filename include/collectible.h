@@ -4,13 +4,13 @@
 #include "types.h"
 #include <random>
 
-class Game; // Changed from struct to class
+class Simulation;
 
 class CollectibleManager {
 public:
     CollectibleManager(const GameConfig& config);
-    Collectible spawnCollectible(std::mt19937& rng, const Game& game) const;
-    bool checkCollectibleCollision(const Vec2& playerPos, const Collectible& collectible, const Game& game) const;
+    Collectible spawnCollectible(std::mt19937& rng, const Simulation& sim) const;
+    bool checkCollectibleCollision(const Vec2& playerPos, const Collectible& collectible, const Simulation& sim) const;
 
 private:
     const GameConfig& config;
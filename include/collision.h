@@ -4,13 +4,13 @@
 #include "types.h"
 
 // Forward declaration
-struct Game;
+class Simulation;
 
 class CollisionManager {
 public:
     CollisionManager(const GameConfig& config);
-    bool checkPixelCollision(const Vec2& pos, const Game& game) const;
-    bool checkAreaCollision(const Vec2& center, int size, const Game& game) const;
+    bool checkPixelCollision(const Vec2& pos, const Simulation& sim) const;
+    bool checkAreaCollision(const Vec2& center, int size, const Simulation& sim) const;
 
 private:
     const GameConfig& config;
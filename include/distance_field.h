@@ -0,0 +1,68 @@
+#ifndef DISTANCE_FIELD_H
+#define DISTANCE_FIELD_H
+
+#include "types.h"
+#include "thread_pool.h"
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// How far each spot of the board is from the nearest trail and the nearest circle, for the AI.
+// Trail distances are exact Euclidean transforms (Felzenszwalb and Huttenlocher) capped at
+// getReach(). The board is cut into tiles; a change only dirties the tiles within reach of it,
+// and dirty tiles are recomputed independently across the pool. Circle distances are stamped
+// around each circle per decision, since every circle moves every tick.
+// Both are measured between cell centres: trailDistance() subtracts that slack so it never
+// overstates the clear distance, circleDistance() is good to about half a cell.
+class DistanceField {
+public:
+    explicit DistanceField(const GameConfig& config);
+
+    void resize(float width, float height); // a new size dirties everything
+    void invalidate();
+    void markChanged(float minX, float minY, float maxX, float maxY); // trail inside may differ
+    // Catch up on changes. occupied(minX, minY, maxX, maxY) says whether any trail lies in the box;
+    // it is called from several threads at once when many cells need it.
+    void update(const std::function<bool(float, float, float, float)>& occupied, ThreadPool& pool);
+    float trailDistance(const Vec2& pos) const; // never more than the real distance, at most getReach()
+    float getReach() const { return REACH_CELLS * cellSize; }
+    float getCellSize() const { return cellSize; }
+    int getCols() const { return cols; }
+    int getRows() const { return rows; }
+    const float* trailPlane() const { return trail.data(); } // raw, without trailDistance's slack
+
+    void stampCircles(const std::vector<Circle>& circles, float reach); // replaces the last stamp
+    float circleDistance(const Vec2& pos) const { return circles[cellAt(pos)]; } // to an edge, FAR past reach
+    const float* circlePlane() const { return circles.data(); }
+
+    static constexpr float FAR = 1e20f;
+
+private:
+    struct Rect { int x0, y0, x1, y1; }; // cells, inclusive
+
+    size_t cellAt(const Vec2& pos) const;
+    Rect cellRect(float minX, float minY, float maxX, float maxY) const;
+    void refreshOccupancy(const Rect& r, const std::function<bool(float, float, float, float)>& occupied);
+    void computeTile(int tile);
+    static void transform1D(const float* f, int n, float* d, int* v, float* z);
+
+    const GameConfig& config;
+    float cellSize;
+    int cols;
+    int rows;
+    int tileCols;
+    int tileRows;
+    bool everything;                // next update redoes the whole board
+    std::vector<Rect> pending;      // changed since the last update
+    std::vector<uint8_t> occupancy; // 1 where a trail touches the cell
+    std::vector<float> trail;       // distance between cell centres, capped at reach
+    std::vector<uint8_t> tileDirty;
+    std::vector<int> dirtyTiles;
+    std::vector<float> circles;
+    std::vector<Rect> circleRects;  // what the last stamp wrote
+
+    static constexpr int TILE_CELLS = 16;
+    static constexpr int REACH_CELLS = 8;
+};
+
+#endif // DISTANCE_FIELD_H
@@ -0,0 +1,95 @@
+#ifndef DSTAR_LITE_H
+#define DSTAR_LITE_H
+
+#include "types.h"
+#include "ai_budget.h"
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// D* Lite (Koenig and Likhachev) on the same kind of lattice GridAStar uses, lined up with the goal.
+// It searches from the goal back to the start and keeps that search between plans, so when the
+// AI moves or a few points change only the nodes those changes reach are looked at again.
+// Callers say where the board may have changed with markChanged(); the planner starts over when
+// the goal moves or the changes cover most of the board.
+class DStarLite {
+public:
+    struct Stats {
+        int expanded;    // nodes taken off the queue in this plan
+        int updated;     // rhs recomputations in this plan
+        int rechecked;   // known points whose passability was tested again
+        bool fullSearch; // the plan started from nothing
+        bool complete;   // the start's cost is settled; false when the limit was reached
+    };
+
+    DStarLite(const GameConfig& config, float spacing);
+
+    void reset(); // the next plan searches from nothing
+    void markChanged(float minX, float minY, float maxX, float maxY); // passability inside may differ
+    // Fills path with lattice points from the start to the goal, empty when no route is known yet.
+    // passable is asked about each point once, then again only inside changed boxes. A plan cut
+    // short by limit keeps its queue, and the next plan carries on from there.
+    Stats plan(const Vec2& start, const Vec2& goal, float width, float height,
+               const std::function<bool(const Vec2&)>& passable, const SearchLimit& limit, std::vector<Vec2>& path);
+    const Stats& lastFullSearch() const { return fullStats; }
+
+private:
+    struct Key {
+        float k1;
+        float k2;
+        bool operator<(const Key& o) const { return k1 < o.k1 || (k1 == o.k1 && k2 < o.k2); }
+    };
+    struct Box { float minX, minY, maxX, maxY; };
+
+    void initialize(const Vec2& goal, float width, float height);
+    void applyChanges();
+    bool blocked(int node);
+    float edgeCost(int from, int to);
+    float heuristic(int a, int b) const;
+    Key calculateKey(int node) const;
+    void updateVertex(int node);
+    void computeShortestPath(const SearchLimit& limit);
+    void extractPath(std::vector<Vec2>& path);
+    Vec2 position(int node) const {
+        return Vec2(origin.x + (node % cols) * spacing, origin.y + (node / cols) * spacing);
+    }
+    int nodeNear(const Vec2& pos) const;
+
+    // Indexed binary heap on Key
+    void heapSet(int node, const Key& key); // insert or move
+    void heapRemove(int node);
+    void siftUp(size_t i);
+    void siftDown(size_t i);
+
+    const GameConfig& config;
+    float spacing;
+    Vec2 origin;
+    Vec2 goalPos;
+    float boardWidth;
+    float boardHeight;
+    int cols;
+    int rows;
+    int goalNode;
+    int startNode;
+    int lastNode; // start when km was last brought up to date
+    float km;
+    bool initialized;
+    const std::function<bool(const Vec2&)>* passable; // valid during plan()
+
+    std::vector<float> g;
+    std::vector<float> rhs;
+    std::vector<uint8_t> state; // UNKNOWN, FREE or BLOCKED
+    std::vector<Key> keys;
+    std::vector<int32_t> heapPos;
+    std::vector<int32_t> heap;
+    std::vector<Box> changes;
+    Stats stats;
+    Stats fullStats;
+
+    static constexpr uint8_t UNKNOWN = 0;
+    static constexpr uint8_t FREE = 1;
+    static constexpr uint8_t BLOCKED = 2;
+    static constexpr int32_t NOT_QUEUED = -1;
+};
+
+#endif // DSTAR_LITE_H
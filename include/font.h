@@ -0,0 +1,94 @@
+#ifndef FONT_H
+#define FONT_H
+
+#include <array>
+#include <cstdint>
+
+// The 5x5 pixel font, turned into a bit table at compile time. Bit row * 5 + col of a glyph
+// is a lit pixel and DEFINED marks the characters the font has; the others are not drawn
+// and take no space.
+namespace Font {
+
+constexpr int SIZE = 5;          // pixels per side
+constexpr int ADVANCE = 6;       // 5 pixels + 1 pixel spacing
+constexpr uint32_t DEFINED = 1u << 25;
+
+struct Source {
+    char c;
+    const char* pixels; // 25 of '#' and '.', row by row
+};
+
+constexpr Source SOURCES[] = {
+    {'0', "#####" "#...#" "#...#" "#...#" "#####"},
+    {'1', "..#.." "..#.." "..#.." "..#.." "..#.."},
+    {'2', "#####" "....#" "#####" "#...." "#####"},
+    {'3', "#####" "....#" "#####" "....#" "#####"},
+    {'4', "#...#" "#...#" "#####" "....#" "....#"},
+    {'5', "#####" "#...." "#####" "....#" "#####"},
+    {'6', "#####" "#...." "#####" "#...#" "#####"},
+    {'7', "#####" "....#" "....#" "....#" "....#"},
+    {'8', "#####" "#...#" "#####" "#...#" "#####"},
+    {'9', "#####" "#...#" "#####" "....#" "#####"},
+    {'A', "#####" "#...#" "#####" "#...#" "#...#"},
+    {'B', "#####" "#...#" "#####" "#...#" "#####"},
+    {'C', "#####" "#...." "#...." "#...." "#####"},
+    {'D', "#####" "#...#" "#...#" "#...#" "#####"},
+    {'E', "#####" "#...." "#####" "#...." "#####"},
+    {'F', "#####" "#...." "#####" "#...." "#...."},
+    {'G', "#####" "#...." "#.###" "#...#" "#####"},
+    {'H', "#...#" "#...#" "#####" "#...#" "#...#"},
+    {'I', "#####" "..#.." "..#.." "..#.." "#####"},
+    {'J', "#####" "....#" "....#" "....#" "#####"},
+    {'K', "#...#" "#..#." "###.." "#..#." "#...#"},
+    {'L', "#...." "#...." "#...." "#...." "#####"},
+    {'M', "#...#" "##.##" "#.#.#" "#...#" "#...#"},
+    {'N', "#...#" "##..#" "#.#.#" "#..##" "#...#"},
+    {'O', "#####" "#...#" "#...#" "#...#" "#####"},
+    {'P', "#####" "#...#" "#####" "#...." "#...."},
+    {'Q', "#####" "#...#" "#...#" "#..##" "#####"},
+    {'R', "#####" "#...#" "#####" "#..#." "#...#"},
+    {'S', "#####" "#...." "#####" "....#" "#####"},
+    {'T', "#####" "..#.." "..#.." "..#.." "..#.."},
+    {'U', "#...#" "#...#" "#...#" "#...#" "#####"},
+    {'V', "#...#" "#...#" ".#.#." ".#.#." "..#.."},
+    {'W', "#...#" "#...#" "#.#.#" "##.##" "#...#"},
+    {'X', "#...#" ".#.#." "..#.." ".#.#." "#...#"},
+    {'Y', "#...#" ".#.#." "..#.." "..#.." "..#.."},
+    {'Z', "#####" "...#." "..#.." ".#..." "#####"},
+    {'+', "....." "..#.." ".###." "..#.." "....."},
+    {'-', "....." "....." ".###." "....." "....."},
+    {' ', "....." "....." "....." "....." "....."},
+    {'.', "....." "....." "....." "....." "..#.."},
+    {',', "....." "....." "....." "....." "..##."},
+    {'!', "..#.." "..#.." "..#.." "..#.." "....."},
+    {'?', ".###." "...#." "..##." "....." "..#.."},
+    {':', "....." "..#.." "....." "..#.." "....."},
+    {';', "....." "..#.." "....." "..#.." "..##."},
+};
+
+constexpr std::array<uint32_t, 128> build() {
+    std::array<uint32_t, 128> glyphs{};
+    for (const Source& source : SOURCES) {
+        uint32_t bits = DEFINED;
+        for (int i = 0; i < SIZE * SIZE; ++i) {
+            if (source.pixels[i] == '#') bits |= 1u << i;
+        }
+        glyphs[static_cast<unsigned char>(source.c)] = bits;
+    }
+    return glyphs;
+}
+
+constexpr std::array<uint32_t, 128> GLYPHS = build();
+
+constexpr uint32_t glyph(char c) {
+    unsigned char index = static_cast<unsigned char>(c);
+    return index < GLYPHS.size() ? GLYPHS[index] : 0;
+}
+constexpr bool pixel(uint32_t glyph, int row, int col) { return (glyph >> (row * SIZE + col)) & 1u; }
+
+static_assert(glyph(' ') == DEFINED, "space is defined and blank");
+static_assert(pixel(glyph('1'), 0, 2) && !pixel(glyph('1'), 0, 0), "bit order is row * SIZE + col");
+
+} // namespace Font
+
+#endif // FONT_H
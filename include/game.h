@@ -7,16 +7,13 @@
 #include <chrono>
 #include "types.h"
 #include "audio.h"
-#include "collectible.h"
+#include "simulation.h"
 #include "collision.h"
+#include "readback.h"
 #include "render.h"
-#include "circle.h"
-#include "explosion.h"
 #include "input.h"
 #include "ai.h"
 
-// Forward declarations
-class PlayerManager;
 class AI;
 
 class Game {
@@ -24,19 +21,10 @@ public:
     Game(const GameConfig& config);
     ~Game();	
     void run();
-    void checkCollision(Player* player, Vec2 nextPos, float currentTimeSec, const std::vector<unsigned char>& framebuffer, int drawableWidth, int drawableHeight);
-    void handleGreenSquareCollection(Player* player, float currentTimeSec);
-    void handlePlayerDeath(Player* player, float currentTimeSec);
     void toggleFullscreen();
+    void toggleAIStats(); // the AI's phase timings over the board, turning the profiler on if it is off
     void reset();
-    void respawnCircles();
-    void activateNoCollision(Player* player, float currentTimeSec);
-    bool shouldRespawnPlayer(Player* player, float currentTimeSec) {
-        return !player->alive && (currentTimeSec - deathTime >= 2.0f);
-    }
-    Vec2 getSpawnPosition() {
-        return Vec2(orthoWidth / 2, orthoHeight / 2);
-    }
+    void requestFlash(int controllerIndex); // A button, applied on the next simulation step
     void resumeAfterWinner();
     SDL_Color SDLaicolor = {255, 0, 0}; // red
     SDL_Color SDLcirclecolor = {255, 0, 255}; // magenta
@@ -46,55 +34,35 @@ public:
     SDL_Window* window;
     SDL_GLContext glContext;
 	const GameConfig& config;
+    Simulation sim;
     AudioManager audio;
-    CollectibleManager collectibleManager;
     CollisionManager collisionManager;
+    ReadbackManager readbackManager;
     RenderManager renderManager;
-    CircleManager circleManager;
-    ExplosionManager explosionManager;
     InputManager inputManager;
-    PlayerManager* playerManager;
     AI* ai;
     GLuint splashTexture;
     bool isSplashScreen;
     bool paused;
+    bool showAIStats;
     SDL_GameController* controllers[2];
     int controllerCount;
-    Player player1;
-    Player player2;
-    std::vector<Circle> circles;
-    Collectible collectible;
-    std::vector<Explosion> explosions;
-    std::vector<Flash> flashes;
-    std::mt19937 rng;
     float lastBoopTime;
-    int score1;
-    int score2;
-    int roundScore1;
-    int roundScore2;
-    int setScore1;
-    int setScore2;
     bool gameOver;
     bool gameOverScreen;
     bool winnerDeclared;
     bool firstFrame;
-    std::chrono::steady_clock::time_point lastCircleSpawn;
     std::chrono::steady_clock::time_point gameOverTime;
     float lastWinnerVoiceTime;    
-    float deathTime;
-    float orthoWidth;
-    float orthoHeight;
     bool frameRendered;
-    float winningScore;
-    float greenSquarePoints;
-    float deathPoints;
+    float accumulator; // frame time not yet simulated
+    float renderAlpha; // how far between the last two ticks to draw, 0 to 1
 
 private:
-    bool collectibleCollectedThisFrame;
-    bool pendingCollectibleRespawn;
-    void update(float dt, float currentTimeSec);
+    InputFrame readControllers();
+    void stepSimulation(float tickDt, const PixelSnapshot& framebuffer, int drawableWidth, int drawableHeight);
     void render();
+    bool pendingFlash[2];
 };
 
-#include "player.h" // Include after Game class to avoid circular dependency
 #endif // GAME_H
\ No newline at end of file
@@ -0,0 +1,12 @@
+#ifndef GL_EXT_H
+#define GL_EXT_H
+
+// GL with the extension entry points the renderers call directly: buffer objects (OpenGL 1.5),
+// pixel buffers (2.1) and framebuffer objects (3.0 / ARB_framebuffer_object). The prototypes
+// are only declared if this comes before anything else includes GL/gl.h, so headers that need
+// them include this instead.
+#define GL_GLEXT_PROTOTYPES
+#include <GL/gl.h>
+#include <GL/glext.h>
+
+#endif // GL_EXT_H
@@ -0,0 +1,27 @@
+#ifndef GLYPH_ATLAS_H
+#define GLYPH_ATLAS_H
+
+#include <GL/gl.h>
+#include "quad_batch.h"
+
+// The font rasterized once into a white RGBA texture; vertex colors tint it. Cell c of a 16x8
+// grid holds character c with a clear border, so nearest sampling never picks up a neighbour.
+// Cell 0 is solid white for quads that are only a color.
+class GlyphAtlas {
+public:
+    GlyphAtlas();
+    GLuint texture(); // uploaded on first use
+    static TexRect solid();
+    static TexRect glyph(char c); // the 5x5 pixels of c
+    void shutdown(); // call while the GL context is still alive
+
+private:
+    static constexpr int CELL = 8;
+    static constexpr int COLUMNS = 16;
+    static constexpr int WIDTH = CELL * COLUMNS;
+    static constexpr int HEIGHT = CELL * 8;
+
+    GLuint id;
+};
+
+#endif // GLYPH_ATLAS_H
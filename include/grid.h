@@ -0,0 +1,98 @@
+#ifndef GRID_H
+#define GRID_H
+
+#include "types.h"
+#include <cstdint>
+#include <vector>
+
+// What occupies a cell of the logical collision grid.
+// Mirrors what the renderer would have put on screen at that spot.
+enum class CellType : uint8_t {
+    Empty = 0,    // black background, safe
+    TrailP1,      // blue line
+    TrailP2,      // red line
+    Collectible,  // green square, safe
+    CircleSafe,   // magenta circle, safe
+    CircleDanger, // yellow circle
+    HeadP1,       // player 1 square
+    HeadP2,       // player 2 square
+    Wall,         // outside the board
+    Other         // a screen color the game does not draw flat (effects, text), deadly
+};
+
+// CPU-side occupancy grid used for collision and AI queries instead of reading back the framebuffer.
+// Trails live in a persistent layer that grows as players move and is erased by circles.
+// Circles, the collectible and player heads live in an overlay that is restamped every frame.
+class CollisionGrid {
+public:
+    CollisionGrid(const GameConfig& config);
+    void resize(float orthoWidth, float orthoHeight);
+    void clear();
+    void copyFrom(const CollisionGrid& other); // keeps this grid's storage when the sizes match
+    // copyFrom for a grid that only ever copies from other: rows other has not written since
+    // the last copy are left as they are
+    void copyChangedFrom(const CollisionGrid& other);
+    void clearOwner(int owner);
+    void addTrailSegment(const Vec2& from, const Vec2& to, int owner);
+    bool eraseCircle(const Vec2& center, float radius); // true if any trail was there
+    void updateOverlay(const std::vector<Circle>& circles, const Collectible& collectible,
+                       const Player& player1, const Player& player2);
+    CellType sample(const Vec2& pos, int self = -1) const;
+    bool anyTrail(float minX, float minY, float maxX, float maxY) const; // any line in the box, drawn or not
+    bool solidTrailAt(const Vec2& pos) const; // a drawn line under pos, whatever the overlay holds
+    static bool isDeadly(CellType cell);
+    static bool isDangerToAI(CellType cell); // lines, heads and yellow circles; the AI steers around these
+    static const char* colorName(CellType cell);
+    static CellType classifyPixel(unsigned char r, unsigned char g, unsigned char b);
+
+    float getCellSize() const { return cellSize; }
+    int getCols() const { return cols; }
+    int getRows() const { return rows; }
+    const uint8_t* trailCells() const { return trail.data(); }     // row-major, for batched readers
+    const uint8_t* overlayCells() const { return overlay.data(); }
+    bool isTrailVisible(int owner) const { return trailVisible[owner]; }
+    // Writes so far, and the count as of the last write to row y. A copy keeps the numbers of the
+    // grid it copied, so readers can tell which rows moved on since they last looked.
+    uint64_t getVersion() const { return version; }
+    uint64_t getRowVersion(int y) const { return rowVersions[y]; }
+
+private:
+    struct Rect { int x0, y0, x1, y1; };
+
+    Rect cellRect(float minX, float minY, float maxX, float maxY) const;
+    void stampSegment(std::vector<uint8_t>& layer, const Vec2& from, const Vec2& to, float radius, CellType value);
+    void stampDisc(const Vec2& center, float radius, CellType value);
+    void stampRect(float minX, float minY, float maxX, float maxY, CellType value);
+    void touchRows(int y0, int y1); // rows y0..y1 of either layer were written
+
+    const GameConfig& config;
+    float cellSize;
+    int cols;
+    int rows;
+    std::vector<uint8_t> trail;   // TrailP1 / TrailP2 / Empty
+    std::vector<uint8_t> overlay; // circles, collectible, heads
+    std::vector<Rect> overlayRects; // what the overlay stamped last frame, cleared before restamping
+    bool trailVisible[2];         // invincible players' trails are not drawn, so they are not solid
+    uint64_t version;             // counts writes; a copy holds the version it copied
+    std::vector<uint64_t> rowVersions; // version of the last write to each row
+    const CollisionGrid* source;  // grid this one is a copy of, null once it is written itself
+};
+
+// Exact match on the flat colors the renderer uses. Every channel the palette uses is 0 or 255,
+// so each channel becomes 0, 1 or 2 (anything else) and one 27 entry table covers every color.
+// Pixels cannot tell a head from its line, so blue and red read as trails.
+inline CellType CollisionGrid::classifyPixel(unsigned char r, unsigned char g, unsigned char b) {
+    static constexpr CellType E = CellType::Empty, O = CellType::Other;
+    static constexpr CellType TABLE[27] = {
+        // r = 0: g = 0, 255, other; b = 0, 255, other within each
+        E, CellType::TrailP1, O,  CellType::Collectible, O, O,  O, O, O,
+        // r = 255
+        CellType::TrailP2, CellType::CircleSafe, O,  CellType::CircleDanger, O, O,  O, O, O,
+        // r = other
+        O, O, O,  O, O, O,  O, O, O
+    };
+    auto level = [](unsigned char c) { return c == 0 ? 0 : (c == 255 ? 1 : 2); };
+    return TABLE[level(r) * 9 + level(g) * 3 + level(b)];
+}
+
+#endif // GRID_H
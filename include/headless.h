@@ -0,0 +1,22 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#include <cstdint>
+#include "types.h"
+
+class Simulation;
+
+// Runs the simulation with no window, a scripted bot driving each player.
+// ./linesplus --headless [ticks] [seed]
+int runHeadless(const GameConfig& config, long ticks, uint32_t seed);
+
+// Plays matches of the AI against itself, or against the scripted bot in slot 0, on every
+// core at once, each match from its own seed and for the given ticks. Prints win rates, round
+// lengths and what each side's decisions cost.
+// ./linesplus --tournament [matches] [ticks] [seed] [ai|bot]
+int runTournament(const GameConfig& config, int matches, long ticks, uint32_t seed, bool versusBot);
+
+// Steers toward the green square and away from walls, circles and trails; no randomness
+InputFrame scriptedBotInput(const Simulation& sim, int slot);
+
+#endif // HEADLESS_H
@@ -0,0 +1,77 @@
+#ifndef LOOKAHEAD_H
+#define LOOKAHEAD_H
+
+#include "types.h"
+#include "distance_field.h"
+#include "thread_pool.h"
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+class Simulation;
+
+// Search AI for AI_MODE=1. Each candidate plan holds one steering level for the first third of
+// AI_SEARCH_HORIZON and another for the second; rollouts play the plan forward on a light copy
+// of the board (the two heads, the circles and the collectible moving, the trails frozen) with a
+// random last third and a random opponent, and score how it went. Rollouts are spread over the
+// pool and stop at AI_SEARCH_BUDGET_MS or the caller's deadline, whichever is sooner; the first
+// round always finishes so there is an answer.
+class Lookahead {
+public:
+    struct Result {
+        float steer;  // right trigger minus left trigger to hold now, -1..1
+        float score;  // mean rollout score of the plan picked
+        int rollouts; // rollouts finished in time
+        bool trapped; // every rollout of every plan crashed
+    };
+
+    explicit Lookahead(const GameConfig& config);
+
+    // self is the AI's player slot. solid says whether a trail kills at a spot; it is asked
+    // from several threads at once. field, when given, adds clearance from trails to the score.
+    Result search(const Simulation& sim, int self, const std::function<bool(const Vec2&)>& solid,
+                  const DistanceField* field, ThreadPool& pool, uint32_t seed,
+                  std::chrono::steady_clock::time_point until = std::chrono::steady_clock::time_point::max());
+
+private:
+    struct Body {
+        Vec2 pos;
+        Vec2 vel;
+        float radius;
+        float yellowIn; // seconds until it turns yellow, 0 once it is
+    };
+
+    float rollout(int plan, int round, bool& crashed) const;
+
+    const GameConfig& config;
+    // The scene being searched, valid during search()
+    const std::function<bool(const Vec2&)>* solid;
+    const DistanceField* field;
+    std::vector<Body> bodies;
+    Vec2 selfPos, selfDir;
+    Vec2 otherPos, otherDir;
+    bool otherAlive;
+    float otherTurnRate; // radians per second at full trigger
+    float shieldTime;    // seconds the AI's own invincibility has left
+    Vec2 goalPos;
+    float goalHalf;
+    bool goalActive;
+    float width, height;
+    float stepDt;
+    int steps;
+    uint32_t seed;
+    std::chrono::steady_clock::time_point deadline;
+    bool timed;
+    std::vector<float> scores;     // [round * PLANS + plan]
+    std::vector<uint8_t> finished; // the same, NOT_RUN, SURVIVED or CRASHED
+
+    static constexpr int LEVELS = 5; // steering levels a plan segment can hold
+    static constexpr int PLANS = LEVELS * LEVELS;
+    static constexpr int ROLLOUT_TICKS = 2; // game ticks per rollout step
+    static constexpr uint8_t NOT_RUN = 0;
+    static constexpr uint8_t SURVIVED = 1;
+    static constexpr uint8_t CRASHED = 2;
+};
+
+#endif // LOOKAHEAD_H
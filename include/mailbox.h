@@ -0,0 +1,42 @@
+#ifndef MAILBOX_H
+#define MAILBOX_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// Single producer, single consumer, latest value wins (a triple buffer).
+// The producer fills back() and publish()es it; the consumer calls fetch() and reads front().
+// Neither side waits for the other: a value the consumer never fetched is simply overwritten.
+template <typename T>
+class Mailbox {
+public:
+    // make() builds each of the three slots, so T needs no default constructor
+    template <typename Make>
+    explicit Mailbox(Make make) : slots{{make(), make(), make()}}, middle(1), backIndex(0), frontIndex(2) {}
+
+    T& back() { return slots[backIndex]; }
+    void publish() {
+        backIndex = middle.exchange(backIndex | FRESH, std::memory_order_acq_rel) & INDEX;
+    }
+
+    bool hasNew() const { return (middle.load(std::memory_order_acquire) & FRESH) != 0; }
+    // Swap in the newest published value; false when nothing new arrived since the last fetch
+    bool fetch() {
+        if (!hasNew()) return false;
+        frontIndex = middle.exchange(frontIndex, std::memory_order_acq_rel) & INDEX;
+        return true;
+    }
+    T& front() { return slots[frontIndex]; }
+
+private:
+    static constexpr uint32_t INDEX = 3u;
+    static constexpr uint32_t FRESH = 4u;
+
+    std::array<T, 3> slots;
+    std::atomic<uint32_t> middle; // slot between the two sides, FRESH when the producer left a new value
+    uint32_t backIndex;           // producer only
+    uint32_t frontIndex;          // consumer only
+};
+
+#endif // MAILBOX_H
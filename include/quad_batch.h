@@ -0,0 +1,44 @@
+#ifndef QUAD_BATCH_H
+#define QUAD_BATCH_H
+
+#include "gl_ext.h"
+#include <SDL2/SDL.h>
+#include <cstdint>
+#include <vector>
+
+// Where a quad samples its texture, in texture coordinates
+struct TexRect {
+    float u0, v0, u1, v1;
+};
+
+struct QuadVertex {
+    float x, y;
+    float u, v;
+    uint8_t r, g, b, a;
+};
+
+// Textured, colored axis-aligned quads collected over a frame and drawn with one
+// glDrawArrays(GL_QUADS) from a streaming vertex buffer. Plain squares sample an opaque texel,
+// so squares and glyphs share the draw. Anything else drawn in between must flush() first so
+// the painter's order stays the same. The game runs with a single blend state, so a flush is one draw.
+class QuadBatch {
+public:
+    QuadBatch();
+    void add(float x, float y, float width, float height, const SDL_Color& color, const TexRect& tex);
+    std::vector<QuadVertex>& pending() { return vertices; } // append whole quads, four vertices each
+    int flush(GLuint texture); // draws what was added, returns the draw calls issued
+    void shutdown(); // call while the GL context is still alive
+
+    static void appendQuad(std::vector<QuadVertex>& out, float x, float y, float width, float height,
+                           const SDL_Color& color, const TexRect& tex);
+    // Point the vertex, texture and color arrays at the bound GL_ARRAY_BUFFER of QuadVertex
+    static void enableArrays();
+    static void disableArrays();
+
+private:
+    std::vector<QuadVertex> vertices;
+    GLuint vbo;
+    size_t capacity; // vertices the buffer object holds
+};
+
+#endif // QUAD_BATCH_H
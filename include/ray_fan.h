@@ -0,0 +1,51 @@
+#ifndef RAY_FAN_H
+#define RAY_FAN_H
+
+#include "types.h"
+#include "grid.h"
+#include "distance_field.h"
+
+class Simulation;
+
+// Rays from the AI through the collision grid, many at once. cast() marches LANES rays per
+// pass in SSE2 registers, or AVX2 when the compiler targets it, and a ray leaves the pass as
+// soon as it hits something. Every ray reads the grid like Simulation::sample does for the AI
+// and steps like checkLine: 2 units at a time, or further when clearDistance says nothing
+// can be hit sooner.
+class RayFan {
+public:
+    struct Hit {
+        float distance; // maxDistance when nothing was hit
+        CellType cell;  // Wall, Collectible, a danger, or Empty
+    };
+
+    RayFan();
+
+    // Take this decision's scene; self is the AI's player slot
+    void prepare(const Simulation& sim, const DistanceField& field, float berth, int self);
+    // How far from pos no danger or collectible can start, measured from the grid cells
+    float clearDistance(const Vec2& pos) const;
+    float wallExit(const Vec2& start, const Vec2& dir) const; // where a ray leaves the berth box, plus a hair
+    // dirs must be unit length; out gets one hit per ray
+    void cast(const Vec2& start, const Vec2* dirs, int count, float maxDistance, Hit* out) const;
+
+    static const int LANES;
+    static constexpr float STEP_SIZE = 2.0f;
+
+private:
+    struct Box { float x, y, half; };
+
+    CellType classify(size_t index) const;
+    void castOne(const Vec2& start, const Vec2& dir, float maxDistance, Hit& out) const;
+
+    const CollisionGrid* grid;
+    const DistanceField* field;
+    float minX, minY, maxX, maxY; // the berth box
+    Box boxes[2];                 // collectible and the other head, not in the distance field
+    int boxCount;
+    uint8_t ownHead;              // CellType of the AI's head, which it never hits
+    float circleSlack;            // circle distances are between cell centres
+    float boxSlack;               // grid rects cover whole cells
+};
+
+#endif // RAY_FAN_H
@@ -0,0 +1,46 @@
+#ifndef READBACK_H
+#define READBACK_H
+
+#include "gl_ext.h"
+#include <vector>
+#include "types.h"
+
+// Reads the screen back for pixel collision (COLLISION_MODE=1).
+// With READBACK_BUFFERS=2 or 3 the read goes into a ring of pixel buffer objects and
+// the frame read READBACK_BUFFERS-1 frames ago is mapped, so the CPU never waits on the GPU.
+// With READBACK_BUFFERS=0 it is a plain glReadPixels into storage that is kept between frames.
+// With READBACK_ROI=1 only the tiles covering regions added this frame are read; the rest of the
+// buffer keeps older pixels that nobody samples.
+class ReadbackManager {
+public:
+    ReadbackManager(const GameConfig& config);
+    void addRegion(float minX, float minY, float maxX, float maxY); // ortho units, for the next readFrame
+    PixelSnapshot readFrame(int drawableWidth, int drawableHeight, float orthoWidth, float orthoHeight);
+    void release();  // call once players and AI are done with the snapshot
+    void shutdown(); // call while the GL context is still alive
+    size_t getBytesLastFrame() const { return bytesLastFrame; }
+
+private:
+    static constexpr int MAX_BUFFERS = 3;
+    static constexpr int TILE_SIZE = 64; // pixels
+
+    struct Region { float minX, minY, maxX, maxY; };
+
+    void allocate(int drawableWidth, int drawableHeight);
+    void readRegions(unsigned char* dest, float orthoWidth, float orthoHeight);
+
+    const GameConfig& config;
+    int bufferCount;  // 0 means synchronous
+    GLuint pbos[MAX_BUFFERS];
+    int writeIndex;
+    int framesQueued; // reads issued since the ring was (re)allocated
+    int mappedIndex;  // -1 when nothing is mapped
+    int width;
+    int height;
+    std::vector<unsigned char> pixels; // synchronous path
+    std::vector<Region> regions;        // requested since the last readFrame
+    std::vector<uint8_t> tileMask;      // tiles to read this frame
+    size_t bytesLastFrame;
+};
+
+#endif // READBACK_H
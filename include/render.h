@@ -3,7 +3,16 @@
 
 #include <GL/gl.h>
 #include "types.h"
+#include "ai_profiler.h"
+#include "circle_batch.h"
+#include "glyph_atlas.h"
+#include "quad_batch.h"
+#include "text_cache.h"
+#include "trail_buffer.h"
+#include "trail_layer.h"
+#include <array>
 #include <string>
+#include <string_view>
 #include <SDL2/SDL.h>
 
 // Forward declaration of Game struct
@@ -12,21 +21,47 @@ struct Game;
 class RenderManager {
 public:
     RenderManager(const GameConfig& config);
-    void renderSplashScreen(GLuint texture) const;
-    void renderGame(const Game& game, float currentTimeSec) const;
-    void renderGameOver(const Game& game, float orthoWidth, float orthoHeight) const;
-    void drawCircle(float x, float y, float radius, const SDL_Color& color) const;
-	void drawBlackCircle(float x, float y, float radius) const;
-    void drawTrail(const Player& player, int skipRecent = 0) const;
-    void drawText(const std::string& text, float x, float y, float squareSize, const SDL_Color& color) const;
+    void renderSplashScreen(GLuint texture);
+    void renderGame(const Game& game, float currentTimeSec, float alpha); // alpha: 0 draws the previous tick, 1 the latest
+    void renderGameOver(const Game& game, float orthoWidth, float orthoHeight);
+    void drawCircle(float x, float y, float radius, const SDL_Color& color); // black underneath, then color
+	void drawBlackCircle(float x, float y, float radius);
+    void drawTrail(const Player& player, int slot); // slot picks the player's vertex buffer
+    void drawText(std::string_view text, float x, float y, float squareSize, const SDL_Color& color); // cached mesh
+    void drawAIStats(const AIProfiler& profiler, float x, float y);
+    void shutdown(); // call while the GL context is still alive
+    int getDrawCalls() const { return drawCallsLastFrame; } // in the last finished frame
 
 private:
-    void drawSquare(float x, float y, float size, const SDL_Color& color) const;
-    void drawExplosion(const Explosion& explosion, float currentTimeSec) const;
-    void drawPlayer(const Player& player) const;
-    void drawCollectibleGreenSquare(const Collectible& collectible) const;
+    // HUD strings built from numbers, rebuilt only when the numbers change
+    enum Label { SCORE, SETS1, SETS2, ROUND, COUNTDOWN, LABEL_COUNT };
+    struct LabelText {
+        int a, b;
+        bool built;
+        std::string text;
+    };
+
+    const std::string& label(Label id, int a, int b = 0);
+    void batchText(std::string_view text, float x, float y, float squareSize, const SDL_Color& color); // for text that changes every frame
+    void flushQuads();
+    void flushCircles();
+    void drawSquare(float x, float y, float size, const SDL_Color& color);
+    void drawExplosion(const Explosion& explosion, float currentTimeSec);
+    void drawPlayer(const Player& player, float alpha);
+    void drawCollectibleGreenSquare(const Collectible& collectible);
+    void beginFrame();
+    void endFrame();
 
     const GameConfig& config;
+    TrailBuffer trailBuffers[2];
+    TrailLayer trailLayer;    // trails drawn once and touched up, when the driver allows
+    QuadBatch quads;          // squares, particles and text, flushed before anything else draws
+    CircleBatch circles;      // only one of quads and circles holds anything at a time
+    GlyphAtlas atlas;
+    TextCache textCache;
+    std::array<LabelText, LABEL_COUNT> labels;
+    int drawCalls;            // this frame so far
+    int drawCallsLastFrame;
 };
 
 #endif // RENDER_H
\ No newline at end of file
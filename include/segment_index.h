@@ -0,0 +1,81 @@
+#ifndef SEGMENT_INDEX_H
+#define SEGMENT_INDEX_H
+
+#include "types.h"
+#include <cstdint>
+#include <vector>
+
+// Uniform grid of buckets over every trail segment on the board.
+// A segment is listed in each cell its TRAIL_SIZE wide stroke touches, so head, circle and
+// line of sight queries only look at segments in the cells they cover.
+// Simulation::extendTrail and CircleManager::clearTrails keep it in step with the players' Trails.
+class SegmentIndex {
+public:
+    static constexpr uint32_t NO_ENTRY = 0xFFFFFFFFu;
+
+    struct Entry {
+        Vec2 a;
+        Vec2 b;
+        uint32_t tick; // when the segment was added or last stretched
+        uint32_t slot; // where it lives in its owner's Trail
+        uint8_t owner; // 0 or 1
+        bool live;
+        bool unswept;  // added or grown since the circles last swept
+    };
+
+    struct RayHit {
+        float distance; // maxDistance when nothing was hit
+        int owner;      // -1 when nothing was hit
+    };
+
+    SegmentIndex(const GameConfig& config);
+    void resize(float orthoWidth, float orthoHeight);
+    void clear();
+    void copyFrom(const SegmentIndex& other); // keeps this index's storage where it can
+    uint32_t insert(const Vec2& a, const Vec2& b, int owner, uint32_t slot, uint32_t tick);
+    void stretch(uint32_t id, const Vec2& newEnd, uint32_t tick); // b moved on along the segment's line
+    void reshape(uint32_t id, const Vec2& a, const Vec2& b);      // a circle cut it shorter
+    void remove(uint32_t id);
+    void removeOwner(int owner);
+    const Entry& entry(uint32_t id) const { return entries[id]; }
+    size_t size() const { return liveCount; }
+
+    // Live segments whose stroke may reach into the circle now at center, each listed once.
+    // When swept is set the circle was already erased at prevCenter, so cells it covered there are
+    // skipped: old segments in them were cut then, and newer ones are listed from the unswept set.
+    void querySwept(const Vec2& prevCenter, const Vec2& center, float radius, bool swept, std::vector<uint32_t>& out);
+    void finishSweep(); // every circle has been swept, start a new unswept set
+    // Owner of a stroke under pos whose owner bit is set in solidMask, or -1.
+    // Segments of player self changed at or after selfSinceTick do not count.
+    int ownerAt(const Vec2& pos, uint32_t solidMask, int self = -1, uint32_t selfSinceTick = 0) const;
+    // Live segments whose stroke may reach into the box, each listed once
+    void queryBox(float minX, float minY, float maxX, float maxY, std::vector<uint32_t>& out) const;
+    // First stroke of a solid owner along the ray; dir must be normalized
+    RayHit raycast(const Vec2& start, const Vec2& dir, float maxDistance, uint32_t solidMask) const;
+
+private:
+    static constexpr float ROUNDING_SLACK = 0.01f; // units, see removeFromCells
+
+    struct CellRange { int x0, y0, x1, y1; };
+
+    CellRange cellRange(float minX, float minY, float maxX, float maxY) const;
+    void addToCells(uint32_t id, const Vec2& a, const Vec2& b);
+    void removeFromCells(uint32_t id, const Vec2& a, const Vec2& b);
+    bool strokeTouchesCell(const Vec2& a, const Vec2& b, float reach, int cx, int cy) const;
+    void markUnswept(uint32_t id);
+
+    const GameConfig& config;
+    float cellSize;
+    float halfWidth; // half the drawn trail width
+    int cols;
+    int rows;
+    std::vector<std::vector<uint32_t>> cells;
+    std::vector<Entry> entries;
+    std::vector<uint32_t> freeEntries;
+    std::vector<uint32_t> unswept; // ids added or grown since finishSweep, may hold dead ids
+    std::vector<uint32_t> queryStamp; // per entry, to list each segment once per query
+    uint32_t queryCounter;
+    size_t liveCount;
+};
+
+#endif // SEGMENT_INDEX_H
@@ -0,0 +1,108 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <vector>
+#include <random>
+#include <cstdint>
+#include "types.h"
+#include "grid.h"
+#include "segment_index.h"
+#include "collectible.h"
+#include "circle.h"
+#include "explosion.h"
+#include "player.h"
+
+// Things that happened during a step, for the game to play sounds
+enum SimEvent : uint32_t {
+    SIM_EVENT_BOOP = 1u << 0,      // green square collected
+    SIM_EVENT_EXPLOSION = 1u << 1, // somebody crashed
+    SIM_EVENT_LASER_ZAP = 1u << 2, // invincibility started or ended
+    SIM_EVENT_WINNER = 1u << 3     // somebody won the set
+};
+
+// A box on the board where something changed
+struct ChangedArea {
+    float minX, minY, maxX, maxY;
+};
+
+// The game rules with no window, GL context or wall clock.
+// Players, circles, the collectible, scoring and explosions advance one fixed tick per step()
+// from an InputFrame, so the same seed and the same inputs always play the same round.
+class Simulation {
+public:
+    Simulation(const GameConfig& config, uint32_t seed);
+    void reset(bool clearScores);
+    void step(const InputFrame& input, float tickDt, const PixelSnapshot& framebuffer = PixelSnapshot(),
+              int drawableWidth = 0, int drawableHeight = 0);
+    void advanceClock(float dt); // time passes without simulating (game over screen), effects keep animating
+    void checkCollision(Player* player, Vec2 nextPos, const PixelSnapshot& framebuffer, int drawableWidth, int drawableHeight);
+    void handleGreenSquareCollection(Player* player);
+    void handlePlayerDeath(Player* player);
+    void activateNoCollision(Player* player);
+    void extendTrail(Player* player);
+    void clearTrail(Player* player);
+    CellType sample(const Vec2& pos, int self = -1) const; // what is drawn at pos, from the grid or the trail segments
+    bool solidTrailAt(const Vec2& pos, int self = -1) const; // a line that kills at pos, from the grid or the segments
+    uint32_t solidTrailMask() const; // bit per player whose trail kills (invincible players' trails do not)
+    void respawnCircles();
+    bool shouldRespawnPlayer(const Player* player) const {
+        return !player->alive && (time - deathTime >= 2.0f);
+    }
+    Vec2 getSpawnPosition() const {
+        return Vec2(orthoWidth / 2, orthoHeight / 2);
+    }
+    int playerIndex(const Player* player) const { return player == &player1 ? 0 : 1; }
+    uint64_t checksum() const;
+    // Copy what can be seen on the board: heads, circles, the collectible and the collision
+    // structure COLLISION_MODE uses. Trails, scores and effects are left alone.
+    void copyWorldFrom(const Simulation& other);
+    // Trails drawn, cleared or erased by circles, for planners that repair their search instead of
+    // starting over. CircleManager::clearTrails lists the box around each circle that erased any.
+    void noteTrailChange(float minX, float minY, float maxX, float maxY);
+    void dropTrailChanges(uint64_t upTo); // everything before sequence number upTo has been read
+
+    const GameConfig& config;
+    CollectibleManager collectibleManager;
+    CircleManager circleManager;
+    ExplosionManager explosionManager;
+    PlayerManager playerManager;
+    CollisionGrid collisionGrid;
+    SegmentIndex segmentIndex;
+    Player player1;
+    Player player2;
+    std::vector<Circle> circles;
+    Collectible collectible;
+    std::vector<Explosion> explosions;
+    std::vector<Flash> flashes;
+    std::mt19937 rng;
+    bool aiControlled[2]; // AI players steer with AI_TURN_SPEED and keep AI_BERTH off the walls
+    int score1;
+    int score2;
+    int roundScore1;
+    int roundScore2;
+    int setScore1;
+    int setScore2;
+    float time;        // seconds of simulated play
+    uint64_t tick;
+    uint64_t roundStartTick; // tick the current round began on
+    float tickDt;      // length of the tick being stepped
+    float lastCircleSpawn;
+    float deathTime;
+    float orthoWidth;
+    float orthoHeight;
+    float winningScore;
+    float greenSquarePoints;
+    float deathPoints;
+    bool roundOver;    // somebody died, call reset() for the next round
+    int setWinner;     // 1 or 2 when the last step won the set, else 0
+    uint32_t events;   // SimEvent bits raised by the last step
+    std::vector<ChangedArea> trailChanges; // oldest first
+    uint64_t trailChangeBase;              // sequence number of trailChanges[0]
+
+private:
+    void update();
+    bool collectibleCollectedThisFrame;
+    bool pendingCollectibleRespawn;
+};
+
+#endif // SIMULATION_H
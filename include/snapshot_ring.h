@@ -0,0 +1,109 @@
+#ifndef SNAPSHOT_RING_H
+#define SNAPSHOT_RING_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+// One producer publishes snapshots and any number of readers take the latest one as a Ref,
+// which stays valid and unchanged for as long as they hold it. There are SLOTS snapshots that
+// get reused: the producer only claims a slot that is not the latest and that no reader holds,
+// so nobody waits and nobody reads a slot while it is written. A reused slot still holds what
+// it was last filled with, so the producer can update only what changed.
+// Neither side locks or allocates. A reader counts itself into the latest slot and then checks
+// that it is still the latest, as the same publish; if not, the producer may have claimed the
+// slot before the count went up, so the reader backs out and tries the new latest.
+template <typename T>
+class SnapshotRing {
+    struct Slot;
+
+public:
+    static constexpr int SLOTS = 3;
+
+    // A held snapshot, empty before the first publish()
+    class Ref {
+    public:
+        Ref() : slot(nullptr) {}
+        Ref(Ref&& other) noexcept : slot(other.slot) { other.slot = nullptr; }
+        Ref& operator=(Ref&& other) noexcept {
+            std::swap(slot, other.slot);
+            return *this;
+        }
+        ~Ref() {
+            if (slot) slot->readers.fetch_sub(1, std::memory_order_release);
+        }
+        explicit operator bool() const { return slot != nullptr; }
+        const T& operator*() const { return slot->value; }
+        const T* operator->() const { return &slot->value; }
+
+    private:
+        friend class SnapshotRing;
+        explicit Ref(Slot* slot) : slot(slot) {}
+        Slot* slot;
+    };
+
+    // make() builds each slot, so T needs no default constructor
+    template <typename Make>
+    explicit SnapshotRing(Make make) : slots(), latestWord(0), claimedIndex(-1) {
+        for (auto& slot : slots) {
+            slot.reset(new Slot{make(), {0}});
+        }
+    }
+
+    // Producer: a slot to fill, nullptr while readers hold every slot but the latest
+    T* claim() {
+        int latestIndex = indexOf(latestWord.load(std::memory_order_relaxed));
+        claimedIndex = -1;
+        for (int i = 0; i < SLOTS; ++i) {
+            if (i != latestIndex && slots[i]->readers.load(std::memory_order_seq_cst) == 0) {
+                claimedIndex = i;
+                break;
+            }
+        }
+        return claimedIndex >= 0 ? &slots[claimedIndex]->value : nullptr;
+    }
+    // Producer: the claimed slot becomes the latest
+    void publish() {
+        if (claimedIndex < 0) return;
+        uint64_t word = latestWord.load(std::memory_order_relaxed);
+        latestWord.store(((word >> INDEX_BITS) + 1) << INDEX_BITS | static_cast<uint64_t>(claimedIndex),
+                         std::memory_order_seq_cst);
+        claimedIndex = -1;
+    }
+
+    // Any thread: the newest snapshot and its sequence number, empty before the first publish()
+    Ref latest(uint64_t* publishedAs = nullptr) {
+        uint64_t word = latestWord.load(std::memory_order_seq_cst);
+        while (true) {
+            if (publishedAs) *publishedAs = word >> INDEX_BITS;
+            if (word == 0) return Ref();
+            Slot* slot = slots[indexOf(word)].get();
+            slot->readers.fetch_add(1, std::memory_order_seq_cst);
+            uint64_t now = latestWord.load(std::memory_order_seq_cst);
+            if (now == word) return Ref(slot);
+            slot->readers.fetch_sub(1, std::memory_order_release);
+            word = now;
+        }
+    }
+    uint64_t published() const { return latestWord.load(std::memory_order_acquire) >> INDEX_BITS; }
+
+private:
+    static constexpr int INDEX_BITS = 2;
+
+    struct Slot {
+        T value;
+        std::atomic<int> readers;
+    };
+
+    static int indexOf(uint64_t word) {
+        return word == 0 ? -1 : static_cast<int>(word & ((uint64_t(1) << INDEX_BITS) - 1));
+    }
+
+    std::array<std::unique_ptr<Slot>, SLOTS> slots;
+    std::atomic<uint64_t> latestWord; // publish count above INDEX_BITS, latest slot below; 0 before any
+    int claimedIndex;                 // producer only, between claim() and publish()
+};
+
+#endif // SNAPSHOT_RING_H
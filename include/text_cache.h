@@ -0,0 +1,48 @@
+#ifndef TEXT_CACHE_H
+#define TEXT_CACHE_H
+
+#include "gl_ext.h"
+#include <SDL2/SDL.h>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "quad_batch.h"
+
+// Text meshes kept in vertex buffers by string, size and color, so text that stays the same
+// from frame to frame is one draw and no vertex work. A mesh not drawn for KEEP_FRAMES frames
+// is dropped.
+class TextCache {
+public:
+    TextCache();
+    // Top left at x, y; returns the draw calls issued
+    int draw(std::string_view text, float x, float y, float squareSize, const SDL_Color& color, GLuint texture);
+    void endFrame();
+    void shutdown(); // call while the GL context is still alive
+
+    // One quad per character; characters the font lacks are skipped and take no space
+    static void buildMesh(std::string_view text, float x, float y, float squareSize, const SDL_Color& color,
+                          std::vector<QuadVertex>& out);
+
+private:
+    static constexpr uint64_t KEEP_FRAMES = 120;
+
+    struct Mesh {
+        std::string text;
+        float squareSize;
+        uint32_t color;
+        GLuint vbo;
+        GLsizei vertices;
+        uint64_t lastDrawn;
+    };
+
+    static uint32_t packColor(const SDL_Color& color);
+    static uint64_t keyOf(std::string_view text, float squareSize, uint32_t color);
+
+    std::unordered_map<uint64_t, Mesh> meshes;
+    std::vector<QuadVertex> scratch;
+    uint64_t frame;
+};
+
+#endif // TEXT_CACHE_H
@@ -0,0 +1,51 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A few long-lived helper threads for splitting one job into independent pieces.
+// parallelFor deals the piece numbers out in runs, one per thread with the calling thread
+// taking the first, and returns once every piece is done. A thread that finishes its run
+// steals the back half of the busiest-looking one, so uneven pieces still finish together
+// and pieces next to each other mostly stay on one thread. With no helpers it simply runs
+// the pieces in order.
+class ThreadPool {
+public:
+    explicit ThreadPool(int helpers);
+    ~ThreadPool();
+    int size() const { return static_cast<int>(workers.size()) + 1; } // threads that work on a job
+    void parallelFor(int count, const std::function<void(int)>& fn);
+
+private:
+    // Pieces [begin, end) still waiting in one thread's run; the owner takes from the front,
+    // thieves from the back
+    struct alignas(64) Run {
+        std::mutex lock;
+        int begin = 0;
+        int end = 0;
+    };
+
+    void workerLoop(int index);
+    void runPieces(int index);
+    bool takeOwn(int index, int& piece);
+    bool steal(int index);
+
+    std::vector<std::thread> workers;
+    std::vector<std::unique_ptr<Run>> runs; // runs[0] is the calling thread's
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    const std::function<void(int)>* job;
+    int busy;             // helpers still on the current job
+    uint64_t generation;  // bumped per job so helpers see each one once
+    bool stopping;
+};
+
+#endif // THREAD_POOL_H
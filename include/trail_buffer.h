@@ -0,0 +1,41 @@
+#ifndef TRAIL_BUFFER_H
+#define TRAIL_BUFFER_H
+
+#include "gl_ext.h"
+#include <cstdint>
+#include <vector>
+#include "types.h"
+
+// One player's trail in a vertex buffer, drawn with a single glDrawArrays(GL_LINES).
+// Each frame only the slots the trail logged since the last draw are written: new segments go
+// on the end and a stretched tip is rewritten in place. An erased segment is filled with the
+// last one, so the buffer stays packed. Each run of written segments gets its own
+// glBufferSubData, so a hole filled near the front does not send everything up to the tip.
+class TrailBuffer {
+public:
+    TrailBuffer();
+    void draw(const Trail& trail);
+    void shutdown(); // call while the GL context is still alive
+
+private:
+    static constexpr int FLOATS_PER_SEGMENT = 4; // two x,y vertices
+    static constexpr int32_t ABSENT = -1;
+    static constexpr size_t MERGE_GAP = 16; // clean segments cheaper to resend than to split a run over
+
+    void rebuild(const Trail& trail);
+    void apply(const Trail& trail, size_t slot);
+    void write(size_t position, const TrailSegment& segment);
+    void upload();
+
+    GLuint vbo;
+    size_t capacity;                     // segments the buffer object holds
+    std::vector<float> vertices;         // what the buffer should hold, packed
+    std::vector<int32_t> positionOfSlot; // where each trail slot sits in vertices, or ABSENT
+    std::vector<uint32_t> slotAt;        // the trail slot at each position
+    const Trail* synced;                 // the trail vertices mirrors
+    uint64_t seen;                       // edits of it already applied
+    std::vector<uint32_t> dirty;         // positions written since the last upload, unsorted
+    bool dirtyAll;                       // upload every segment instead
+};
+
+#endif // TRAIL_BUFFER_H
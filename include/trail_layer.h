@@ -0,0 +1,72 @@
+#ifndef TRAIL_LAYER_H
+#define TRAIL_LAYER_H
+
+#include "gl_ext.h"
+#include <cstdint>
+#include <vector>
+#include "types.h"
+#include "trail_buffer.h"
+
+class Simulation;
+
+// Both trails kept drawn in a texture the size of the screen, behind a framebuffer object.
+// Each segment the trail edit logs list this frame, as it was drawn and as it is now, marks the
+// TILE pixel tiles its stroke covers. Marked tiles are cleared (scissored) and redrawn from the
+// segment index, player one's segments then player two's, as a full redraw leaves them.
+// Whole segments are marked: the rasterizer snaps line ends to subpixels, so stretching the tip
+// can move a pixel on its edge anywhere along it. Runs of marked tiles in neighbouring rows are
+// repaired as one box while at least half of it is marked; a repair leaves what a full redraw
+// would, so clean tiles inside the box come out the same. So a frame costs the segments that
+// changed and not how long the trails are. The layer is then drawn over the screen as one quad.
+// A trail that was cleared, fell behind its edit log or turned visible or hidden redraws
+// everything, as do too many tiles.
+class TrailLayer {
+public:
+    explicit TrailLayer(const GameConfig& config);
+    // Bring the layer up to date; false when there is no layer and trails must be drawn directly
+    bool update(const Simulation& sim, int drawableWidth, int drawableHeight, TrailBuffer* buffers, int& drawCalls);
+    void composite(int& drawCalls) const; // after a successful update()
+    void shutdown(); // call while the GL context is still alive
+
+private:
+    static constexpr int TILE = 32; // pixels
+
+    struct Drawn {
+        const Trail* trail;
+        uint64_t seen;                   // edits of the trail already drawn
+        bool visible;
+        std::vector<TrailSegment> slots; // each slot as it was drawn
+    };
+    struct Box {
+        int x0, y0, x1, y1; // tiles, inclusive
+        int marked;         // tiles in it that were marked
+        bool grown;         // took a run from the row being scanned
+    };
+
+    bool allocate(int drawableWidth, int drawableHeight);
+    void noteEdit(Drawn& drawn, const Trail& trail, size_t slot);
+    void markSegment(const Vec2& a, const Vec2& b);
+    void redraw(const Simulation& sim, TrailBuffer* buffers, int& drawCalls);
+    void repair(const Simulation& sim, int x0, int y0, int x1, int y1, int& drawCalls); // pixels from the top left
+
+    const GameConfig& config;
+    GLuint framebuffer;
+    GLuint texture;
+    int width;
+    int height;
+    bool unsupported;  // TRAIL_LAYER=0, or the driver would not make a complete framebuffer
+    float orthoWidth;  // the board the layer was drawn for
+    float orthoHeight;
+    Drawn players[2];
+    int tilesX;
+    int tilesY;
+    float reach;                  // pixels a stroke reaches past its line, rounding included
+    std::vector<uint8_t> dirty;   // per tile, to repair this frame
+    size_t dirtyCount;
+    std::vector<uint32_t> hits;   // segment index query
+    std::vector<float> lines;     // x, y per vertex for one owner's segments over a box of tiles
+    std::vector<Box> boxes;       // boxes reaching down to the row above the one being scanned
+    std::vector<Box> grownBoxes;
+};
+
+#endif // TRAIL_LAYER_H
@@ -9,7 +9,6 @@
 #include <memory>
 
 class AudioManager;
-extern float dt; // Declare delta time for other files
 
 // do not change these, use game.ini
 // game.ini will overwrite any changes
@@ -19,7 +18,7 @@ struct GameConfig {
     float PLAYER_SPEED = 200.0f;
     float AI_SPEED = 200.0f;
     float TURN_SPEED = 2.0f * M_PI;
-    float AI_TURN_SPEED = 180.0f;
+    float AI_TURN_SPEED = 180.0f; // degrees per second
 	float AI_BERTH=10.0f;
     float RAYCAST_STEP = 5.0f;
     float CIRCLE_SPEED = 100.0f;
@@ -42,6 +41,26 @@ struct GameConfig {
     float COLLECT_COOLDOWN = 0.5f;
     float FLASH_COOLDOWN = 2.5f;
     float CIRCLE_SPAWN_INTERVAL = 5.0f;
+    int COLLISION_MODE = 0; // 0 = collision grid, 1 = framebuffer pixels, 2 = trail segments (geometric)
+    float GRID_CELL_SIZE = 2.0f;
+    float SEGMENT_INDEX_CELL_SIZE = 32.0f; // buckets of the trail segment index
+    int READBACK_BUFFERS = 3; // pixel collision: 0 = synchronous read, 2-3 = pixel buffer ring
+    bool READBACK_ROI = true; // pixel collision: read only around heads and what the AI looks at
+    bool TRAIL_LAYER = true;  // keep trails in an offscreen texture and redraw only what changed
+    float TICK_RATE = 120.0f; // simulation steps per second, independent of the display
+    int MAX_SUBSTEPS = 8;     // steps allowed to catch up after a slow frame
+    bool AI_WORKER = true;    // the AI thinks on its own thread while the game draws
+    int AI_ASTAR_BUDGET = 20000; // most points one path search expands, 0 = no limit
+    float DISTANCE_FIELD_CELL_SIZE = 4.0f; // AI clearance map resolution, 0 = test circles and lines directly
+    int AI_THREADS = 2;       // helper threads for AI work that splits up, 0 = none
+    int AI_MODE = 0;          // 0 = heuristic steering, 1 = lookahead search over rollouts
+    float AI_SEARCH_HORIZON = 0.6f;   // seconds each lookahead rollout plays ahead
+    float AI_SEARCH_BUDGET_MS = 4.0f; // wall time one lookahead decision may take, 0 = run every rollout
+    int AI_SEARCH_ROLLOUTS = 16;      // most rollouts per candidate plan
+    float AI_TERRITORY_CELL_SIZE = 8.0f; // cells of the who-gets-there-first map, 0 = not used
+    int AI_DIFFICULTY = 0;    // 1 easy, 2 normal, 3 hard, 4 unlimited; 0 = AI_DECISION_BUDGET_US and AI_ASTAR_BUDGET
+    float AI_DECISION_BUDGET_US = 0.0f; // wall time one decision may take before it stops refining, 0 = no limit
+    bool AI_PROFILE = false;  // time the AI's phases from the start and write ai_profile.csv at exit
 	};
 
 struct Vec2 {
@@ -65,13 +84,70 @@ struct Vec2 {
     Vec2& operator+=(const Vec2& other) { x += other.x; y += other.y; return *this; }
 };
 
+struct TrailSegment {
+    Vec2 a;
+    Vec2 b;
+    uint32_t indexId; // this segment's entry in the SegmentIndex
+    bool live;        // false for a free slot
+};
+
+// A player's trail as straight segments. Points that continue the last segment in a straight
+// line stretch it instead of adding a new one, so storage grows with turns and not with time.
+// Segments live in fixed-size chunks and keep their slot until erased; erased slots are reused.
+// A gap (the head was erased by a circle) is explicit: the next point starts a new run
+// instead of joining the old tip. Every slot written is logged, so a reader can pick up only
+// what changed since it last looked.
+class Trail {
+public:
+    static constexpr size_t CHUNK_SIZE = 256;
+    static constexpr long NO_SLOT = -1;
+
+    enum class Growth { Started, Stretched, Appended, Unchanged };
+    enum class Cut { Missed, Shortened, Split, Removed };
+
+    void clear();
+    Growth extend(const Vec2& point); // grow the trail to point
+    Cut cutCircle(size_t slot, const Vec2& center, float radius, long& newSlot); // newSlot is set on Split
+    bool breakTipInCircle(const Vec2& center, float radius); // start a new run if the tip is inside
+    void setIndexId(size_t slot, uint32_t id) { at(slot).indexId = id; }
+    bool empty() const { return liveCount == 0 && !tipValid; }
+    size_t size() const { return liveCount; } // segments
+    size_t slots() const { return used; }     // segments plus free slots, check live
+    const TrailSegment& operator[](size_t i) const { return chunks[i / CHUNK_SIZE][i % CHUNK_SIZE]; }
+    bool hasTip() const { return tipValid; }  // false at the start and after a gap
+    const Vec2& tip() const { return tipPos; } // latest point, when hasTip()
+    long tipSlot() const { return tipSegment; } // segment ending at the tip, NO_SLOT if none
+    uint64_t editCount() const { return editBase + editLog.size(); }
+    uint64_t firstLoggedEdit() const { return editBase; } // a reader behind this starts over
+    uint32_t editedSlot(uint64_t edit) const { return editLog[static_cast<size_t>(edit - editBase)]; }
+
+private:
+    static constexpr size_t MAX_EDITS = 256; // the older half is dropped when full
+
+    TrailSegment& at(size_t i) { return chunks[i / CHUNK_SIZE][i % CHUNK_SIZE]; }
+    size_t addSegment(const Vec2& a, const Vec2& b);
+    void removeSlot(size_t i);
+    void edited(size_t slot);
+
+    std::vector<std::unique_ptr<TrailSegment[]>> chunks;
+    std::vector<size_t> freeSlots;
+    size_t used = 0;
+    size_t liveCount = 0;
+    Vec2 tipPos;
+    bool tipValid = false;
+    long tipSegment = NO_SLOT; // the next straight point may stretch this one
+    Vec2 tipDir;               // its line, as first drawn; taking it from a rounded b would let it turn
+    std::vector<uint32_t> editLog; // slots written, oldest first
+    uint64_t editBase = 0;         // edit number of editLog[0]
+};
+
 struct Flash;
 
 struct Player {
     Vec2 pos;
     Vec2 direction;
     SDL_Color color;
-    std::vector<Vec2> trail;
+    Trail trail;
     bool alive;
     bool willDie;
     bool hasMoved;
@@ -84,16 +160,19 @@ struct Player {
     float spawnInvincibilityTimer;
     std::unique_ptr<Flash> endFlash;
     bool hitOpponentHead;
+    Vec2 prevPos; // position at the start of the tick, for drawing between ticks
 };
 
 struct Circle {
     Vec2 pos;
     Vec2 vel;
-    Vec2 prevPos;
+    Vec2 prevPos;  // position at the start of the tick, for drawing between ticks
+    Vec2 sweptPos; // where trails under it were last erased
     float radius;
 	SDL_Color SDLcirclecolor;
     float magentaTimer;
     bool isYellow;
+    bool swept; // trails under it were erased at sweptPos
 };
 
 struct Collectible {
@@ -124,6 +203,23 @@ struct Flash {
     float duration;
 };
 
+// Controller state for both players for one simulation tick
+struct InputFrame {
+    float leftTrigger[2] = {0.0f, 0.0f};  // 0 to 1
+    float rightTrigger[2] = {0.0f, 0.0f}; // 0 to 1
+    bool aButton[2] = {false, false};     // invincibility
+};
+
+// Read-only view of RGB screen pixels (a mapped pixel buffer or a reused vector)
+struct PixelSnapshot {
+    const unsigned char* pixels = nullptr;
+    size_t bytes = 0;
+    size_t size() const { return bytes; }
+    bool empty() const { return bytes == 0; }
+    const unsigned char* data() const { return pixels; }
+    const unsigned char& operator[](size_t i) const { return pixels[i]; }
+};
+
 struct AudioData {
     SDL_AudioDeviceID deviceId;
     bool* playing;
@@ -132,6 +228,4 @@ struct AudioData {
     AudioManager* manager;
 };
 
-extern const std::map<char, std::vector<bool>> FONT;
-
 #endif // TYPES_H
\ No newline at end of file
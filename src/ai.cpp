@@ -1,171 +1,278 @@
 #include "ai.h"
-#include "game.h" // Add to resolve incomplete Game type
+#include "simulation.h"
+#include <chrono>
 #include <cmath>
 #include <algorithm>
 #include <vector>
-#include <chrono>
 #include <SDL2/SDL.h>
-#include <queue>
-#include <unordered_set>
 
-AI::AI(const GameConfig& config, Game& game)
+AI::AI(const GameConfig& config, Simulation& sim, int self)
     : config(config),
-      game(&game),
+      sim(&sim),
+      self(self),
+      rng(sim.rng()),
       framebuffer(),
       drawableWidth(0),
       drawableHeight(0),
       flashUsed(false),
       modeEnabled(true),
-      leftTrigger(0.0f),
-      rightTrigger(0.0f),
       aButton(false),
-      updateReady(false),
-      newDirection(0, 0),
       currentTimeSec(0.0f),
-      frameCount(0) {}
+      tickDt(1.0f / 120.0f),
+      frameCount(0),
+      astar(config, 6.0f),
+      planner(config, 6.0f),
+      pool(config.AI_THREADS),
+      field(config),
+      fan(),
+      lookahead(config),
+      territory(config),
+      territoryMicros(0.0f),
+      territoryTick(0),
+      budget(config),
+      profiler(config.AI_PROFILE),
+      sweepDirs(),
+      sweepLines(),
+      sweepCast(),
+      passIndices(),
+      passDirs(),
+      sweepHits(),
+      path(),
+      plannedCircles(),
+      plannedOpponent(0.0f, 0.0f),
+      plannedSelf(0.0f, 0.0f),
+      plannedMask(0),
+      plannedTrailChanges(0),
+      consumedTrailChanges(0),
+      worlds([&config] { return World{Simulation(config, 0), {}, 0, 0}; }),
+      decisions([] { return Decision{Vec2(1.0f, 0.0f), 0.0f, false, false, false}; }),
+      current{Vec2(1.0f, 0.0f), 0.0f, false, false, false},
+      worker(),
+      wakeMutex(),
+      wake(),
+      stopping(false) {
+    if (config.AI_WORKER) {
+        worker = std::thread(&AI::workerLoop, this);
+    }
+}
 
 AI::~AI() {
-    if (updateThread.joinable()) {
-        updateThread.join();
+    if (worker.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex);
+            stopping = true;
+        }
+        wake.notify_one();
+        worker.join();
     }
 }
 
-void AI::startUpdate(Player& aiPlayer, const Player& opponent, const Collectible& collectible,
-                     const std::vector<Circle>& circles, float dt, std::mt19937& rng, Game& game,
-                     const std::vector<unsigned char>& framebuffer, int drawableWidth, int drawableHeight, SDL_Color) {
+void AI::post(Simulation& sim, const PixelSnapshot& framebuffer, int drawableWidth, int drawableHeight) {
+    const Player& aiPlayer = own(sim);
     if (!modeEnabled || !aiPlayer.alive || aiPlayer.willDie) return;
 
-    if (updateThread.joinable()) {
-        updateThread.join();
+    sim.dropTrailChanges(consumedTrailChanges.load(std::memory_order_acquire));
+    if (!worker.joinable()) {
+        decisions.back() = think(sim, framebuffer, drawableWidth, drawableHeight);
+        decisions.publish();
+        return;
     }
-    this->framebuffer = framebuffer;
-    this->drawableWidth = drawableWidth;
-    this->drawableHeight = drawableHeight;
-    updateThread = std::thread(&AI::simulateControllerInput, this, std::ref(aiPlayer), std::ref(collectible),
-                              std::ref(circles), std::ref(opponent), dt, std::ref(rng), std::ref(game),
-                              std::ref(framebuffer), drawableWidth, drawableHeight,
-                              std::ref(leftTrigger), std::ref(rightTrigger), std::ref(aButton));
-}
 
-void AI::waitForUpdate() {
-    if (updateThread.joinable()) {
-        updateThread.join();
+    // Bring a slot the worker is not reading up to date; the grid only copies rows that changed
+    // since that slot was last filled. With every other slot still being read, skip this frame.
+    AIProfiler::Scope timer(profiler, AIProfiler::COPY);
+    World* world = worlds.claim();
+    if (!world) return;
+    world->view.copyWorldFrom(sim);
+    world->drawableWidth = drawableWidth;
+    world->drawableHeight = drawableHeight;
+    if (config.COLLISION_MODE == 1) {
+        world->pixels.assign(framebuffer.data(), framebuffer.data() + framebuffer.size());
     }
-}
-
-void AI::applyUpdate(Player& aiPlayer) {
-    std::lock_guard<std::mutex> lock(mutex);
-    if (!updateReady) return;
-
-    Vec2 oldPos = aiPlayer.pos;
-    Vec2 newDir = aiPlayer.direction;
-    float rotation = (rightTrigger - leftTrigger) * config.AI_TURN_SPEED * 0.008333f;
-    if (std::abs(rotation) > 0) {
-        float cosTheta = std::cos(rotation);
-        float sinTheta = std::sin(rotation);
-        newDir = Vec2(
-            aiPlayer.direction.x * cosTheta - aiPlayer.direction.y * sinTheta,
-            aiPlayer.direction.x * sinTheta + aiPlayer.direction.y * cosTheta
-        ).normalized();
+    worlds.publish();
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
     }
+    wake.notify_one();
+}
 
-    float speed = config.PLAYER_SPEED; // Assumed 200.0
-    Vec2 nextPos = aiPlayer.pos + newDir * speed * 0.008333f;
-    nextPos.x = std::max(config.AI_BERTH, std::min(nextPos.x, game->orthoWidth - config.AI_BERTH));
-    nextPos.y = std::max(config.AI_BERTH, std::min(nextPos.y, game->orthoHeight - config.AI_BERTH));
+void AI::workerLoop() {
+    std::unique_lock<std::mutex> lock(wakeMutex);
+    uint64_t seen = 0;
+    while (true) {
+        wake.wait(lock, [this, seen] { return stopping || worlds.published() != seen; });
+        if (stopping) break;
+        lock.unlock();
+
+        {
+            // Held until the decision is out, so post() leaves this slot alone
+            SnapshotRing<World>::Ref world = worlds.latest(&seen);
+            PixelSnapshot pixels{world->pixels.data(), world->pixels.size()};
+            decisions.back() = think(world->view, pixels, world->drawableWidth, world->drawableHeight);
+            decisions.publish();
+        }
 
-    if (aButton && !flashUsed && aiPlayer.canUseNoCollision && !aiPlayer.isInvincible) {
-        game->activateNoCollision(&aiPlayer, currentTimeSec);
-        flashUsed = true;
+        lock.lock();
     }
+}
 
-    bool willDie = false;
-    bool hitOpponentHead = false;
-    if (aiPlayer.hasMoved && !aiPlayer.isInvincible && !aiPlayer.spawnInvincibilityTimer) {
-        aiPlayer.pos = nextPos;
-        game->checkCollision(&aiPlayer, nextPos, currentTimeSec, framebuffer, drawableWidth, drawableHeight);
-        willDie = aiPlayer.willDie;
-        hitOpponentHead = aiPlayer.hitOpponentHead;
+// Hand the AI's triggers to the simulation; it steers and moves the player like any other.
+// The triggers are worked out here from the player's heading now, so an older decision
+// still turns the right amount.
+void AI::applyUpdate(const Player& aiPlayer, InputFrame& input) {
+    decisions.fetch();
+    if (decisions.front().valid) {
+        current = decisions.front();
+    }
+    if (!current.valid) return;
+
+    int slot = sim->playerIndex(&aiPlayer);
+    float dt = 1.0f / std::max(config.TICK_RATE, 1.0f);
+    if (current.steered) {
+        // The search already picked a trigger level
+        if (current.steer > 0.0f) {
+            input.rightTrigger[slot] = current.steer;
+        } else {
+            input.leftTrigger[slot] = -current.steer;
+        }
     } else {
-        aiPlayer.pos = nextPos;
-        aiPlayer.hasMoved = true;
+        float angleDiff = std::acos(std::clamp(aiPlayer.direction.dot(current.targetDir), -1.0f, 1.0f));
+        float cross = aiPlayer.direction.x * current.targetDir.y - aiPlayer.direction.y * current.targetDir.x;
+        float turnSpeedRad = config.AI_TURN_SPEED * M_PI / 180.0f;
+        if (angleDiff > 0.01f) {
+            float triggerValue = std::min(angleDiff / (turnSpeedRad * dt), 1.0f);
+            if (cross > 0) {
+                input.leftTrigger[slot] = triggerValue;
+            } else {
+                input.rightTrigger[slot] = triggerValue;
+            }
+        }
     }
-
-    aiPlayer.direction = newDir;
-    aiPlayer.trail.push_back(aiPlayer.pos);
-    if (willDie) {
-        aiPlayer.willDie = true;
-        aiPlayer.deathPos = nextPos;
-        aiPlayer.hitOpponentHead = hitOpponentHead;
+    if (current.aButton && !flashUsed && aiPlayer.canUseNoCollision && !aiPlayer.isInvincible) {
+        input.aButton[slot] = true;
+        flashUsed = true;
     }
 
     if (config.ENABLE_DEBUG) {
-        float effectiveSpeed = ((aiPlayer.pos - oldPos).magnitude() / 0.008333f);
-        SDL_Log("AI apply: pos=(%f, %f), dir=(%f, %f), speed=%f, expected=%f, leftTrigger=%f, rightTrigger=%f, aButton=%d",
-                aiPlayer.pos.x, aiPlayer.pos.y, newDir.x, newDir.y, effectiveSpeed, speed, leftTrigger, rightTrigger, aButton);
+        SDL_Log("AI apply: pos=(%f, %f), dir=(%f, %f), leftTrigger=%f, rightTrigger=%f, aButton=%d",
+                aiPlayer.pos.x, aiPlayer.pos.y, aiPlayer.direction.x, aiPlayer.direction.y,
+                input.leftTrigger[slot], input.rightTrigger[slot], input.aButton[slot]);
     }
+}
 
-    updateReady = false;
+// Screen areas the next update will sample: the ray fan ahead of the head and the A* window
+void AI::addReadbackRegions(const Player& aiPlayer, const Collectible& collectible, ReadbackManager& readback) const {
+    if (!modeEnabled || !aiPlayer.alive) return;
+    const float RAYCAST_RANGE = 700.0f;
+    const float HEAD_OFFSET = 10.0f;
+    const float ASTAR_MARGIN = 60.0f;
+
+    // Rays go out at most 90 degrees either side of the heading: the fan's bounding box is
+    // set by its two edge rays and any axis direction that falls inside it
+    Vec2 head = aiPlayer.pos + aiPlayer.direction * HEAD_OFFSET;
+    Vec2 side(-aiPlayer.direction.y, aiPlayer.direction.x);
+    float minX = head.x, maxX = head.x, minY = head.y, maxY = head.y;
+    for (const Vec2& reach : {side, -side, Vec2(1, 0), Vec2(-1, 0), Vec2(0, 1), Vec2(0, -1)}) {
+        if (reach.dot(aiPlayer.direction) < -1e-4f) continue;
+        Vec2 end = head + reach * RAYCAST_RANGE;
+        minX = std::min(minX, end.x); maxX = std::max(maxX, end.x);
+        minY = std::min(minY, end.y); maxY = std::max(maxY, end.y);
+    }
+    readback.addRegion(minX, minY, maxX, maxY);
+
+    if (collectible.active) {
+        readback.addRegion(std::min(aiPlayer.pos.x, collectible.pos.x) - ASTAR_MARGIN,
+                           std::min(aiPlayer.pos.y, collectible.pos.y) - ASTAR_MARGIN,
+                           std::max(aiPlayer.pos.x, collectible.pos.x) + ASTAR_MARGIN,
+                           std::max(aiPlayer.pos.y, collectible.pos.y) + ASTAR_MARGIN);
+    }
 }
 
-void AI::simulateControllerInput(const Player& aiPlayer, const Collectible& collectible,
-                                const std::vector<Circle>& circles, const Player& opponent,
-                                float dt, std::mt19937& rng, Game& game,
-                                const std::vector<unsigned char>& framebuffer, int drawableWidth, int drawableHeight,
-                                float& leftTrigger, float& rightTrigger, bool& aButton) {
-    leftTrigger = 0.0f;
-    rightTrigger = 0.0f;
+// Where the AI's player should head next, from what it can see of sim
+AI::Decision AI::think(const Simulation& sim, const PixelSnapshot& framebuffer, int drawableWidth, int drawableHeight) {
+    const Player& aiPlayer = own(sim);
+    const Player& opponent = rival(sim);
+    Decision decision{aiPlayer.direction, 0.0f, false, false, false};
+    AIProfiler::Scope timer(profiler, AIProfiler::DECISION);
+    budget.start();
     aButton = false;
-    currentTimeSec = std::chrono::duration<float>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    currentTimeSec = sim.time;
+    tickDt = 1.0f / std::max(config.TICK_RATE, 1.0f);
     frameCount++;
 
-    dt = std::min(dt, 0.008333f);
-
     size_t expectedSize = static_cast<size_t>(drawableWidth) * drawableHeight * 3;
-    if (framebuffer.size() < expectedSize) {
+    if (config.COLLISION_MODE == 1 && framebuffer.size() < expectedSize) {
         if (config.ENABLE_DEBUG) {
             SDL_Log("Invalid framebuffer size: got %zu, expected %zu", framebuffer.size(), expectedSize);
         }
-        return;
+        return decision;
     }
 
-    Vec2 targetDir = calculateTargetDirection(aiPlayer, collectible, circles, opponent, rng, game, currentTimeSec,
-                                              framebuffer, drawableWidth, drawableHeight);
-
-    float angleDiff = std::acos(std::clamp(aiPlayer.direction.dot(targetDir), -1.0f, 1.0f));
-    float cross = aiPlayer.direction.x * targetDir.y - aiPlayer.direction.y * targetDir.x;
-    float turnSpeedRad = config.AI_TURN_SPEED * M_PI / 180.0f;
-    if (angleDiff > 0.01f) {
-        float triggerValue = std::min(angleDiff / (turnSpeedRad * dt), 1.0f);
-        if (cross > 0) {
-            leftTrigger = triggerValue;
-        } else {
-            rightTrigger = triggerValue;
+    {
+        AIProfiler::Scope prepare(profiler, AIProfiler::PREPARE);
+        if (config.COLLISION_MODE != 1) {
+            feedPlanner(sim);
+        }
+        if (config.DISTANCE_FIELD_CELL_SIZE > 0.0f) {
+            buildField(sim);
         }
     }
-
-    std::lock_guard<std::mutex> lock(mutex);
-    updateReady = true;
+    if (config.AI_MODE == 1) {
+        searchAhead(sim, framebuffer, drawableWidth, drawableHeight, decision);
+        profiler.endDecision();
+        return decision;
+    }
+    decision.targetDir = calculateTargetDirection(aiPlayer, sim.collectible, sim.circles, opponent, sim, currentTimeSec,
+                                                  framebuffer, drawableWidth, drawableHeight);
+    decision.aButton = aButton;
+    decision.valid = true;
+    profiler.endDecision();
 
     if (config.ENABLE_DEBUG) {
-        SDL_Log("AI input: leftTrigger=%f, rightTrigger=%f, aButton=%d, angleDiff=%f degrees",
-                leftTrigger, rightTrigger, aButton, angleDiff * 180.0 / M_PI);
+        SDL_Log("AI decision: tick=%llu, targetDir=(%f, %f)", static_cast<unsigned long long>(sim.tick),
+                decision.targetDir.x, decision.targetDir.y);
     }
+    return decision;
+}
+
+// AI_MODE=1: play steering plans ahead and hold the best one's trigger. Trails come from the
+// grid or segments, or from the pixels in pixel mode; the flash is kept for when every plan crashes.
+void AI::searchAhead(const Simulation& sim, const PixelSnapshot& framebuffer, int drawableWidth, int drawableHeight,
+                     Decision& decision) {
+    const Player& aiPlayer = own(sim);
+    auto solid = [&](const Vec2& pos) {
+        if (config.COLLISION_MODE != 1) return sim.solidTrailAt(pos, self);
+        CellType cell = sampleCell(pos, sim, framebuffer, drawableWidth, drawableHeight);
+        return cell == CellType::TrailP1 || cell == CellType::TrailP2;
+    };
+    bool trailField = config.COLLISION_MODE == 0 && config.DISTANCE_FIELD_CELL_SIZE > 0.0f;
+    AIProfiler::Scope timer(profiler, AIProfiler::SEARCH);
+    Lookahead::Result result = lookahead.search(sim, self, solid, trailField ? &field : nullptr, pool, rng(),
+                                                budget.deadline());
+    profiler.count(AIProfiler::ROLLOUTS, result.rollouts);
+    decision.steer = result.steer;
+    decision.steered = true;
+    decision.aButton = result.trapped && !flashUsed && aiPlayer.canUseNoCollision && !aiPlayer.isInvincible;
+    decision.valid = true;
 }
 
 float AI::heuristic(const Vec2& a, const Vec2& b) const {
     return (a - b).magnitude();
 }
 
-bool AI::isPositionSafe(const Vec2& pos, const std::vector<Circle>& circles, const Player& opponent, Game& game) {
-    if (pos.x < config.AI_BERTH || pos.x > game.orthoWidth - config.AI_BERTH ||
-        pos.y < config.AI_BERTH || pos.y > game.orthoHeight - config.AI_BERTH) {
+bool AI::isPositionSafe(const Vec2& pos, const std::vector<Circle>& circles, const Player& opponent, const Simulation& sim) {
+    if (pos.x < config.AI_BERTH || pos.x > sim.orthoWidth - config.AI_BERTH ||
+        pos.y < config.AI_BERTH || pos.y > sim.orthoHeight - config.AI_BERTH) {
         return false;
     }
 
-    for (const auto& circle : circles) {
-        if ((pos - circle.pos).magnitude() < circle.radius + config.AI_BERTH) {
-            return false;
+    if (config.DISTANCE_FIELD_CELL_SIZE > 0.0f) {
+        if (field.circleDistance(pos) < config.AI_BERTH) return false;
+    } else {
+        for (const auto& circle : circles) {
+            if ((pos - circle.pos).magnitude() < circle.radius + config.AI_BERTH) {
+                return false;
+            }
         }
     }
 
@@ -176,77 +283,120 @@ bool AI::isPositionSafe(const Vec2& pos, const std::vector<Circle>& circles, con
     return true;
 }
 
-std::vector<Vec2> AI::findPathAStar(const Vec2& start, const Vec2& goal, const std::vector<Circle>& circles,
-                                    const Player& opponent, Game& game, const std::vector<unsigned char>& framebuffer,
-                                    int drawableWidth, int drawableHeight) {
-    const float GRID_SIZE = 6.0f; // Finer grid
-    std::priority_queue<PathNode, std::vector<PathNode>, std::greater<PathNode>> openList;
-    std::unordered_set<uint64_t> closedList;
-
-    auto hashPos = [&](const Vec2& pos) {
-        int x = static_cast<int>(pos.x / GRID_SIZE);
-        int y = static_cast<int>(pos.y / GRID_SIZE);
-        return static_cast<uint64_t>(x) << 32 | static_cast<uint64_t>(y);
-    };
+// Bring the clearance maps up to date for this decision. Only the grid mode keeps trail
+// distances: segment mode casts rays exactly and pixel mode reads a screen that runs behind.
+void AI::buildField(const Simulation& sim) {
+    field.resize(sim.orthoWidth, sim.orthoHeight);
+    if (config.COLLISION_MODE == 0) {
+        const CollisionGrid& grid = sim.collisionGrid;
+        field.update([&grid](float minX, float minY, float maxX, float maxY) {
+            return grid.anyTrail(minX, minY, maxX, maxY);
+        }, pool);
+    }
+    field.stampCircles(sim.circles, config.AI_BERTH + field.getReach());
+    if (config.COLLISION_MODE == 0) {
+        fan.prepare(sim, field, config.AI_BERTH, self);
+    }
+}
 
-    PathNode startNode{start, 0.0f, heuristic(start, goal), nullptr};
-    openList.push(startNode);
+// Tell the planner where the board may differ since it last planned: new trail, and the
+// areas circles, the opponent and this player's own head left or entered
+void AI::feedPlanner(const Simulation& sim) {
+    const float SPACING = 6.0f;
+    uint32_t mask = sim.solidTrailMask();
+    if (mask != plannedMask || sim.circles.size() < plannedCircles.size() || plannedTrailChanges < sim.trailChangeBase) {
+        planner.reset();
+    }
+    if (plannedTrailChanges < sim.trailChangeBase) {
+        field.invalidate();
+    }
+    plannedMask = mask;
 
-    std::vector<Vec2> directions = {
-        {GRID_SIZE, 0}, {-GRID_SIZE, 0}, {0, GRID_SIZE}, {0, -GRID_SIZE},
-        {GRID_SIZE, GRID_SIZE}, {GRID_SIZE, -GRID_SIZE}, {-GRID_SIZE, GRID_SIZE}, {-GRID_SIZE, -GRID_SIZE}
-    };
+    for (size_t i = plannedTrailChanges > sim.trailChangeBase ? plannedTrailChanges - sim.trailChangeBase : 0;
+         i < sim.trailChanges.size(); ++i) {
+        const ChangedArea& area = sim.trailChanges[i];
+        planner.markChanged(area.minX - SPACING, area.minY - SPACING, area.maxX + SPACING, area.maxY + SPACING);
+        field.markChanged(area.minX, area.minY, area.maxX, area.maxY);
+    }
+    plannedTrailChanges = sim.trailChangeBase + sim.trailChanges.size();
+    consumedTrailChanges.store(plannedTrailChanges, std::memory_order_release);
 
-    while (!openList.empty()) {
-        PathNode current = openList.top();
-        openList.pop();
+    // Box around where something was and where it is now
+    auto moved = [&](const Vec2& from, const Vec2& to, float reach) {
+        planner.markChanged(std::min(from.x, to.x) - reach, std::min(from.y, to.y) - reach,
+                            std::max(from.x, to.x) + reach, std::max(from.y, to.y) + reach);
+    };
+    for (size_t i = 0; i < sim.circles.size(); ++i) {
+        const Circle& circle = sim.circles[i];
+        Vec2 from = i < plannedCircles.size() ? plannedCircles[i] : circle.pos;
+        moved(from, circle.pos, circle.radius + config.AI_BERTH + SPACING * 2.0f);
+    }
+    plannedCircles.resize(sim.circles.size());
+    for (size_t i = 0; i < sim.circles.size(); ++i) {
+        plannedCircles[i] = sim.circles[i].pos;
+    }
+    moved(plannedOpponent, rival(sim).pos, config.AI_BERTH * 2.0f + config.PLAYER_SIZE + SPACING * 2.0f);
+    plannedOpponent = rival(sim).pos;
+    moved(plannedSelf, own(sim).pos, config.TRAIL_SIZE + config.PLAYER_SIZE + SPACING * 2.0f);
+    plannedSelf = own(sim).pos;
+}
 
-        uint64_t currentHash = hashPos(current.pos);
-        if (closedList.find(currentHash) != closedList.end()) continue;
-        closedList.insert(currentHash);
+// Path on a 6 unit lattice around circles, the opponent and anything the AI must not touch.
+// The grid and segment modes repair the planner's last search; pixel mode searches from scratch
+// because the screen it reads runs behind the simulation.
+const std::vector<Vec2>& AI::findPathAStar(const Vec2& start, const Vec2& goal, const std::vector<Circle>& circles,
+                                           const Player& opponent, const Simulation& sim, const PixelSnapshot& framebuffer,
+                                           int drawableWidth, int drawableHeight) {
+    AIProfiler::Scope timer(profiler, AIProfiler::PLAN);
+    int samples = 0;
+    auto passable = [&](const Vec2& pos) {
+        if (!isPositionSafe(pos, circles, opponent, sim)) return false;
+        ++samples;
+        return !CollisionGrid::isDangerToAI(sampleCell(pos, sim, framebuffer, drawableWidth, drawableHeight));
+    };
 
-        if ((current.pos - goal).magnitude() < GRID_SIZE) {
-            std::vector<Vec2> path;
-            auto node = std::make_shared<PathNode>(current);
-            while (node) {
-                path.push_back(node->pos);
-                node = node->parent;
-            }
-            std::reverse(path.begin(), path.end());
-            return path;
+    if (config.COLLISION_MODE != 1) {
+        DStarLite::Stats stats = planner.plan(start, goal, sim.orthoWidth, sim.orthoHeight, passable,
+                                              budget.searchLimit(), path);
+        if (config.ENABLE_DEBUG) {
+            const DStarLite::Stats& full = planner.lastFullSearch();
+            SDL_Log("D* Lite: expanded=%d, updated=%d, rechecked=%d, full=%d, complete=%d (last full search: expanded=%d, updated=%d)",
+                    stats.expanded, stats.updated, stats.rechecked, stats.fullSearch, stats.complete,
+                    full.expanded, full.updated);
         }
-
-        for (const auto& dir : directions) {
-            Vec2 newPos = current.pos + dir;
-            if (!isPositionSafe(newPos, circles, opponent, game)) continue;
-
-            std::string color = getPixelColor(newPos, game, currentTimeSec, framebuffer, drawableWidth, drawableHeight);
-            if (color == "red" || color == "yellow" || color == "blue") continue;
-
-            float gCost = current.gCost + dir.magnitude();
-            float hCost = heuristic(newPos, goal);
-            PathNode newNode{newPos, gCost, gCost + hCost, std::make_shared<PathNode>(current)};
-
-            openList.push(newNode);
+        profiler.count(AIProfiler::NODES, stats.expanded);
+        if (!path.empty()) {
+            profiler.count(AIProfiler::SAMPLES, samples);
+            return path;
         }
     }
 
-    return {};
+    GridAStar::Result result = astar.findPath(start, goal, sim.orthoWidth, sim.orthoHeight, passable,
+                                              budget.searchLimit(), path);
+    if (config.ENABLE_DEBUG) {
+        SDL_Log("A*: expanded=%d, reachedGoal=%d, pathLength=%zu", result.expanded, result.reachedGoal, path.size());
+    }
+    profiler.count(AIProfiler::NODES, result.expanded);
+    profiler.count(AIProfiler::SAMPLES, samples);
+    return path;
 }
 
 Vec2 AI::calculateTargetDirection(const Player& aiPlayer, const Collectible& collectible,
                                  const std::vector<Circle>& circles, const Player& opponent,
-                                 std::mt19937& rng, Game& game, float currentTimeSec,
-                                 const std::vector<unsigned char>& framebuffer, int drawableWidth, int drawableHeight) {
+                                 const Simulation& sim, float currentTimeSec,
+                                 const PixelSnapshot& framebuffer, int drawableWidth, int drawableHeight) {
     const float AI_BERTH = config.AI_BERTH;
     const float COLLECTIBLE_HALF_SIZE = config.COLLECTIBLE_SIZE / 2.0f;
     const float VISUAL_HALF_SIZE = collectible.size / 2.0f;
     const float RAYCAST_RANGE = 700.0f;
     const float ANGLE_STEP = M_PI / 180; // 1-degree increments
-    const float MAX_TURN_ANGLE = config.AI_TURN_SPEED * 0.008333f;
+    const float MAX_TURN_ANGLE = config.AI_TURN_SPEED * static_cast<float>(M_PI) / 180.0f * tickDt; // one tick's turn
     const float WALL_THRESHOLD = AI_BERTH * 9.0f; // 90 units
     const float DANGER_THRESHOLD = 7.0f;
     const float OPPONENT_AVOIDANCE = 90.0f;
+    const float TERRITORY_PROBE = 120.0f; // how far along a direction to ask who owns the board
+    const uint64_t TERRITORY_MAX_AGE = 30; // ticks a map may be reused for before it is too old to trust
+    const int SWEEP_COARSE = 8; // directions apart in the sweep's first pass, a power of two
 
     if (!collectible.active) {
         return aiPlayer.direction;
@@ -260,23 +410,23 @@ Vec2 AI::calculateTargetDirection(const Player& aiPlayer, const Collectible& col
         wallAvoidanceDir += Vec2(1.0f, 0.0f);
         wallDistance = std::min(wallDistance, aiPlayer.pos.x - AI_BERTH);
         nearWall = true;
-    } else if (aiPlayer.pos.x > game.orthoWidth - WALL_THRESHOLD) {
+    } else if (aiPlayer.pos.x > sim.orthoWidth - WALL_THRESHOLD) {
         wallAvoidanceDir += Vec2(-1.0f, 0.0f);
-        wallDistance = std::min(wallDistance, game.orthoWidth - aiPlayer.pos.x - AI_BERTH);
+        wallDistance = std::min(wallDistance, sim.orthoWidth - aiPlayer.pos.x - AI_BERTH);
         nearWall = true;
     }
     if (aiPlayer.pos.y < WALL_THRESHOLD) {
         wallAvoidanceDir += Vec2(0.0f, 1.0f);
         wallDistance = std::min(wallDistance, aiPlayer.pos.y - AI_BERTH);
         nearWall = true;
-    } else if (aiPlayer.pos.y > game.orthoHeight - WALL_THRESHOLD) {
+    } else if (aiPlayer.pos.y > sim.orthoHeight - WALL_THRESHOLD) {
         wallAvoidanceDir += Vec2(0.0f, -1.0f);
-        wallDistance = std::min(wallDistance, game.orthoHeight - aiPlayer.pos.y - AI_BERTH);
+        wallDistance = std::min(wallDistance, sim.orthoHeight - aiPlayer.pos.y - AI_BERTH);
         nearWall = true;
     }
 
     // A* pathfinding
-    std::vector<Vec2> path = findPathAStar(aiPlayer.pos, collectible.pos, circles, opponent, game, framebuffer, drawableWidth, drawableHeight);
+    const std::vector<Vec2>& path = findPathAStar(aiPlayer.pos, collectible.pos, circles, opponent, sim, framebuffer, drawableWidth, drawableHeight);
     Vec2 toCollectible = (collectible.pos - aiPlayer.pos).normalized();
     Vec2 targetDir = toCollectible;
 
@@ -314,7 +464,11 @@ Vec2 AI::calculateTargetDirection(const Player& aiPlayer, const Collectible& col
     }
 
     // Forward raycast
-    RaycastResult forwardRay = raycastForward(aiPlayer, game, currentTimeSec, framebuffer, drawableWidth, drawableHeight);
+    RaycastResult forwardRay;
+    {
+        AIProfiler::Scope timer(profiler, AIProfiler::RAYCAST);
+        forwardRay = raycastForward(aiPlayer, sim, currentTimeSec, framebuffer, drawableWidth, drawableHeight);
+    }
 
     // Pursue collectible if safe
     if (nearCollectible || (!forwardRay.centerLine.hasDanger || forwardRay.centerLine.greenVisible)) {
@@ -335,17 +489,82 @@ Vec2 AI::calculateTargetDirection(const Player& aiPlayer, const Collectible& col
         return targetDir;
     }
 
-    // Pathfinding sweep
-    std::vector<std::pair<Vec2, float>> safeDirections;
+    // Directions into space the opponent gets to first, or through one-cell gaps, are worth less.
+    // When a new map would not fit in what is left of the budget the last one is used, but only
+    // while it is from this round and TERRITORY_MAX_AGE ticks old at most; otherwise none is.
+    bool mapped = config.COLLISION_MODE == 0 && config.AI_TERRITORY_CELL_SIZE > 0.0f;
+    if (mapped && budget.remainingMicros() > territoryMicros) {
+        AIProfiler::Scope timer(profiler, AIProfiler::TERRITORY);
+        auto started = std::chrono::steady_clock::now();
+        territory.compute(sim);
+        territoryMicros = std::chrono::duration<float, std::micro>(std::chrono::steady_clock::now() - started).count();
+        territoryTick = sim.tick;
+    }
+    mapped = mapped && territoryMicros > 0.0f && territoryTick >= sim.roundStartTick &&
+             sim.tick - territoryTick <= TERRITORY_MAX_AGE;
+
+    // Pathfinding sweep: every direction within a turn, 1 degree apart, cast together in grid mode.
+    // Passes go coarse to fine, every SWEEP_COARSE-th direction first and then the ones between;
+    // the first pass always runs and later ones only while the budget lasts.
+    AIProfiler::Scope timer(profiler, AIProfiler::SWEEP);
+    Vec2 sweepStart = aiPlayer.pos + aiPlayer.direction * 10.0f;
+    Vec2 stepRotation(std::cos(ANGLE_STEP), std::sin(ANGLE_STEP));
+    sweepDirs.clear();
     for (float angle = -M_PI / 2; angle <= M_PI / 2; angle += ANGLE_STEP) {
         if (std::abs(angle) > MAX_TURN_ANGLE) continue;
-        Vec2 testDir = Vec2(
-            aiPlayer.direction.x * std::cos(angle) - aiPlayer.direction.y * std::sin(angle),
-            aiPlayer.direction.x * std::sin(angle) + aiPlayer.direction.y * std::cos(angle)
-        ).normalized();
+        if (sweepDirs.empty()) {
+            sweepDirs.push_back(Vec2(
+                aiPlayer.direction.x * std::cos(angle) - aiPlayer.direction.y * std::sin(angle),
+                aiPlayer.direction.x * std::sin(angle) + aiPlayer.direction.y * std::cos(angle)
+            ).normalized());
+        } else {
+            const Vec2& last = sweepDirs.back();
+            sweepDirs.push_back(Vec2(last.x * stepRotation.x - last.y * stepRotation.y,
+                                     last.x * stepRotation.y + last.y * stepRotation.x).normalized());
+        }
+    }
+    int directions = static_cast<int>(sweepDirs.size());
+    sweepLines.resize(directions);
+    sweepCast.assign(directions, 0);
 
-        LineCheckResult line = checkLine(aiPlayer.pos + aiPlayer.direction * 10.0f, testDir, RAYCAST_RANGE,
-                                        aiPlayer.direction, game, currentTimeSec, framebuffer, drawableWidth, drawableHeight);
+    bool batched = config.COLLISION_MODE == 0 && config.DISTANCE_FIELD_CELL_SIZE > 0.0f;
+    for (int stride = SWEEP_COARSE; stride >= 1; stride /= 2) {
+        if (stride < SWEEP_COARSE && budget.expired()) break;
+        passIndices.clear();
+        for (int i = 0; i < directions; i += stride) {
+            if (!sweepCast[i]) passIndices.push_back(i);
+        }
+        if (batched) {
+            passDirs.clear();
+            for (int i : passIndices) {
+                passDirs.push_back(sweepDirs[i]);
+            }
+            sweepHits.resize(passDirs.size());
+            fan.cast(sweepStart, passDirs.data(), static_cast<int>(passDirs.size()), RAYCAST_RANGE, sweepHits.data());
+            profiler.count(AIProfiler::RAYS, static_cast<int>(passDirs.size()));
+        }
+        for (size_t k = 0; k < passIndices.size(); ++k) {
+            int i = passIndices[k];
+            LineCheckResult& line = sweepLines[i];
+            if (batched) {
+                line.distance = sweepHits[k].distance;
+                line.cell = sweepHits[k].cell;
+                line.greenVisible = line.cell == CellType::Collectible;
+                line.hasDanger = line.cell != CellType::Empty && !line.greenVisible;
+                line.hitPos = sweepStart + sweepDirs[i] * line.distance;
+            } else {
+                line = checkLine(sweepStart, sweepDirs[i], RAYCAST_RANGE, aiPlayer.direction, sim, currentTimeSec,
+                                 framebuffer, drawableWidth, drawableHeight);
+            }
+            sweepCast[i] = 1;
+        }
+    }
+
+    std::vector<std::pair<Vec2, float>> safeDirections;
+    for (int i = 0; i < directions; ++i) {
+        if (!sweepCast[i]) continue;
+        const Vec2& testDir = sweepDirs[i];
+        const LineCheckResult& line = sweepLines[i];
 
         if (!line.hasDanger || line.greenVisible) {
             float score = testDir.dot(toCollectible) * (line.greenVisible ? 30.0f : 1.0f) * (1.0f - line.distance / RAYCAST_RANGE);
@@ -357,13 +576,27 @@ Vec2 AI::calculateTargetDirection(const Player& aiPlayer, const Collectible& col
                        std::abs(testPos.y - collectible.pos.y) <= COLLECTIBLE_HALF_SIZE) {
                 score *= 15.0f;
             }
-            if (testPos.x < AI_BERTH * 2.0f || testPos.x > game.orthoWidth - AI_BERTH * 2.0f ||
-                testPos.y < AI_BERTH * 2.0f || testPos.y > game.orthoHeight - AI_BERTH * 2.0f) {
+            if (testPos.x < AI_BERTH * 2.0f || testPos.x > sim.orthoWidth - AI_BERTH * 2.0f ||
+                testPos.y < AI_BERTH * 2.0f || testPos.y > sim.orthoHeight - AI_BERTH * 2.0f) {
                 score *= 0.1f;
             }
             if ((testPos - opponent.pos).magnitude() < OPPONENT_AVOIDANCE) {
                 score *= 0.2f;
             }
+            if (mapped) {
+                Vec2 probe = aiPlayer.pos + testDir * std::min(line.distance, TERRITORY_PROBE);
+                int owner = territory.ownerAt(probe);
+                if (owner == Territory::CONTESTED) {
+                    score *= 0.6f;
+                } else if (owner == 1 - self) {
+                    score *= 0.3f;
+                } else if (owner == Territory::NOBODY) {
+                    score *= 0.1f;
+                }
+                if (territory.isNarrow(probe)) {
+                    score *= 0.5f;
+                }
+            }
             safeDirections.emplace_back(testDir, score);
         }
     }
@@ -394,8 +627,8 @@ Vec2 AI::calculateTargetDirection(const Player& aiPlayer, const Collectible& col
     ).normalized();
 }
 
-AI::RaycastResult AI::raycastForward(const Player& aiPlayer, Game& game, float currentTimeSec,
-                                     const std::vector<unsigned char>& framebuffer, int drawableWidth, int drawableHeight) {
+AI::RaycastResult AI::raycastForward(const Player& aiPlayer, const Simulation& sim, float currentTimeSec,
+                                     const PixelSnapshot& framebuffer, int drawableWidth, int drawableHeight) {
     RaycastResult result;
     const float ANGLE_OFFSET = M_PI / 18; // 10 degrees
     const float RAYCAST_RANGE = 700.0f;
@@ -403,7 +636,7 @@ AI::RaycastResult AI::raycastForward(const Player& aiPlayer, Game& game, float c
 
     Vec2 start = aiPlayer.pos + aiPlayer.direction * HEAD_OFFSET;
 
-    result.centerLine = checkLine(start, aiPlayer.direction, RAYCAST_RANGE, aiPlayer.direction, game, currentTimeSec,
+    result.centerLine = checkLine(start, aiPlayer.direction, RAYCAST_RANGE, aiPlayer.direction, sim, currentTimeSec,
                                   framebuffer, drawableWidth, drawableHeight);
 
     float cosA = std::cos(-ANGLE_OFFSET);
@@ -412,7 +645,7 @@ AI::RaycastResult AI::raycastForward(const Player& aiPlayer, Game& game, float c
         aiPlayer.direction.x * cosA - aiPlayer.direction.y * sinA,
         aiPlayer.direction.x * sinA + aiPlayer.direction.y * cosA
     ).normalized();
-    result.leftLine = checkLine(start, leftDir, RAYCAST_RANGE, aiPlayer.direction, game, currentTimeSec,
+    result.leftLine = checkLine(start, leftDir, RAYCAST_RANGE, aiPlayer.direction, sim, currentTimeSec,
                                 framebuffer, drawableWidth, drawableHeight);
     result.leftDir = leftDir;
 
@@ -422,77 +655,181 @@ AI::RaycastResult AI::raycastForward(const Player& aiPlayer, Game& game, float c
         aiPlayer.direction.x * cosA - aiPlayer.direction.y * sinA,
         aiPlayer.direction.x * sinA + aiPlayer.direction.y * cosA
     ).normalized();
-    result.rightLine = checkLine(start, rightDir, RAYCAST_RANGE, aiPlayer.direction, game, currentTimeSec,
+    result.rightLine = checkLine(start, rightDir, RAYCAST_RANGE, aiPlayer.direction, sim, currentTimeSec,
                                  framebuffer, drawableWidth, drawableHeight); // Fixed: drawableWidth, drawableHeight
     result.rightDir = rightDir;
 
     if (config.ENABLE_DEBUG && (result.centerLine.hasDanger || result.leftLine.hasDanger || result.rightLine.hasDanger)) {
         SDL_Log("Line check: center=%s at (%f, %f, dist=%f), left=%s at (%f, %f, dist=%f), right=%s at (%f, %f, dist=%f)",
-                result.centerLine.color.c_str(), result.centerLine.hitPos.x, result.centerLine.hitPos.y, result.centerLine.distance,
-                result.leftLine.color.c_str(), result.leftLine.hitPos.x, result.leftLine.hitPos.y, result.leftLine.distance,
-                result.rightLine.color.c_str(), result.rightLine.hitPos.x, result.rightLine.hitPos.y, result.rightLine.distance);
+                CollisionGrid::colorName(result.centerLine.cell), result.centerLine.hitPos.x, result.centerLine.hitPos.y, result.centerLine.distance,
+                CollisionGrid::colorName(result.leftLine.cell), result.leftLine.hitPos.x, result.leftLine.hitPos.y, result.leftLine.distance,
+                CollisionGrid::colorName(result.rightLine.cell), result.rightLine.hitPos.x, result.rightLine.hitPos.y, result.rightLine.distance);
     }
 
     return result;
 }
 
 AI::LineCheckResult AI::checkLine(const Vec2& start, const Vec2& dir, float maxDistance, const Vec2& playerDir,
-                                  Game& game, float currentTimeSec, const std::vector<unsigned char>& framebuffer,
+                                  const Simulation& sim, float currentTimeSec, const PixelSnapshot& framebuffer,
                                   int drawableWidth, int drawableHeight) const {
     LineCheckResult result;
     result.distance = maxDistance;
     result.hasDanger = false;
     result.greenVisible = false;
     result.hitPos = start;
-    result.color = "none";
+    result.cell = CellType::Empty;
+    profiler.count(AIProfiler::RAYS, 1);
+
+    if (config.COLLISION_MODE == 2) {
+        result = castSegments(start, dir, maxDistance, sim);
+        if (config.ENABLE_DEBUG && result.hasDanger) {
+            SDL_Log("checkLine: start=(%f, %f), dir=(%f, %f), hit=%s at (%f, %f), distance=%f",
+                    start.x, start.y, dir.x, dir.y, CollisionGrid::colorName(result.cell), result.hitPos.x, result.hitPos.y, result.distance);
+        }
+        return result;
+    }
 
     const float STEP_SIZE = 2.0f; // Check every 2 units
-    int steps = static_cast<int>(maxDistance / STEP_SIZE);
     Vec2 normDir = dir.normalized();
 
-    for (int i = 0; i <= steps; ++i) {
-        float distance = i * STEP_SIZE;
+    // Grid mode jumps ahead by the distance the ray fan says is clear and steps finely near
+    // anything it could hit, the same way the sweep's batched rays do
+    bool traced = config.COLLISION_MODE == 0 && config.DISTANCE_FIELD_CELL_SIZE > 0.0f;
+    float wallExit = traced ? fan.wallExit(start, normDir) : 0.0f;
+
+    float distance = 0.0f;
+    int samples = 0;
+    while (distance <= maxDistance) {
         Vec2 pos = start + normDir * distance;
 
         // Check wall collision
-        if (pos.x < config.AI_BERTH || pos.x > game.orthoWidth - config.AI_BERTH ||
-            pos.y < config.AI_BERTH || pos.y > game.orthoHeight - config.AI_BERTH) {
+        if (pos.x < config.AI_BERTH || pos.x > sim.orthoWidth - config.AI_BERTH ||
+            pos.y < config.AI_BERTH || pos.y > sim.orthoHeight - config.AI_BERTH) {
             result.distance = distance;
             result.hasDanger = true;
             result.hitPos = pos;
-            result.color = "wall";
+            result.cell = CellType::Wall;
             break;
         }
 
-        // Check pixel color
-        std::string color = getPixelColor(pos, game, currentTimeSec, framebuffer, drawableWidth, drawableHeight);
-        if (color == "green") {
+        // Check what is drawn there
+        ++samples;
+        CellType cell = sampleCell(pos, sim, framebuffer, drawableWidth, drawableHeight);
+        if (cell == CellType::Collectible) {
             result.greenVisible = true;
             result.distance = distance;
             result.hitPos = pos;
-            result.color = color;
+            result.cell = cell;
             break;
-        } else if (color == "red" || color == "blue" || color == "yellow") {
+        } else if (CollisionGrid::isDangerToAI(cell)) {
             result.hasDanger = true;
             result.distance = distance;
             result.hitPos = pos;
-            result.color = color;
+            result.cell = cell;
             break;
         }
+
+        float step = STEP_SIZE;
+        if (traced) {
+            step = std::max(STEP_SIZE, std::min(fan.clearDistance(pos), wallExit - distance));
+        }
+        distance += step;
     }
+    profiler.count(AIProfiler::SAMPLES, samples);
 
     if (config.ENABLE_DEBUG && result.hasDanger) {
         SDL_Log("checkLine: start=(%f, %f), dir=(%f, %f), hit=%s at (%f, %f), distance=%f",
-                start.x, start.y, dir.x, dir.y, result.color.c_str(), result.hitPos.x, result.hitPos.y, result.distance);
+                start.x, start.y, dir.x, dir.y, CollisionGrid::colorName(result.cell), result.hitPos.x, result.hitPos.y, result.distance);
+    }
+
+    return result;
+}
+
+// checkLine without stepping: intersect the ray with the trail segments, yellow circles,
+// the opponent's head, the collectible and the berth, and keep the nearest
+AI::LineCheckResult AI::castSegments(const Vec2& start, const Vec2& dir, float maxDistance, const Simulation& sim) const {
+    LineCheckResult result;
+    result.distance = maxDistance;
+    result.hasDanger = false;
+    result.greenVisible = false;
+    result.cell = CellType::Empty;
+    Vec2 normDir = dir.normalized();
+
+    auto closer = [&](float distance, CellType cell) {
+        if (distance >= 0.0f && distance < result.distance) {
+            result.distance = distance;
+            result.cell = cell;
+        }
+    };
+    // Entry distance of the ray into an axis-aligned box, or -1
+    auto boxEntry = [&](const Vec2& center, float half) {
+        float tNear = 0.0f, tFar = maxDistance;
+        const float s[2] = {start.x, start.y}, d[2] = {normDir.x, normDir.y}, c[2] = {center.x, center.y};
+        for (int axis = 0; axis < 2; ++axis) {
+            if (std::abs(d[axis]) < 1e-6f) {
+                if (std::abs(s[axis] - c[axis]) > half) return -1.0f;
+                continue;
+            }
+            float t0 = (c[axis] - half - s[axis]) / d[axis];
+            float t1 = (c[axis] + half - s[axis]) / d[axis];
+            if (t0 > t1) std::swap(t0, t1);
+            tNear = std::max(tNear, t0);
+            tFar = std::min(tFar, t1);
+            if (tNear > tFar) return -1.0f;
+        }
+        return tNear;
+    };
+
+    // Berth box, the ray starts inside it
+    float minX = config.AI_BERTH, maxX = sim.orthoWidth - config.AI_BERTH;
+    float minY = config.AI_BERTH, maxY = sim.orthoHeight - config.AI_BERTH;
+    if (start.x < minX || start.x > maxX || start.y < minY || start.y > maxY) {
+        closer(0.0f, CellType::Wall);
+    } else {
+        if (normDir.x > 0.0f) closer((maxX - start.x) / normDir.x, CellType::Wall);
+        if (normDir.x < 0.0f) closer((minX - start.x) / normDir.x, CellType::Wall);
+        if (normDir.y > 0.0f) closer((maxY - start.y) / normDir.y, CellType::Wall);
+        if (normDir.y < 0.0f) closer((minY - start.y) / normDir.y, CellType::Wall);
+    }
+
+    SegmentIndex::RayHit trailHit = sim.segmentIndex.raycast(start, normDir, result.distance, sim.solidTrailMask());
+    if (trailHit.owner >= 0) closer(trailHit.distance, trailHit.owner == 0 ? CellType::TrailP1 : CellType::TrailP2);
+
+    for (const auto& circle : sim.circles) {
+        if (!circle.isYellow) continue;
+        Vec2 toStart = start - circle.pos;
+        float b = toStart.dot(normDir);
+        float c = toStart.dot(toStart) - circle.radius * circle.radius;
+        float disc = b * b - c;
+        if (disc < 0.0f) continue;
+        closer(c <= 0.0f ? 0.0f : -b - std::sqrt(disc), CellType::CircleDanger);
     }
 
+    const Player& opponent = rival(sim);
+    if (opponent.alive) {
+        closer(boxEntry(opponent.pos, config.PLAYER_SIZE / 2.0f), self == 0 ? CellType::HeadP2 : CellType::HeadP1);
+    }
+
+    if (sim.collectible.active) closer(boxEntry(sim.collectible.pos, sim.collectible.size / 2.0f), CellType::Collectible);
+
+    result.hitPos = start + normDir * result.distance;
+    if (result.cell == CellType::Collectible) {
+        result.greenVisible = true;
+    } else if (result.cell != CellType::Empty) {
+        result.hasDanger = true;
+    }
     return result;
 }
 
-std::string AI::getPixelColor(const Vec2& pos, Game& game, float currentTimeSec,
-                              const std::vector<unsigned char>& framebuffer, int drawableWidth, int drawableHeight) const {
-    float x_read = (pos.x / game.orthoWidth) * drawableWidth;
-    float y_read = ((game.orthoHeight - pos.y) / game.orthoHeight) * drawableHeight;
+CellType AI::sampleCell(const Vec2& pos, const Simulation& sim, const PixelSnapshot& framebuffer,
+                        int drawableWidth, int drawableHeight) const {
+    if (config.COLLISION_MODE != 1) {
+        // Collision grid or trail segments, not counting the AI's own head
+        return sim.sample(pos, self);
+    }
+
+    float x_read = (pos.x / sim.orthoWidth) * drawableWidth;
+    float y_read = ((sim.orthoHeight - pos.y) / sim.orthoHeight) * drawableHeight;
     x_read = std::max(0.0f, std::min(x_read, static_cast<float>(drawableWidth - 1)));
     y_read = std::max(0.0f, std::min(y_read, static_cast<float>(drawableHeight - 1)));
 
@@ -502,23 +839,13 @@ std::string AI::getPixelColor(const Vec2& pos, Game& game, float currentTimeSec,
             SDL_Log("Framebuffer index out of bounds: index=%zu, size=%zu, pos=(%f, %f), x_read=%f, y_read=%f",
                     index, framebuffer.size(), pos.x, pos.y, x_read, y_read);
         }
-        return "black";
+        return CellType::Empty;
     }
 
-    unsigned char r = framebuffer[index];
-    unsigned char g = framebuffer[index + 1];
-    unsigned char b = framebuffer[index + 2];
-
+    CellType cell = CollisionGrid::classifyPixel(framebuffer[index], framebuffer[index + 1], framebuffer[index + 2]);
     if (config.ENABLE_DEBUG) {
-        SDL_Log("getPixelColor: pos=(%f, %f), x_read=%f, y_read=%f, color=(%d, %d, %d)",
-                pos.x, pos.y, x_read, y_read, r, g, b);
-    }
-
-    if (r == 0 && g == 0 && b == 0) return "black";
-    if (r == 0 && g == 255 && b == 0) return "green";
-    if (r == 255 && g == 0 && b == 255) return "magenta";
-    if (r == 0 && g == 0 && b == 255) return "blue";
-    if (r == 255 && g == 0 && b == 0) return "red";
-    if (r == 255 && g == 255 && b == 0) return "yellow";
-    return "other";
-}
\ No newline at end of file
+        SDL_Log("sampleCell: pos=(%f, %f), x_read=%f, y_read=%f, cell=%s",
+                pos.x, pos.y, x_read, y_read, CollisionGrid::colorName(cell));
+    }
+    return cell;
+}
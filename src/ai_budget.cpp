@@ -0,0 +1,38 @@
+#include "ai_budget.h"
+#include <algorithm>
+#include <iterator>
+#include <limits>
+
+namespace {
+const AIBudget::Tier TIERS[] = {
+    {"EASY", 250.0f, 1500},
+    {"NORMAL", 1000.0f, 6000},
+    {"HARD", 4000.0f, 20000},
+    {"UNLIMITED", 0.0f, 0},
+};
+}
+
+AIBudget::AIBudget(const GameConfig& config)
+    : tier(tierFor(config)),
+      until(std::chrono::steady_clock::time_point::max()) {}
+
+AIBudget::Tier AIBudget::tierFor(const GameConfig& config) {
+    int level = std::clamp(config.AI_DIFFICULTY, 0, static_cast<int>(std::size(TIERS)));
+    if (level > 0) return TIERS[level - 1];
+    return Tier{"CUSTOM", std::max(0.0f, config.AI_DECISION_BUDGET_US), std::max(0, config.AI_ASTAR_BUDGET)};
+}
+
+void AIBudget::start() {
+    until = tier.micros > 0.0f
+                ? std::chrono::steady_clock::now() + std::chrono::microseconds(static_cast<int64_t>(tier.micros))
+                : std::chrono::steady_clock::time_point::max();
+}
+
+bool AIBudget::expired() const {
+    return until != std::chrono::steady_clock::time_point::max() && std::chrono::steady_clock::now() >= until;
+}
+
+float AIBudget::remainingMicros() const {
+    if (until == std::chrono::steady_clock::time_point::max()) return std::numeric_limits<float>::infinity();
+    return std::chrono::duration<float, std::micro>(until - std::chrono::steady_clock::now()).count();
+}
@@ -0,0 +1,180 @@
+#include "ai_profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+AIProfiler::AIProfiler(bool enabled)
+    : enabled(enabled),
+      mutex(),
+      phases(),
+      counters(),
+      pending() {}
+
+// Bucket 0 is zero, bucket 1 up to BUCKET_FLOOR, and each one after an eighth of a doubling more
+int AIProfiler::bucketOf(float value) {
+    if (!(value > 0.0f)) return 0;
+    if (value <= BUCKET_FLOOR) return 1;
+    int bucket = 1 + static_cast<int>(std::ceil(std::log2(value / BUCKET_FLOOR) * BUCKETS_PER_DOUBLING));
+    return std::min(bucket, BUCKETS - 1);
+}
+
+float AIProfiler::bucketTop(int bucket) {
+    if (bucket == 0) return 0.0f;
+    return BUCKET_FLOOR * std::exp2(static_cast<float>(bucket - 1) / BUCKETS_PER_DOUBLING);
+}
+
+void AIProfiler::add(Series& series, float value) {
+    series.recent[series.nextSlot] = value;
+    series.nextSlot = (series.nextSlot + 1) % WINDOW;
+    series.filled = std::min(series.filled + 1, WINDOW);
+    series.buckets[bucketOf(value)]++;
+    series.count++;
+    series.total += value;
+    series.max = std::max(series.max, value);
+}
+
+void AIProfiler::record(Phase phase, float micros) {
+    std::lock_guard<std::mutex> lock(mutex);
+    add(phases[phase], micros);
+}
+
+void AIProfiler::endDecision() {
+    if (!isEnabled()) return;
+    std::lock_guard<std::mutex> lock(mutex);
+    for (int i = 0; i < COUNTER_COUNT; ++i) {
+        add(counters[i], static_cast<float>(pending[i]));
+        pending[i] = 0;
+    }
+}
+
+AIProfiler::Summary AIProfiler::rolling(const Series& series) const {
+    Summary summary{static_cast<uint64_t>(series.filled), 0.0, 0.0f, 0.0f, 0.0f, 0.0f};
+    if (series.filled == 0) return summary;
+    std::array<float, WINDOW> sorted;
+    std::copy(series.recent.begin(), series.recent.begin() + series.filled, sorted.begin());
+    auto at = [&](float fraction) {
+        int rank = std::min(series.filled - 1, static_cast<int>(fraction * series.filled));
+        std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.begin() + series.filled);
+        return sorted[rank];
+    };
+    double total = 0.0;
+    for (int i = 0; i < series.filled; ++i) {
+        total += series.recent[i];
+    }
+    summary.mean = total / series.filled;
+    summary.p50 = at(0.50f);
+    summary.p95 = at(0.95f);
+    summary.p99 = at(0.99f);
+    summary.max = *std::max_element(series.recent.begin(), series.recent.begin() + series.filled);
+    return summary;
+}
+
+// Percentiles to the top of the bucket they fall in, so up to 9% high
+AIProfiler::Summary AIProfiler::session(const Series& series) const {
+    Summary summary{series.count, 0.0, 0.0f, 0.0f, 0.0f, series.max};
+    if (series.count == 0) return summary;
+    summary.mean = series.total / series.count;
+    float* targets[3] = {&summary.p50, &summary.p95, &summary.p99};
+    const double fractions[3] = {0.50, 0.95, 0.99};
+    uint64_t seen = 0;
+    int next = 0;
+    for (int bucket = 0; bucket < BUCKETS && next < 3; ++bucket) {
+        seen += series.buckets[bucket];
+        while (next < 3 && seen > fractions[next] * series.count) {
+            *targets[next++] = std::min(bucketTop(bucket), series.max);
+        }
+    }
+    return summary;
+}
+
+AIProfiler::Summary AIProfiler::phase(Phase phase) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return rolling(phases[phase]);
+}
+
+AIProfiler::Summary AIProfiler::counter(Counter counter) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return rolling(counters[counter]);
+}
+
+AIProfiler::Summary AIProfiler::sessionPhase(Phase phase) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return session(phases[phase]);
+}
+
+AIProfiler::Summary AIProfiler::sessionCounter(Counter counter) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return session(counters[counter]);
+}
+
+std::vector<std::pair<float, uint64_t>> AIProfiler::histogram(Phase phase) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<std::pair<float, uint64_t>> buckets;
+    for (int bucket = 0; bucket < BUCKETS; ++bucket) {
+        if (phases[phase].buckets[bucket]) {
+            buckets.emplace_back(bucketTop(bucket), phases[phase].buckets[bucket]);
+        }
+    }
+    return buckets;
+}
+
+void AIProfiler::merge(const AIProfiler& other) {
+    if (&other == this) return;
+    std::scoped_lock lock(mutex, other.mutex);
+    auto mergeSeries = [](Series& into, const Series& from) {
+        for (int bucket = 0; bucket < BUCKETS; ++bucket) {
+            into.buckets[bucket] += from.buckets[bucket];
+        }
+        into.count += from.count;
+        into.total += from.total;
+        into.max = std::max(into.max, from.max);
+    };
+    for (int i = 0; i < PHASE_COUNT; ++i) {
+        mergeSeries(phases[i], other.phases[i]);
+    }
+    for (int i = 0; i < COUNTER_COUNT; ++i) {
+        mergeSeries(counters[i], other.counters[i]);
+    }
+}
+
+// One row per phase (microseconds) and per counter (per decision), over the whole session
+bool AIProfiler::writeCsv(const std::string& path) const {
+    FILE* file = std::fopen(path.c_str(), "w");
+    if (!file) return false;
+    std::fprintf(file, "series,unit,count,mean,p50,p95,p99,max\n");
+    auto row = [file](const char* name, const char* unit, const Summary& s) {
+        std::fprintf(file, "%s,%s,%llu,%.3f,%.3f,%.3f,%.3f,%.3f\n", name, unit,
+                     static_cast<unsigned long long>(s.count), s.mean, s.p50, s.p95, s.p99, s.max);
+    };
+    for (int i = 0; i < PHASE_COUNT; ++i) {
+        row(phaseName(static_cast<Phase>(i)), "us", sessionPhase(static_cast<Phase>(i)));
+    }
+    for (int i = 0; i < COUNTER_COUNT; ++i) {
+        row(counterName(static_cast<Counter>(i)), "per_decision", sessionCounter(static_cast<Counter>(i)));
+    }
+    return std::fclose(file) == 0;
+}
+
+const char* AIProfiler::phaseName(Phase phase) {
+    switch (phase) {
+        case COPY: return "copy";
+        case PREPARE: return "prepare";
+        case PLAN: return "plan";
+        case RAYCAST: return "raycast";
+        case TERRITORY: return "territory";
+        case SWEEP: return "sweep";
+        case SEARCH: return "search";
+        case DECISION: return "decision";
+        default: return "unknown";
+    }
+}
+
+const char* AIProfiler::counterName(Counter counter) {
+    switch (counter) {
+        case NODES: return "nodes";
+        case RAYS: return "rays";
+        case SAMPLES: return "samples";
+        case ROLLOUTS: return "rollouts";
+        default: return "unknown";
+    }
+}
@@ -0,0 +1,100 @@
+#include "astar.h"
+#include <algorithm>
+
+GridAStar::GridAStar(const GameConfig& config, float spacing)
+    : config(config),
+      spacing(spacing),
+      origin(0.0f, 0.0f),
+      cols(0),
+      rows(0),
+      g(),
+      f(),
+      parent(),
+      heapPos(),
+      stamp(),
+      heap(),
+      generation(0) {}
+
+// Line the lattice up with start and start a new generation; arrays only grow
+void GridAStar::prepare(const Vec2& start, float width, float height) {
+    origin = Vec2(start.x - std::floor(start.x / spacing) * spacing, start.y - std::floor(start.y / spacing) * spacing);
+    cols = std::max(1, static_cast<int>((width - origin.x) / spacing) + 1);
+    rows = std::max(1, static_cast<int>((height - origin.y) / spacing) + 1);
+    size_t count = static_cast<size_t>(cols) * rows;
+    if (stamp.size() < count) {
+        g.resize(count);
+        f.resize(count);
+        parent.resize(count);
+        heapPos.resize(count);
+        stamp.resize(count, 0);
+    }
+    if (++generation == 0) {
+        std::fill(stamp.begin(), stamp.end(), 0);
+        generation = 1;
+    }
+    heap.clear();
+}
+
+// Add a point to the heap, or lower its cost if it is already there
+void GridAStar::open(int node, float gCost, float fCost, int parentNode) {
+    g[node] = gCost;
+    f[node] = fCost;
+    parent[node] = parentNode;
+    if (stamp[node] == generation && heapPos[node] != CLOSED) {
+        siftUp(static_cast<size_t>(heapPos[node]));
+        return;
+    }
+    stamp[node] = generation;
+    heapPos[node] = static_cast<int32_t>(heap.size());
+    heap.push_back(node);
+    siftUp(heap.size() - 1);
+}
+
+int GridAStar::popBest() {
+    int node = heap.front();
+    heapPos[node] = CLOSED;
+    int last = heap.back();
+    heap.pop_back();
+    if (!heap.empty()) {
+        heap[0] = last;
+        heapPos[last] = 0;
+        siftDown(0);
+    }
+    return node;
+}
+
+void GridAStar::siftUp(size_t i) {
+    int node = heap[i];
+    while (i > 0) {
+        size_t up = (i - 1) / 2;
+        if (f[heap[up]] <= f[node]) break;
+        heap[i] = heap[up];
+        heapPos[heap[i]] = static_cast<int32_t>(i);
+        i = up;
+    }
+    heap[i] = node;
+    heapPos[node] = static_cast<int32_t>(i);
+}
+
+void GridAStar::siftDown(size_t i) {
+    int node = heap[i];
+    size_t count = heap.size();
+    while (true) {
+        size_t child = 2 * i + 1;
+        if (child >= count) break;
+        if (child + 1 < count && f[heap[child + 1]] < f[heap[child]]) ++child;
+        if (f[heap[child]] >= f[node]) break;
+        heap[i] = heap[child];
+        heapPos[heap[i]] = static_cast<int32_t>(i);
+        i = child;
+    }
+    heap[i] = node;
+    heapPos[node] = static_cast<int32_t>(i);
+}
+
+void GridAStar::tracePath(int node, std::vector<Vec2>& path) const {
+    for (int at = node; at != NO_PARENT; at = parent[at]) {
+        path.push_back(position(at));
+    }
+    std::reverse(path.begin(), path.end());
+}
@@ -1,41 +1,41 @@
 #include "circle.h"
-#include "game.h"
+#include "simulation.h"
 #include <algorithm>
 #include <random>
-#include <chrono>
 
-CircleManager::CircleManager(const GameConfig& config) : config(config) {}
+CircleManager::CircleManager(const GameConfig& config) : config(config), hits() {}
 
-void CircleManager::spawnInitialCircle(std::mt19937& rng, std::vector<Circle>& circles, const Game& game) {
-    std::uniform_real_distribution<float> distX(100.0f, game.orthoWidth - 100.0f);
-    std::uniform_real_distribution<float> distY(100.0f, game.orthoHeight - 100.0f);
+void CircleManager::spawnInitialCircle(std::mt19937& rng, std::vector<Circle>& circles, const Simulation& sim) {
+    std::uniform_real_distribution<float> distX(100.0f, sim.orthoWidth - 100.0f);
+    std::uniform_real_distribution<float> distY(100.0f, sim.orthoHeight - 100.0f);
     std::uniform_real_distribution<float> distVel(-config.CIRCLE_SPEED, config.CIRCLE_SPEED);
 
     Circle circle;
     circle.pos = Vec2(distX(rng), distY(rng));
     circle.prevPos = circle.pos;
+    circle.sweptPos = circle.pos;
     circle.vel = Vec2(distVel(rng), distVel(rng));
     circle.radius = config.CIRCLE_RADIUS;
     circle.SDLcirclecolor = {255, 0, 255, 255}; // Magenta
     circle.magentaTimer = 0.0f;
     circle.isYellow = false;
+    circle.swept = false;
     circles.push_back(circle);
 }
 
 void CircleManager::updateCircles(float dt, std::vector<Circle>& circles, std::mt19937& rng, float currentTimeSec,
-                                 std::chrono::steady_clock::time_point& lastCircleSpawn, Game& game) {
+                                 float& lastCircleSpawn, Simulation& sim) {
     for (auto& circle : circles) {
-        circle.prevPos = circle.pos;
         circle.pos += circle.vel * dt;
 
         // Bounce off walls
-        if (circle.pos.x - circle.radius < 10.0f || circle.pos.x + circle.radius > game.orthoWidth - 10.0f) {
+        if (circle.pos.x - circle.radius < 10.0f || circle.pos.x + circle.radius > sim.orthoWidth - 10.0f) {
             circle.vel.x = -circle.vel.x;
-            circle.pos.x = std::clamp(circle.pos.x, 10.0f + circle.radius, game.orthoWidth - 10.0f - circle.radius);
+            circle.pos.x = std::clamp(circle.pos.x, 10.0f + circle.radius, sim.orthoWidth - 10.0f - circle.radius);
         }
-        if (circle.pos.y - circle.radius < 10.0f || circle.pos.y + circle.radius > game.orthoHeight - 10.0f) {
+        if (circle.pos.y - circle.radius < 10.0f || circle.pos.y + circle.radius > sim.orthoHeight - 10.0f) {
             circle.vel.y = -circle.vel.y;
-            circle.pos.y = std::clamp(circle.pos.y, 10.0f + circle.radius, game.orthoHeight - 10.0f - circle.radius);
+            circle.pos.y = std::clamp(circle.pos.y, 10.0f + circle.radius, sim.orthoHeight - 10.0f - circle.radius);
         }
 
         // Update color timer
@@ -47,42 +47,59 @@ void CircleManager::updateCircles(float dt, std::vector<Circle>& circles, std::m
     }
 
     // Spawn new circles
-    auto now = std::chrono::steady_clock::now();
-    if (std::chrono::duration<float>(now - lastCircleSpawn).count() > config.CIRCLE_SPAWN_INTERVAL) {
-        spawnInitialCircle(rng, circles, game);
-        lastCircleSpawn = now;
-        if (game.config.ENABLE_DEBUG) {
+    if (currentTimeSec - lastCircleSpawn > config.CIRCLE_SPAWN_INTERVAL) {
+        spawnInitialCircle(rng, circles, sim);
+        lastCircleSpawn = currentTimeSec;
+        if (config.ENABLE_DEBUG) {
             SDL_Log("New circle spawned at time=%f, total circles=%zu", currentTimeSec, circles.size());
         }
     }
 }
 
-void CircleManager::clearTrails(const std::vector<Circle>& circles, Player& player1, Player& player2) {
-    auto clearTrail = [this](std::vector<Vec2>& trail, const Circle& circle) {
-        std::vector<Vec2> newTrail;
-        for (size_t i = 0; i < trail.size(); ++i) {
-            bool currentInside = (trail[i] - circle.pos).magnitude() < circle.radius;
-            if (!currentInside) {
-                newTrail.push_back(trail[i]);
-            }
-            // If transitioning from outside to inside or vice versa, add boundary points
-            if (i < trail.size() - 1) {
-                bool nextInside = (trail[i + 1] - circle.pos).magnitude() < circle.radius;
-                if (currentInside != nextInside) {
-                    // Interpolate boundary point
-                    Vec2 p1 = trail[i];
-                    Vec2 p2 = trail[i + 1];
-                    float t = 0.5f; // Approximate intersection
-                    Vec2 boundary = p1 + (p2 - p1) * t;
-                    if (!nextInside) newTrail.push_back(boundary);
+// Only segments in the area a circle moved into since the last call, plus segments drawn since then,
+// are looked at; each is cut exactly at the edge, splitting in place
+void CircleManager::clearTrails(std::vector<Circle>& circles, Simulation& sim) {
+    Player* players[2] = {&sim.player1, &sim.player2};
+    SegmentIndex& index = sim.segmentIndex;
+    for (auto& circle : circles) {
+        index.querySwept(circle.sweptPos, circle.pos, circle.radius, circle.swept, hits);
+        circle.sweptPos = circle.pos;
+        circle.swept = true;
+        for (uint32_t id : hits) {
+            int owner = index.entry(id).owner;
+            uint32_t slot = index.entry(id).slot;
+            uint32_t tick = index.entry(id).tick;
+            Trail& trail = players[owner]->trail;
+            long newSlot;
+            switch (trail.cutCircle(slot, circle.pos, circle.radius, newSlot)) {
+                case Trail::Cut::Missed:
+                    break;
+                case Trail::Cut::Shortened:
+                    index.reshape(id, trail[slot].a, trail[slot].b);
+                    break;
+                case Trail::Cut::Split: {
+                    index.reshape(id, trail[slot].a, trail[slot].b);
+                    const TrailSegment& piece = trail[static_cast<size_t>(newSlot)];
+                    uint32_t pieceId = index.insert(piece.a, piece.b, owner, static_cast<uint32_t>(newSlot), tick);
+                    trail.setIndexId(static_cast<size_t>(newSlot), pieceId);
+                    break;
                 }
+                case Trail::Cut::Removed:
+                    index.remove(id);
+                    break;
             }
         }
-        trail = newTrail;
-    };
-
-    for (const auto& circle : circles) {
-        clearTrail(player1.trail, circle);
-        clearTrail(player2.trail, circle);
+        sim.player1.trail.breakTipInCircle(circle.pos, circle.radius);
+        sim.player2.trail.breakTipInCircle(circle.pos, circle.radius);
+        bool erased = !hits.empty(); // a stroke reaches in, even if its line was missed
+        if (config.COLLISION_MODE != 2) {
+            erased = sim.collisionGrid.eraseCircle(circle.pos, circle.radius) || erased;
+        }
+        // Readers of the trail changes (the AI's distance field) must drop what was erased too
+        if (erased) {
+            float reach = circle.radius + config.TRAIL_SIZE;
+            sim.noteTrailChange(circle.pos.x - reach, circle.pos.y - reach, circle.pos.x + reach, circle.pos.y + reach);
+        }
     }
-}
\ No newline at end of file
+    index.finishSweep();
+}
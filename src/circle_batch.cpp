@@ -0,0 +1,79 @@
+#include "circle_batch.h"
+#include <algorithm>
+#include <cmath>
+
+CircleBatch::CircleBatch() : unitCircles(), positions(), colors(), vbo(0), capacity(0) {
+    for (size_t level = 0; level < LEVELS.size(); ++level) {
+        int segments = LEVELS[level];
+        unitCircles[level].reserve(segments + 1);
+        for (int i = 0; i <= segments; ++i) {
+            float angle = 2.0f * M_PI * (i % segments) / segments;
+            unitCircles[level].emplace_back(std::cos(angle), std::sin(angle));
+        }
+    }
+}
+
+// The edge strays r * (1 - cos(pi / n)) from round between points
+size_t CircleBatch::levelFor(float radius) {
+    for (size_t level = 0; level < LEVELS.size(); ++level) {
+        if (radius * (1.0f - std::cos(static_cast<float>(M_PI) / LEVELS[level])) <= MAX_EDGE_ERROR) return level;
+    }
+    return LEVELS.size() - 1;
+}
+
+void CircleBatch::add(float x, float y, float radius, const SDL_Color& color) {
+    size_t level = levelFor(radius);
+    int segments = LEVELS[level];
+    const std::vector<Vec2>& unit = unitCircles[level];
+    for (int i = 0; i < segments; ++i) {
+        const float triangle[6] = {x, y,
+                                   x + radius * unit[i].x, y + radius * unit[i].y,
+                                   x + radius * unit[i + 1].x, y + radius * unit[i + 1].y};
+        positions.insert(positions.end(), triangle, triangle + 6);
+    }
+    for (int i = 0; i < segments * 3; ++i) {
+        colors.insert(colors.end(), {color.r, color.g, color.b, color.a});
+    }
+}
+
+int CircleBatch::flush() {
+    if (positions.empty()) return 0;
+    size_t positionBytes = positions.size() * sizeof(float);
+    size_t bytes = positionBytes + colors.size();
+    if (vbo == 0) {
+        glGenBuffers(1, &vbo);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    capacity = std::max(capacity, bytes);
+    glBufferData(GL_ARRAY_BUFFER, capacity, nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, positionBytes, positions.data());
+    glBufferSubData(GL_ARRAY_BUFFER, positionBytes, colors.size(), colors.data());
+
+    GLsizei vertices = static_cast<GLsizei>(positions.size() / 2);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(2, GL_FLOAT, 0, nullptr);
+    // Black circle to erase trails
+    glColor4ub(0, 0, 0, 255);
+    glDrawArrays(GL_TRIANGLES, 0, vertices);
+    // Colored circle (magenta or yellow)
+    glEnableClientState(GL_COLOR_ARRAY);
+    glColorPointer(4, GL_UNSIGNED_BYTE, 0, reinterpret_cast<const void*>(positionBytes));
+    glDrawArrays(GL_TRIANGLES, 0, vertices);
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    positions.clear();
+    colors.clear();
+    return 2;
+}
+
+void CircleBatch::shutdown() {
+    if (vbo != 0) {
+        glDeleteBuffers(1, &vbo);
+        vbo = 0;
+    }
+    capacity = 0;
+    positions.clear();
+    colors.clear();
+}
@@ -0,0 +1,241 @@
+#include "distance_field.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+DistanceField::DistanceField(const GameConfig& config)
+    : config(config),
+      cellSize(std::max(config.DISTANCE_FIELD_CELL_SIZE, 1.0f)),
+      cols(0),
+      rows(0),
+      tileCols(0),
+      tileRows(0),
+      everything(true),
+      pending(),
+      occupancy(),
+      trail(),
+      tileDirty(),
+      dirtyTiles(),
+      circles(),
+      circleRects() {}
+
+void DistanceField::resize(float width, float height) {
+    int newCols = std::max(1, static_cast<int>(std::ceil(width / cellSize)));
+    int newRows = std::max(1, static_cast<int>(std::ceil(height / cellSize)));
+    if (newCols == cols && newRows == rows) return;
+    cols = newCols;
+    rows = newRows;
+    tileCols = (cols + TILE_CELLS - 1) / TILE_CELLS;
+    tileRows = (rows + TILE_CELLS - 1) / TILE_CELLS;
+    size_t count = static_cast<size_t>(cols) * rows;
+    occupancy.assign(count, 0);
+    trail.assign(count, getReach());
+    tileDirty.assign(static_cast<size_t>(tileCols) * tileRows, 0);
+    circles.assign(count, FAR);
+    circleRects.clear();
+    invalidate();
+}
+
+void DistanceField::invalidate() {
+    everything = true;
+    pending.clear();
+}
+
+void DistanceField::markChanged(float minX, float minY, float maxX, float maxY) {
+    if (!everything && cols > 0) {
+        pending.push_back(cellRect(minX, minY, maxX, maxY));
+    }
+}
+
+size_t DistanceField::cellAt(const Vec2& pos) const {
+    int x = std::clamp(static_cast<int>(pos.x / cellSize), 0, cols - 1);
+    int y = std::clamp(static_cast<int>(pos.y / cellSize), 0, rows - 1);
+    return static_cast<size_t>(y) * cols + x;
+}
+
+DistanceField::Rect DistanceField::cellRect(float minX, float minY, float maxX, float maxY) const {
+    Rect r;
+    r.x0 = std::max(0, static_cast<int>(std::floor(minX / cellSize)));
+    r.y0 = std::max(0, static_cast<int>(std::floor(minY / cellSize)));
+    r.x1 = std::min(cols - 1, static_cast<int>(std::floor(maxX / cellSize)));
+    r.y1 = std::min(rows - 1, static_cast<int>(std::floor(maxY / cellSize)));
+    return r;
+}
+
+float DistanceField::trailDistance(const Vec2& pos) const {
+    // Both the trail and pos may sit anywhere in their cells
+    return std::max(0.0f, trail[cellAt(pos)] - cellSize * 1.4143f);
+}
+
+void DistanceField::refreshOccupancy(const Rect& r, const std::function<bool(float, float, float, float)>& occupied) {
+    const float INSIDE = cellSize * 0.999f; // keep the box off the next cell's edge
+    for (int y = r.y0; y <= r.y1; ++y) {
+        for (int x = r.x0; x <= r.x1; ++x) {
+            float minX = x * cellSize, minY = y * cellSize;
+            occupancy[static_cast<size_t>(y) * cols + x] = occupied(minX, minY, minX + INSIDE, minY + INSIDE) ? 1 : 0;
+        }
+    }
+}
+
+void DistanceField::update(const std::function<bool(float, float, float, float)>& occupied, ThreadPool& pool) {
+    if (cols == 0) return;
+    dirtyTiles.clear();
+    // Past half the board, one parallel pass beats going cell by cell
+    float changed = 0.0f;
+    for (const Rect& r : pending) {
+        if (r.x0 > r.x1 || r.y0 > r.y1) continue;
+        changed += static_cast<float>(r.x1 - r.x0 + 1) * (r.y1 - r.y0 + 1);
+    }
+    if (changed > 0.5f * cols * rows) {
+        everything = true;
+    }
+    if (everything) {
+        int bands = pool.size() * 2;
+        pool.parallelFor(bands, [&](int band) {
+            refreshOccupancy(Rect{0, rows * band / bands, cols - 1, rows * (band + 1) / bands - 1}, occupied);
+        });
+        for (int tile = 0; tile < tileCols * tileRows; ++tile) {
+            dirtyTiles.push_back(tile);
+        }
+        everything = false;
+    } else {
+        // A cell's distance can only change if a changed cell lies within reach of it
+        for (const Rect& r : pending) {
+            if (r.x0 > r.x1 || r.y0 > r.y1) continue;
+            refreshOccupancy(r, occupied);
+            int tx0 = std::max(0, (r.x0 - REACH_CELLS) / TILE_CELLS);
+            int ty0 = std::max(0, (r.y0 - REACH_CELLS) / TILE_CELLS);
+            int tx1 = std::min(tileCols - 1, (r.x1 + REACH_CELLS) / TILE_CELLS);
+            int ty1 = std::min(tileRows - 1, (r.y1 + REACH_CELLS) / TILE_CELLS);
+            for (int ty = ty0; ty <= ty1; ++ty) {
+                for (int tx = tx0; tx <= tx1; ++tx) {
+                    int tile = ty * tileCols + tx;
+                    if (!tileDirty[tile]) {
+                        tileDirty[tile] = 1;
+                        dirtyTiles.push_back(tile);
+                    }
+                }
+            }
+        }
+    }
+    pending.clear();
+
+    pool.parallelFor(static_cast<int>(dirtyTiles.size()), [&](int i) { computeTile(dirtyTiles[i]); });
+    for (int tile : dirtyTiles) {
+        tileDirty[tile] = 0;
+    }
+}
+
+// Transform the tile plus an apron of reach around it, which holds every trail that can be
+// within reach of the tile, then keep the tile's part
+void DistanceField::computeTile(int tile) {
+    int tx0 = (tile % tileCols) * TILE_CELLS;
+    int ty0 = (tile / tileCols) * TILE_CELLS;
+    int tx1 = std::min(cols, tx0 + TILE_CELLS);
+    int ty1 = std::min(rows, ty0 + TILE_CELLS);
+    int wx0 = std::max(0, tx0 - REACH_CELLS);
+    int wy0 = std::max(0, ty0 - REACH_CELLS);
+    int wx1 = std::min(cols, tx1 + REACH_CELLS);
+    int wy1 = std::min(rows, ty1 + REACH_CELLS);
+    int w = wx1 - wx0;
+    int h = wy1 - wy0;
+    int longest = std::max(w, h);
+
+    // Scratch kept per thread; tiles are recomputed every decision
+    static thread_local std::vector<float> window, f, d, z;
+    static thread_local std::vector<int> v;
+    window.resize(static_cast<size_t>(w) * h);
+    f.resize(longest);
+    d.resize(longest);
+    z.resize(longest + 1);
+    v.resize(longest);
+    std::vector<uint8_t> rowHasTrail(h, 0);
+    for (int y = 0; y < h; ++y) {
+        const uint8_t* row = &occupancy[static_cast<size_t>(wy0 + y) * cols + wx0];
+        for (int x = 0; x < w; ++x) {
+            window[static_cast<size_t>(y) * w + x] = row[x] ? 0.0f : FAR;
+            rowHasTrail[y] |= row[x];
+        }
+    }
+    float reach = getReach();
+    if (std::find(rowHasTrail.begin(), rowHasTrail.end(), 1) == rowHasTrail.end()) {
+        for (int y = ty0; y < ty1; ++y) {
+            std::fill(&trail[static_cast<size_t>(y) * cols + tx0], &trail[static_cast<size_t>(y) * cols + tx1], reach);
+        }
+        return;
+    }
+    // Squared distances down each column, then along the tile's rows; a column with no trail stays FAR
+    for (int x = 0; x < w; ++x) {
+        bool any = false;
+        for (int y = 0; y < h; ++y) {
+            f[y] = window[static_cast<size_t>(y) * w + x];
+            any |= f[y] == 0.0f;
+        }
+        if (!any) continue;
+        transform1D(f.data(), h, d.data(), v.data(), z.data());
+        for (int y = 0; y < h; ++y) window[static_cast<size_t>(y) * w + x] = d[y];
+    }
+    for (int y = ty0; y < ty1; ++y) {
+        transform1D(&window[static_cast<size_t>(y - wy0) * w], w, d.data(), v.data(), z.data());
+        float* out = &trail[static_cast<size_t>(y) * cols];
+        for (int x = tx0; x < tx1; ++x) {
+            out[x] = std::min(std::sqrt(d[x - wx0]) * cellSize, reach);
+        }
+    }
+}
+
+// Where the parabolas rooted at q and p cross
+static float intersection(const float* f, int q, int p) {
+    return ((f[q] + static_cast<float>(q) * q) - (f[p] + static_cast<float>(p) * p)) / (2.0f * (q - p));
+}
+
+// Lower envelope of the parabolas rooted at each sample: d[q] = min over p of (q - p)^2 + f[p]
+void DistanceField::transform1D(const float* f, int n, float* d, int* v, float* z) {
+    const float INF = std::numeric_limits<float>::infinity();
+    int k = 0;
+    v[0] = 0;
+    z[0] = -INF;
+    z[1] = INF;
+    for (int q = 1; q < n; ++q) {
+        float s = intersection(f, q, v[k]);
+        while (s <= z[k]) {
+            --k; // z[0] is -infinity, so this stops at the first parabola
+            s = intersection(f, q, v[k]);
+        }
+        ++k;
+        v[k] = q;
+        z[k] = s;
+        z[k + 1] = INF;
+    }
+    k = 0;
+    for (int q = 0; q < n; ++q) {
+        while (z[k + 1] < q) ++k;
+        float dq = static_cast<float>(q - v[k]);
+        d[q] = dq * dq + f[v[k]];
+    }
+}
+
+// Distance from each cell centre to the nearest circle's edge, out to reach past the edge
+void DistanceField::stampCircles(const std::vector<Circle>& circleList, float reach) {
+    if (cols == 0) return;
+    for (const Rect& r : circleRects) {
+        for (int y = r.y0; y <= r.y1; ++y) {
+            std::fill(&circles[static_cast<size_t>(y) * cols + r.x0], &circles[static_cast<size_t>(y) * cols + r.x1] + 1, FAR);
+        }
+    }
+    circleRects.clear();
+    for (const Circle& circle : circleList) {
+        float extent = circle.radius + reach;
+        Rect r = cellRect(circle.pos.x - extent, circle.pos.y - extent, circle.pos.x + extent, circle.pos.y + extent);
+        if (r.x0 > r.x1 || r.y0 > r.y1) continue;
+        circleRects.push_back(r);
+        for (int y = r.y0; y <= r.y1; ++y) {
+            float dy = (y + 0.5f) * cellSize - circle.pos.y;
+            float* row = &circles[static_cast<size_t>(y) * cols];
+            for (int x = r.x0; x <= r.x1; ++x) {
+                float dx = (x + 0.5f) * cellSize - circle.pos.x;
+                row[x] = std::min(row[x], std::sqrt(dx * dx + dy * dy) - circle.radius);
+            }
+        }
+    }
+}
@@ -0,0 +1,302 @@
+#include "dstar_lite.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+const float INF = std::numeric_limits<float>::infinity();
+const int DX[8] = {1, -1, 0, 0, 1, 1, -1, -1};
+const int DY[8] = {0, 0, 1, -1, 1, -1, 1, -1};
+}
+
+DStarLite::DStarLite(const GameConfig& config, float spacing)
+    : config(config),
+      spacing(spacing),
+      origin(0.0f, 0.0f),
+      goalPos(0.0f, 0.0f),
+      boardWidth(0.0f),
+      boardHeight(0.0f),
+      cols(0),
+      rows(0),
+      goalNode(0),
+      startNode(0),
+      lastNode(0),
+      km(0.0f),
+      initialized(false),
+      passable(nullptr),
+      g(),
+      rhs(),
+      state(),
+      keys(),
+      heapPos(),
+      heap(),
+      changes(),
+      stats{0, 0, 0, false, false},
+      fullStats{0, 0, 0, false, false} {}
+
+void DStarLite::reset() {
+    initialized = false;
+    changes.clear();
+}
+
+void DStarLite::markChanged(float minX, float minY, float maxX, float maxY) {
+    if (initialized) {
+        changes.push_back(Box{minX, minY, maxX, maxY});
+    }
+}
+
+int DStarLite::nodeNear(const Vec2& pos) const {
+    int x = std::clamp(static_cast<int>(std::lround((pos.x - origin.x) / spacing)), 0, cols - 1);
+    int y = std::clamp(static_cast<int>(std::lround((pos.y - origin.y) / spacing)), 0, rows - 1);
+    return y * cols + x;
+}
+
+// Fresh search toward goal: every point unknown, only the goal queued
+void DStarLite::initialize(const Vec2& goal, float width, float height) {
+    goalPos = goal;
+    boardWidth = width;
+    boardHeight = height;
+    origin = Vec2(goal.x - std::floor(goal.x / spacing) * spacing, goal.y - std::floor(goal.y / spacing) * spacing);
+    cols = std::max(1, static_cast<int>((width - origin.x) / spacing) + 1);
+    rows = std::max(1, static_cast<int>((height - origin.y) / spacing) + 1);
+    size_t count = static_cast<size_t>(cols) * rows;
+    g.assign(count, INF);
+    rhs.assign(count, INF);
+    state.assign(count, UNKNOWN);
+    keys.resize(count);
+    heapPos.assign(count, NOT_QUEUED);
+    heap.clear();
+    changes.clear();
+    km = 0.0f;
+    goalNode = nodeNear(goal);
+    state[goalNode] = FREE; // the square itself is never an obstacle
+    rhs[goalNode] = 0.0f;
+    initialized = true;
+}
+
+bool DStarLite::blocked(int node) {
+    if (state[node] == UNKNOWN) {
+        state[node] = (*passable)(position(node)) ? FREE : BLOCKED;
+    }
+    return state[node] == BLOCKED;
+}
+
+// Entering a blocked point is impossible; leaving one is allowed so a start on one still plans
+float DStarLite::edgeCost(int from, int to) {
+    if (blocked(to)) return INF;
+    bool straight = (from % cols == to % cols) || (from / cols == to / cols);
+    return straight ? spacing : spacing * 1.41421356f;
+}
+
+float DStarLite::heuristic(int a, int b) const {
+    return (position(a) - position(b)).magnitude();
+}
+
+DStarLite::Key DStarLite::calculateKey(int node) const {
+    float m = std::min(g[node], rhs[node]);
+    return Key{m + heuristic(startNode, node) + km, m};
+}
+
+void DStarLite::updateVertex(int node) {
+    if (node != goalNode) {
+        float best = INF;
+        int x = node % cols;
+        int y = node / cols;
+        for (int k = 0; k < 8; ++k) {
+            int nx = x + DX[k];
+            int ny = y + DY[k];
+            if (nx < 0 || ny < 0 || nx >= cols || ny >= rows) continue;
+            int next = ny * cols + nx;
+            if (g[next] == INF) continue;
+            best = std::min(best, edgeCost(node, next) + g[next]);
+        }
+        rhs[node] = best;
+        ++stats.updated;
+    }
+    if (g[node] != rhs[node]) {
+        heapSet(node, calculateKey(node));
+    } else {
+        heapRemove(node);
+    }
+}
+
+void DStarLite::computeShortestPath(const SearchLimit& limit) {
+    stats.complete = false;
+    while (!heap.empty() && (keys[heap[0]] < calculateKey(startNode) || rhs[startNode] != g[startNode])) {
+        if (limit.reached(stats.expanded)) return;
+        ++stats.expanded;
+        int u = heap[0];
+        Key oldKey = keys[u];
+        Key newKey = calculateKey(u);
+        int x = u % cols;
+        int y = u / cols;
+        if (oldKey < newKey) {
+            heapSet(u, newKey);
+            continue;
+        }
+        if (g[u] > rhs[u]) {
+            g[u] = rhs[u];
+            heapRemove(u);
+        } else {
+            g[u] = INF;
+            updateVertex(u);
+        }
+        for (int k = 0; k < 8; ++k) {
+            int nx = x + DX[k];
+            int ny = y + DY[k];
+            if (nx < 0 || ny < 0 || nx >= cols || ny >= rows) continue;
+            updateVertex(ny * cols + nx);
+        }
+    }
+    stats.complete = true;
+}
+
+// Test known points in the changed boxes again; a point that flipped changes the edges into it
+void DStarLite::applyChanges() {
+    for (const Box& box : changes) {
+        int x0 = std::max(0, static_cast<int>(std::ceil((box.minX - origin.x) / spacing)));
+        int y0 = std::max(0, static_cast<int>(std::ceil((box.minY - origin.y) / spacing)));
+        int x1 = std::min(cols - 1, static_cast<int>(std::floor((box.maxX - origin.x) / spacing)));
+        int y1 = std::min(rows - 1, static_cast<int>(std::floor((box.maxY - origin.y) / spacing)));
+        for (int y = y0; y <= y1; ++y) {
+            for (int x = x0; x <= x1; ++x) {
+                int node = y * cols + x;
+                if (state[node] == UNKNOWN || node == goalNode) continue;
+                ++stats.rechecked;
+                uint8_t now = (*passable)(position(node)) ? FREE : BLOCKED;
+                if (now == state[node]) continue;
+                state[node] = now;
+                for (int k = 0; k < 8; ++k) {
+                    int nx = x + DX[k];
+                    int ny = y + DY[k];
+                    if (nx < 0 || ny < 0 || nx >= cols || ny >= rows) continue;
+                    updateVertex(ny * cols + nx);
+                }
+            }
+        }
+    }
+    changes.clear();
+}
+
+// Walk downhill in g from the start; a cap on steps guards against loops while costs are unsettled
+void DStarLite::extractPath(std::vector<Vec2>& path) {
+    path.clear();
+    if (g[startNode] == INF) return;
+    int current = startNode;
+    path.push_back(position(current));
+    size_t maxSteps = static_cast<size_t>(cols) * rows;
+    while (current != goalNode) {
+        int x = current % cols;
+        int y = current / cols;
+        int bestNext = -1;
+        float best = INF;
+        for (int k = 0; k < 8; ++k) {
+            int nx = x + DX[k];
+            int ny = y + DY[k];
+            if (nx < 0 || ny < 0 || nx >= cols || ny >= rows) continue;
+            int next = ny * cols + nx;
+            if (g[next] == INF) continue;
+            float cost = edgeCost(current, next) + g[next];
+            if (cost < best) {
+                best = cost;
+                bestNext = next;
+            }
+        }
+        if (bestNext < 0 || path.size() > maxSteps) {
+            path.clear();
+            return;
+        }
+        current = bestNext;
+        path.push_back(position(current));
+    }
+}
+
+DStarLite::Stats DStarLite::plan(const Vec2& start, const Vec2& goal, float width, float height,
+                                 const std::function<bool(const Vec2&)>& passable, const SearchLimit& limit,
+                                 std::vector<Vec2>& path) {
+    stats = Stats{0, 0, 0, false, false};
+    this->passable = &passable;
+
+    // Changes over most of the board cost more to repair than a new search
+    float changedArea = 0.0f;
+    for (const Box& box : changes) {
+        changedArea += std::max(0.0f, box.maxX - box.minX) * std::max(0.0f, box.maxY - box.minY);
+    }
+    bool restart = !initialized || (goal - goalPos).magnitude() > 0.5f || width != boardWidth ||
+                   height != boardHeight || changedArea > 0.5f * width * height;
+
+    if (restart) {
+        initialize(goal, width, height);
+        startNode = lastNode = nodeNear(start);
+        heapSet(goalNode, calculateKey(goalNode));
+        stats.fullSearch = true;
+    } else {
+        startNode = nodeNear(start);
+        km += heuristic(lastNode, startNode);
+        lastNode = startNode;
+        applyChanges();
+    }
+
+    computeShortestPath(limit);
+    extractPath(path);
+    if (stats.fullSearch) {
+        fullStats = stats;
+    }
+    this->passable = nullptr;
+    return stats;
+}
+
+void DStarLite::heapSet(int node, const Key& key) {
+    keys[node] = key;
+    if (heapPos[node] == NOT_QUEUED) {
+        heapPos[node] = static_cast<int32_t>(heap.size());
+        heap.push_back(node);
+        siftUp(heap.size() - 1);
+    } else {
+        siftUp(static_cast<size_t>(heapPos[node]));
+        siftDown(static_cast<size_t>(heapPos[node]));
+    }
+}
+
+void DStarLite::heapRemove(int node) {
+    int32_t i = heapPos[node];
+    if (i == NOT_QUEUED) return;
+    heapPos[node] = NOT_QUEUED;
+    int last = heap.back();
+    heap.pop_back();
+    if (last != node) {
+        heap[i] = last;
+        heapPos[last] = i;
+        siftUp(static_cast<size_t>(i));
+        siftDown(static_cast<size_t>(heapPos[last]));
+    }
+}
+
+void DStarLite::siftUp(size_t i) {
+    int node = heap[i];
+    while (i > 0) {
+        size_t up = (i - 1) / 2;
+        if (!(keys[node] < keys[heap[up]])) break;
+        heap[i] = heap[up];
+        heapPos[heap[i]] = static_cast<int32_t>(i);
+        i = up;
+    }
+    heap[i] = node;
+    heapPos[node] = static_cast<int32_t>(i);
+}
+
+void DStarLite::siftDown(size_t i) {
+    int node = heap[i];
+    size_t count = heap.size();
+    while (true) {
+        size_t child = 2 * i + 1;
+        if (child >= count) break;
+        if (child + 1 < count && keys[heap[child + 1]] < keys[heap[child]]) ++child;
+        if (!(keys[heap[child]] < keys[node])) break;
+        heap[i] = heap[child];
+        heapPos[heap[i]] = static_cast<int32_t>(i);
+        i = child;
+    }
+    heap[i] = node;
+    heapPos[node] = static_cast<int32_t>(i);
+}
@@ -9,16 +9,11 @@
 #include <memory>
 #include "types.h"
 #include "render.h"
-#include "collectible.h"
 #include "collision.h"
-#include "explosion.h"
+#include "simulation.h"
 #include "input.h"
-#include "circle.h"
-#include "player.h"
 #include "ai.h"
 
-float dt = 0.0f; // Define the global dt variable
-
 // Constructor: Initialize game with given configuration
 Game::Game(const GameConfig& config)
     : SDLaicolor{255, 0, 0}, // red, per game.h
@@ -26,50 +21,30 @@ Game::Game(const GameConfig& config)
       window(nullptr),
       glContext(nullptr),
       config(config),
+      sim(config, std::random_device()()),
       audio(config),
-      collectibleManager(config),
       collisionManager(config),
+      readbackManager(config),
       renderManager(config),
-      circleManager(config),
-      explosionManager(config),
       inputManager(),
-      playerManager(new PlayerManager(config)),
-      ai(new AI(config, *this)),
+      ai(new AI(config, sim, 1)),
       splashTexture{0},
       isSplashScreen{true},
       paused{false},
+      showAIStats{false},
       controllers{nullptr, nullptr},
       controllerCount{0},
-      player1(),
-      player2(),
-      circles(),
-      collectible(),
-      explosions(),
-      flashes(),
-      rng(std::random_device()()),
       lastBoopTime{0.0f},
-      score1{0},
-      score2{0},
-      roundScore1{0},
-      roundScore2{0},
-      setScore1{0},
-      setScore2{0},
       gameOver{false},
       gameOverScreen{false},
       winnerDeclared{false},
       firstFrame{true},
-      lastCircleSpawn{std::chrono::steady_clock::now()},
       gameOverTime{std::chrono::steady_clock::now()},
       lastWinnerVoiceTime{0.0f},
-      deathTime{0.0f},
-      orthoWidth{static_cast<float>(config.WIDTH)},
-      orthoHeight{static_cast<float>(config.HEIGHT)},
       frameRendered{false},
-      winningScore{0.0f},
-      greenSquarePoints{0.0f},
-      deathPoints{0.0f},
-      collectibleCollectedThisFrame{false},
-      pendingCollectibleRespawn{false} {
+      accumulator{0.0f},
+      renderAlpha{0.0f},
+      pendingFlash{false, false} {
     // Initialize SDL
     if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_GAMECONTROLLER) < 0) {
         SDL_Log("SDL_Init failed: %s", SDL_GetError());
@@ -148,8 +123,12 @@ Game::~Game() {
     if (splashTexture) {
         glDeleteTextures(1, &splashTexture);
     }
+    readbackManager.shutdown();
+    renderManager.shutdown();
+    if (config.AI_PROFILE && !ai->getProfiler().writeCsv("ai_profile.csv")) {
+        SDL_Log("Failed to write ai_profile.csv");
+    }
     delete ai;
-    delete playerManager;
     for (int i = 0; i < controllerCount; ++i) {
         if (controllers[i]) {
             SDL_GameControllerClose(controllers[i]);
@@ -166,125 +145,57 @@ Game::~Game() {
 }
 
 
-// Check collision for a player at the next position
-void Game::checkCollision(Player* player, Vec2 nextPos, float currentTimeSec, const std::vector<unsigned char>& framebuffer, int drawableWidth, int drawableHeight) {
-    if (!player->alive || player->willDie) return;
-
-    // Geometric check for green square collection
-    if (collectible.active && !collectibleCollectedThisFrame) {
-        // Normalize coordinates to ortho space
-        Vec2 normalizedPlayerPos = nextPos;
-        Vec2 normalizedCollectiblePos = collectible.pos;
-        float halfSize = collectible.size / 2.0f;
-
-        bool withinX = normalizedPlayerPos.x >= normalizedCollectiblePos.x - halfSize &&
-                       normalizedPlayerPos.x <= normalizedCollectiblePos.x + halfSize;
-        bool withinY = normalizedPlayerPos.y >= normalizedCollectiblePos.y - halfSize &&
-                       normalizedPlayerPos.y <= normalizedCollectiblePos.y + halfSize;
-
-        if (withinX && withinY) {
-            handleGreenSquareCollection(player, currentTimeSec);
-        } else if (config.ENABLE_DEBUG) {
-            SDL_Log("Green square check failed for player %s: playerPos=(%f, %f), collectible=(%f, %f, size=%f), withinX=%d, withinY=%d, active=%d, drawable=(%d, %d)",
-                    player == &player1 ? "1" : "2", normalizedPlayerPos.x, normalizedPlayerPos.y,
-                    normalizedCollectiblePos.x, normalizedCollectiblePos.y, collectible.size,
-                    withinX, withinY, collectible.active, drawableWidth, drawableHeight);
+// Controller triggers and the A button for both players this frame
+InputFrame Game::readControllers() {
+    InputFrame input;
+    for (int i = 0; i < 2; ++i) {
+        if (i < controllerCount && controllers[i] && SDL_GameControllerGetAttached(controllers[i])) {
+            Sint16 leftTrigger = SDL_GameControllerGetAxis(controllers[i], SDL_CONTROLLER_AXIS_TRIGGERLEFT);
+            Sint16 rightTrigger = SDL_GameControllerGetAxis(controllers[i], SDL_CONTROLLER_AXIS_TRIGGERRIGHT);
+            input.leftTrigger[i] = leftTrigger / 32768.0f;
+            input.rightTrigger[i] = rightTrigger / 32768.0f;
+            input.aButton[i] = SDL_GameControllerGetButton(controllers[i], SDL_CONTROLLER_BUTTON_A);
         }
+        input.aButton[i] = input.aButton[i] || pendingFlash[i];
+        pendingFlash[i] = false;
     }
+    return input;
+}
 
-    // Framebuffer-based collision check - black green magenta safe colors
-    Vec2 checkPos = nextPos + player->direction * (config.PLAYER_SIZE / 2.0f);
-    checkPos.x = std::max(10.0f, std::min(checkPos.x, orthoWidth - 10.0f));
-    checkPos.y = std::max(10.0f, std::min(checkPos.y, orthoHeight - 10.0f));
-
-    float x_read = (checkPos.x / orthoWidth) * drawableWidth;
-    float y_read = (1 - checkPos.y / orthoHeight) * drawableHeight;
-
-    x_read = std::max(0.0f, std::min(x_read, static_cast<float>(drawableWidth - 1)));
-    y_read = std::max(0.0f, std::min(y_read, static_cast<float>(drawableHeight - 1)));
-
-    int index = (static_cast<int>(y_read) * drawableWidth + static_cast<int>(x_read)) * 3;
-    unsigned char r = framebuffer[index];
-    unsigned char g = framebuffer[index + 1];
-    unsigned char b = framebuffer[index + 2];
-
-    bool isBlack = r == 0 && g == 0 && b == 0;
-    bool isGreen = r == 0 && g == 255 && b == 0;
-    bool isMagenta = r == 255 && g == 0 && b == 255;
-
-    if (config.ENABLE_DEBUG) {
-        SDL_Log("Collision check at gamePos=(%f, %f), screenPos=(%f, %f), color=(%d, %d, %d), isBlack=%d, isGreen=%d, isMagenta=%d, collectible.active=%d",
-                checkPos.x, checkPos.y, x_read, y_read, r, g, b, isBlack, isGreen, isMagenta, collectible.active);
-    }
-
-    if (player->noCollisionTimer > 0) return;
-
-    if (!isBlack && !isMagenta && !isGreen) {
-        player->willDie = true;
-        explosions.emplace_back(explosionManager.createExplosion(nextPos, rng, dt, currentTimeSec, SDLexplosioncolor));
-        audio.playExplosion(currentTimeSec);
-        deathTime = currentTimeSec;
-        if (config.ENABLE_DEBUG) {
-            SDL_Log("Player %s died at (%f, %f) due to unsafe color (R=%d, G=%d, B=%d), hasMoved=%d",
-                    player == &player1 ? "1" : "2", nextPos.x, nextPos.y, r, g, b, player->hasMoved);
-        }
+void Game::requestFlash(int controllerIndex) {
+    if (controllerIndex >= 0 && controllerIndex < 2) {
+        pendingFlash[controllerIndex] = true;
     }
 }
 
-// Handle collection of green square
-void Game::handleGreenSquareCollection(Player* player, float currentTimeSec) {
-    if (!player->collectedGreenThisFrame && !collectibleCollectedThisFrame && collectible.active) {
-        player->collectedGreenThisFrame = true;
-        collectibleCollectedThisFrame = true;
-        collectible.active = false; // Disable collectible until respawn
-        pendingCollectibleRespawn = true; // Defer respawn to Game::update
-        int points = 1; // Green square always awards 1 point
-        if (player == &player1) {
-            score1 += points;
-            roundScore1 += points;
-        } else {
-            score2 += points;
-            roundScore2 += points;
+// One fixed tick: controllers and the AI fill an InputFrame, the simulation steps, sounds play
+void Game::stepSimulation(float tickDt, const PixelSnapshot& framebuffer, int drawableWidth, int drawableHeight) {
+    InputFrame input = readControllers();
+    sim.aiControlled[1] = ai->getMode();
+    if (ai->getMode()) {
+        // The AI holds player 2's controller
+        input.leftTrigger[1] = input.rightTrigger[1] = 0.0f;
+        input.aButton[1] = false;
+        if (!config.AI_WORKER) {
+            ai->post(sim, framebuffer, drawableWidth, drawableHeight); // decides right here
         }
-        audio.playBoop(currentTimeSec);
-        if (config.ENABLE_DEBUG) {
-            SDL_Log("Green square collected by player %s at pos=(%f, %f), time=%f, score1=%d, score2=%d, collectible.active=%d",
-                    player == &player1 ? "1" : "2", player->pos.x, player->pos.y, currentTimeSec, score1, score2, collectible.active);
-        }
-    } else if (config.ENABLE_DEBUG) {
-        SDL_Log("Green square collection skipped for player %s at time=%f, already collected=%d, collectible.active=%d",
-                player == &player1 ? "1" : "2", currentTimeSec, collectibleCollectedThisFrame, collectible.active);
+        ai->applyUpdate(sim.player2, input);
     }
-}
 
-// Handle player death
-void Game::handlePlayerDeath(Player* player, float currentTimeSec) {
-    if (!player->scoredDeathThisFrame) {
-        player->scoredDeathThisFrame = true;
-        bool simultaneousDeath = (player1.willDie || !player1.alive) && (player2.willDie || !player2.alive);
-        if (!simultaneousDeath) {
-            if (player == &player1 && player2.alive) {
-                score2 += static_cast<int>(deathPoints);
-                roundScore2 += static_cast<int>(deathPoints);
-                if (config.ENABLE_DEBUG) {
-                    SDL_Log("Player 1 died, score2 += %d, total score2=%d, player1.alive=%d, player2.alive=%d",
-                            static_cast<int>(deathPoints), score2, player1.alive, player2.alive);
-                }
-            } else if (player == &player2 && player1.alive) {
-                score1 += static_cast<int>(deathPoints);
-                roundScore1 += static_cast<int>(deathPoints);
-                if (config.ENABLE_DEBUG) {
-                    SDL_Log("Player 2 died, score1 += %d, total score1=%d, player1.alive=%d, player2.alive=%d",
-                            static_cast<int>(deathPoints), score1, player1.alive, player2.alive);
-                }
-            }
-        } else if (config.ENABLE_DEBUG) {
-            SDL_Log("Simultaneous death detected, no points awarded, player1.alive=%d, player2.alive=%d",
-                    player1.alive, player2.alive);
-        }
-    } else if (config.ENABLE_DEBUG) {
-        SDL_Log("Death scoring skipped for player %s at time=%f, already scored this frame",
-                player == &player1 ? "1" : "2", currentTimeSec);
+    sim.step(input, tickDt, framebuffer, drawableWidth, drawableHeight);
+
+    if (sim.events & SIM_EVENT_BOOP) audio.playBoop(sim.time);
+    if (sim.events & SIM_EVENT_EXPLOSION) audio.playExplosion(sim.time);
+    if (sim.events & SIM_EVENT_LASER_ZAP) audio.playLaserZap(sim.time);
+    if (sim.setWinner) {
+        winnerDeclared = true;
+        gameOverScreen = true;
+        audio.playWinnerVoice(sim.time);
+        lastWinnerVoiceTime = sim.time;
+    } else if (sim.roundOver) {
+        gameOver = true;
+        gameOverScreen = true;
+        gameOverTime = std::chrono::steady_clock::now();
     }
 }
 
@@ -293,8 +204,7 @@ void Game::run() {
     auto lastTime = std::chrono::steady_clock::now();
     while (running) {
         auto currentTime = std::chrono::steady_clock::now();
-        dt = std::chrono::duration<float>(currentTime - lastTime).count();
-        float currentTimeSec = std::chrono::duration<float>(currentTime.time_since_epoch()).count();
+        float dt = std::chrono::duration<float>(currentTime - lastTime).count();
         lastTime = currentTime;
 
         frameRendered = false;
@@ -303,30 +213,57 @@ void Game::run() {
 
         if (!isSplashScreen && running) {
             if (!gameOverScreen && !gameOver && !paused && !winnerDeclared) {
-                // Read framebuffer
-                int drawableWidth, drawableHeight;
-                SDL_GL_GetDrawableSize(window, &drawableWidth, &drawableHeight);
-                size_t framebufferSize = static_cast<size_t>(drawableWidth) * drawableHeight * 3;
-                if (framebufferSize > std::vector<unsigned char>().max_size()) {
-                    SDL_Log("Error: Framebuffer size %zu exceeds max vector size %zu",
-                            framebufferSize, std::vector<unsigned char>().max_size());
-                    throw std::length_error("Framebuffer too large for vector");
+                // Run as many fixed ticks as the frame time covers; a slow frame catches up in substeps
+                const float tickDt = 1.0f / std::max(config.TICK_RATE, 1.0f);
+                accumulator += dt;
+                if (accumulator >= tickDt) {
+                    // Read framebuffer (pixel collision only, the collision grid does not need it)
+                    int drawableWidth, drawableHeight;
+                    SDL_GL_GetDrawableSize(window, &drawableWidth, &drawableHeight);
+                    PixelSnapshot framebuffer;
+                    if (config.COLLISION_MODE == 1) {
+                        // Heads probe just ahead of themselves; leave room for the frames the readback lags behind
+                        const float HEAD_MARGIN = config.PLAYER_SIZE + config.PLAYER_SPEED * 0.05f;
+                        for (const Player* player : {&sim.player1, &sim.player2}) {
+                            if (!player->alive) continue;
+                            readbackManager.addRegion(player->pos.x - HEAD_MARGIN, player->pos.y - HEAD_MARGIN,
+                                                      player->pos.x + HEAD_MARGIN, player->pos.y + HEAD_MARGIN);
+                        }
+                        ai->addReadbackRegions(sim.player2, sim.collectible, readbackManager);
+                        framebuffer = readbackManager.readFrame(drawableWidth, drawableHeight, sim.orthoWidth, sim.orthoHeight);
+                        if (config.ENABLE_DEBUG) {
+                            SDL_Log("Readback: %zu bytes this frame", readbackManager.getBytesLastFrame());
+                        }
+                    }
+
+                    int steps = 0;
+                    while (accumulator >= tickDt && steps < config.MAX_SUBSTEPS && !gameOverScreen) {
+                        stepSimulation(tickDt, framebuffer, drawableWidth, drawableHeight);
+                        accumulator -= tickDt;
+                        ++steps;
+                    }
+                    if (config.AI_WORKER && ai->getMode() && !gameOverScreen) {
+                        // The worker thinks about this frame while it is drawn
+                        ai->post(sim, framebuffer, drawableWidth, drawableHeight);
+                    }
+                    readbackManager.release();
+                    if (gameOverScreen || accumulator >= tickDt) {
+                        // Round over, or too far behind to catch up: drop the leftover time
+                        if (config.ENABLE_DEBUG && !gameOverScreen) {
+                            SDL_Log("Dropped %f s of simulation after %d substeps", accumulator, steps);
+                        }
+                        accumulator = 0.0f;
+                    }
                 }
-                std::vector<unsigned char> framebuffer(framebufferSize);
-                glReadPixels(0, 0, drawableWidth, drawableHeight, GL_RGB, GL_UNSIGNED_BYTE, framebuffer.data());
-
-                // Update players (AI handled in PlayerManager)
-                playerManager->updatePlayers(controllers, controllerCount, player1, player2, collectible, explosions, flashes,
-                                             score1, score2, roundScore1, roundScore2, rng, dt, currentTimeSec, audio,
-                                             collectibleManager, explosionManager, circleManager, circles, lastCircleSpawn, this,
-                                             framebuffer, drawableWidth, drawableHeight, SDLplayercolor);
-
-                update(dt, currentTimeSec);
+                renderAlpha = accumulator / tickDt;
             } else if (gameOverScreen && !winnerDeclared && std::chrono::duration<float>(currentTime - gameOverTime).count() > 5.0f) {
                 reset();
-            } else if (winnerDeclared && currentTimeSec - lastWinnerVoiceTime >= config.WINNER_VOICE_DURATION) {
-                audio.playWinnerVoice(currentTimeSec);
-                lastWinnerVoiceTime = currentTimeSec;
+            } else {
+                if (!paused) sim.advanceClock(dt);
+                if (winnerDeclared && sim.time - lastWinnerVoiceTime >= config.WINNER_VOICE_DURATION) {
+                    audio.playWinnerVoice(sim.time);
+                    lastWinnerVoiceTime = sim.time;
+                }
             }
         }
 
@@ -336,69 +273,6 @@ void Game::run() {
     }
 }
 
-void Game::update(float dt, float currentTimeSec) {
-    // Reset per-frame flags
-    player1.collectedGreenThisFrame = false;
-    player2.collectedGreenThisFrame = false;
-    player1.scoredDeathThisFrame = false;
-    player2.scoredDeathThisFrame = false;
-    collectibleCollectedThisFrame = false;
-
-    // Update AI noCollisionTimer
-    if (ai->getMode() && player2.noCollisionTimer > 0) {
-        player2.noCollisionTimer -= dt;
-        if (player2.noCollisionTimer <= 0) {
-            player2.noCollisionTimer = 0;
-            player2.isInvincible = false;
-            player2.canUseNoCollision = true;
-            player2.endFlash = std::make_unique<Flash>(
-                explosionManager.createFlash(player2.pos, rng, dt, currentTimeSec, {255, 0, 255, 255}));
-            audio.playLaserZap(currentTimeSec);
-            if (config.ENABLE_DEBUG) {
-                SDL_Log("AI no-collision ended at time %f, canUseNoCollision=%d",
-                        currentTimeSec, player2.canUseNoCollision);
-            }
-        }
-    }
-
-    // Handle deferred collectible respawn
-    if (pendingCollectibleRespawn) {
-        collectible = collectibleManager.spawnCollectible(rng, *this);
-        collectible.active = true;
-        pendingCollectibleRespawn = false;
-        if (config.ENABLE_DEBUG) {
-            SDL_Log("Deferred collectible respawned at pos=(%f, %f), active=%d",
-                    collectible.pos.x, collectible.pos.y, collectible.active);
-        }
-    }
-
-    // Update circles (handled by CircleManager)
-    circleManager.updateCircles(dt, circles, rng, currentTimeSec, lastCircleSpawn, *this);
-
-    // Clear trails under circles
-    circleManager.clearTrails(circles, player1, player2);
-
-    if (score1 >= config.WINNING_SCORE) {
-        setScore1 += 1;
-        winnerDeclared = true;
-        gameOverScreen = true;
-        audio.playWinnerVoice(currentTimeSec);
-        lastWinnerVoiceTime = currentTimeSec;
-        score1 = score2 = 0;
-    } else if (score2 >= config.WINNING_SCORE) {
-        setScore2 += 1;
-        winnerDeclared = true;
-        gameOverScreen = true;
-        audio.playWinnerVoice(currentTimeSec);
-        lastWinnerVoiceTime = currentTimeSec;
-        score1 = score2 = 0;
-    } else if (!player1.alive || !player2.alive) {
-        gameOver = true;
-        gameOverScreen = true;
-        gameOverTime = std::chrono::steady_clock::now();
-    }
-}
-
 void Game::render() {
     glClear(GL_COLOR_BUFFER_BIT);
     int drawableWidth, drawableHeight;
@@ -406,13 +280,13 @@ void Game::render() {
     glViewport(0, 0, drawableWidth, drawableHeight);
     glMatrixMode(GL_PROJECTION);
     glLoadIdentity();
-    glOrtho(0, orthoWidth, orthoHeight, 0, -1, 1);
+    glOrtho(0, sim.orthoWidth, sim.orthoHeight, 0, -1, 1);
     glMatrixMode(GL_MODELVIEW);
     glLoadIdentity();
 
     if (config.ENABLE_DEBUG) {
         SDL_Log("Rendering: orthoWidth=%f, orthoHeight=%f, drawableWidth=%d, drawableHeight=%d",
-                orthoWidth, orthoHeight, drawableWidth, drawableHeight);
+                sim.orthoWidth, sim.orthoHeight, drawableWidth, drawableHeight);
     }
 
     if (isSplashScreen) {
@@ -421,10 +295,9 @@ void Game::render() {
         }
         renderManager.renderSplashScreen(splashTexture);
     } else if (gameOverScreen) {
-        renderManager.renderGameOver(*this, orthoWidth, orthoHeight);
+        renderManager.renderGameOver(*this, sim.orthoWidth, sim.orthoHeight);
     } else {
-        float currentTimeSec = std::chrono::duration<float>(std::chrono::steady_clock::now().time_since_epoch()).count();
-        renderManager.renderGame(*this, currentTimeSec);
+        renderManager.renderGame(*this, sim.time + renderAlpha / std::max(config.TICK_RATE, 1.0f), renderAlpha);
     }
 
     frameRendered = true;
@@ -432,92 +305,30 @@ void Game::render() {
 
 // Reset game state
 void Game::reset() {
-    player1 = Player{
-        Vec2(200, orthoHeight / 2),      // pos
-        Vec2(1, 0),                      // direction
-        SDL_Color{0, 0, 255, 255},      // color
-        {},                              // trail
-        true,                            // alive
-        false,                           // willDie
-        false,                           // hasMoved
-        Vec2(0, 0),                      // deathPos
-        0.0f,                            // noCollisionTimer
-        true,                            // canUseNoCollision
-        false,                           // isInvincible
-        false,                           // collectedGreenThisFrame
-        false,                           // scoredDeathThisFrame
-        0.0f,                            // spawnInvincibilityTimer
-        nullptr,                         // endFlash
-        false                            // hitOpponentHead
-    };
-    player2 = Player{
-        Vec2(orthoWidth - 200, orthoHeight / 2), // pos
-        Vec2(-1, 0),                      // direction
-        SDL_Color{255, 0, 0, 255},       // color
-        {},                              // trail
-        true,                            // alive
-        false,                           // willDie
-        false,                           // hasMoved
-        Vec2(0, 0),                      // deathPos
-        0.0f,                            // noCollisionTimer
-        true,                            // canUseNoCollision
-        false,                           // isInvincible
-        false,                           // collectedGreenThisFrame
-        false,                           // scoredDeathThisFrame
-        0.0f,                            // spawnInvincibilityTimer
-        nullptr,                         // endFlash
-        false                            // hitOpponentHead
-    };
-
-    player1.trail.clear();
-    player2.trail.clear();
-
-    circles.clear();
-    circleManager.spawnInitialCircle(rng, circles, *this);
-    collectible = collectibleManager.spawnCollectible(rng, *this);
-    collectible.active = true; // Ensure collectible is active
-    explosions.clear();
-    flashes.clear();
+    sim.reset(winnerDeclared);
     ai->resetFlash();
 
-    roundScore1 = roundScore2 = 0;
-    if (winnerDeclared) {
-        score1 = score2 = 0;
-    }
     gameOver = gameOverScreen = winnerDeclared = paused = false;
-    lastCircleSpawn = std::chrono::steady_clock::now();
     lastBoopTime = 0.0f;
-    deathTime = 0.0f;
     lastWinnerVoiceTime = 0.0f;
     frameRendered = false;
-    collectibleCollectedThisFrame = false;
-    pendingCollectibleRespawn = false;
+    accumulator = 0.0f;
+    renderAlpha = 0.0f;
+    pendingFlash[0] = pendingFlash[1] = false;
 
     glClear(GL_COLOR_BUFFER_BIT);
     glFinish();
     if (config.ENABLE_DEBUG) {
         SDL_Log("Game reset, new collectible pos=(%f, %f), size=%f, active=%d",
-                collectible.pos.x, collectible.pos.y, collectible.size, collectible.active);
+                sim.collectible.pos.x, sim.collectible.pos.y, sim.collectible.size, sim.collectible.active);
     }
 }
 
-// Respawn circles to match current ortho dimensions
-void Game::respawnCircles() {
-    circles.clear();
-    circleManager.spawnInitialCircle(rng, circles, *this);
-}
-
-// Activate no-collision mode for a player
-void Game::activateNoCollision(Player* player, float currentTimeSec) {
-    if (player->canUseNoCollision && player->noCollisionTimer <= 0 && player->alive) {
-        player->noCollisionTimer = 2.0f; // 2 seconds
-        player->canUseNoCollision = false; // you used it
-        player->isInvincible = true;
-        flashes.emplace_back(explosionManager.createFlash(player->pos, rng, dt, currentTimeSec, SDLexplosioncolor));
-        audio.playLaserZap(currentTimeSec);
-        if (config.ENABLE_DEBUG) {
-            SDL_Log("Player flash activated at time %f, noCollisionTimer=%f", currentTimeSec, player->noCollisionTimer);
-        }
+// Show or hide the AI stats overlay; showing it turns the profiler on
+void Game::toggleAIStats() {
+    showAIStats = !showAIStats;
+    if (showAIStats) {
+        ai->getProfiler().setEnabled(true);
     }
 }
 
@@ -545,17 +356,17 @@ void Game::toggleFullscreen() {
     glViewport(0, 0, drawableWidth, drawableHeight);
     glMatrixMode(GL_PROJECTION);
     glLoadIdentity();
-    glOrtho(0, orthoWidth, orthoHeight, 0, -1, 1);
+    glOrtho(0, sim.orthoWidth, sim.orthoHeight, 0, -1, 1);
     glMatrixMode(GL_MODELVIEW);
     glLoadIdentity();
 
     if (config.ENABLE_DEBUG) {
         SDL_Log("Fullscreen toggle: orthoWidth=%f, orthoHeight=%f, drawableWidth=%d, drawableHeight=%d",
-                orthoWidth, orthoHeight, drawableWidth, drawableHeight);
+                sim.orthoWidth, sim.orthoHeight, drawableWidth, drawableHeight);
     }
 
-    collectible = collectibleManager.spawnCollectible(rng, *this);
-    respawnCircles();
+    sim.collectible = sim.collectibleManager.spawnCollectible(sim.rng, sim);
+    sim.respawnCircles();
 }
 
 // Resume game after a winner is declared
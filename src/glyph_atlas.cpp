@@ -0,0 +1,55 @@
+#include "glyph_atlas.h"
+#include "font.h"
+#include <vector>
+
+GlyphAtlas::GlyphAtlas() : id(0) {}
+
+GLuint GlyphAtlas::texture() {
+    if (id != 0) return id;
+    std::vector<uint8_t> pixels(static_cast<size_t>(WIDTH) * HEIGHT * 4, 0);
+    auto light = [&](int x, int y) {
+        uint8_t* texel = &pixels[(static_cast<size_t>(y) * WIDTH + x) * 4];
+        texel[0] = texel[1] = texel[2] = texel[3] = 255;
+    };
+    for (int y = 0; y < CELL; ++y) {
+        for (int x = 0; x < CELL; ++x) {
+            light(x, y);
+        }
+    }
+    for (int c = 1; c < static_cast<int>(Font::GLYPHS.size()); ++c) {
+        int cellX = (c % COLUMNS) * CELL + 1;
+        int cellY = (c / COLUMNS) * CELL + 1;
+        for (int row = 0; row < Font::SIZE; ++row) {
+            for (int col = 0; col < Font::SIZE; ++col) {
+                if (Font::pixel(Font::GLYPHS[c], row, col)) light(cellX + col, cellY + row);
+            }
+        }
+    }
+    glGenTextures(1, &id);
+    glBindTexture(GL_TEXTURE_2D, id);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, WIDTH, HEIGHT, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return id;
+}
+
+TexRect GlyphAtlas::solid() {
+    float u = (CELL / 2.0f) / WIDTH;
+    float v = (CELL / 2.0f) / HEIGHT;
+    return TexRect{u, v, u, v};
+}
+
+TexRect GlyphAtlas::glyph(char c) {
+    int index = static_cast<unsigned char>(c) % (COLUMNS * 8);
+    float x = static_cast<float>((index % COLUMNS) * CELL + 1);
+    float y = static_cast<float>((index / COLUMNS) * CELL + 1);
+    return TexRect{x / WIDTH, y / HEIGHT, (x + Font::SIZE) / WIDTH, (y + Font::SIZE) / HEIGHT};
+}
+
+void GlyphAtlas::shutdown() {
+    if (id != 0) {
+        glDeleteTextures(1, &id);
+        id = 0;
+    }
+}
@@ -0,0 +1,266 @@
+#include "grid.h"
+#include <SDL2/SDL.h>
+#include <algorithm>
+#include <cmath>
+
+CollisionGrid::CollisionGrid(const GameConfig& config)
+    : config(config),
+      cellSize(std::max(config.GRID_CELL_SIZE, 0.5f)),
+      cols(0),
+      rows(0),
+      trail(),
+      overlay(),
+      overlayRects(),
+      trailVisible{true, true},
+      version(0),
+      rowVersions(),
+      source(nullptr) {
+    resize(static_cast<float>(config.WIDTH), static_cast<float>(config.HEIGHT));
+}
+
+void CollisionGrid::resize(float orthoWidth, float orthoHeight) {
+    cols = std::max(1, static_cast<int>(std::ceil(orthoWidth / cellSize)));
+    rows = std::max(1, static_cast<int>(std::ceil(orthoHeight / cellSize)));
+    trail.assign(static_cast<size_t>(cols) * rows, static_cast<uint8_t>(CellType::Empty));
+    overlay.assign(static_cast<size_t>(cols) * rows, static_cast<uint8_t>(CellType::Empty));
+    overlayRects.clear();
+    rowVersions.assign(rows, 0);
+    touchRows(0, rows - 1);
+    if (config.ENABLE_DEBUG) {
+        SDL_Log("Collision grid resized: %dx%d cells, cellSize=%f", cols, rows, cellSize);
+    }
+}
+
+void CollisionGrid::clear() {
+    std::fill(trail.begin(), trail.end(), static_cast<uint8_t>(CellType::Empty));
+    std::fill(overlay.begin(), overlay.end(), static_cast<uint8_t>(CellType::Empty));
+    overlayRects.clear();
+    touchRows(0, rows - 1);
+}
+
+void CollisionGrid::copyFrom(const CollisionGrid& other) {
+    cellSize = other.cellSize;
+    cols = other.cols;
+    rows = other.rows;
+    trail = other.trail;
+    overlay = other.overlay;
+    overlayRects = other.overlayRects;
+    trailVisible[0] = other.trailVisible[0];
+    trailVisible[1] = other.trailVisible[1];
+    version = other.version;
+    rowVersions = other.rowVersions;
+    source = &other;
+}
+
+void CollisionGrid::copyChangedFrom(const CollisionGrid& other) {
+    if (source != &other || cols != other.cols || rows != other.rows || version > other.version) {
+        copyFrom(other);
+        return;
+    }
+    for (int y = 0; y < rows; ++y) {
+        if (other.rowVersions[y] <= version) continue;
+        size_t begin = static_cast<size_t>(y) * cols;
+        std::copy(other.trail.begin() + begin, other.trail.begin() + begin + cols, trail.begin() + begin);
+        std::copy(other.overlay.begin() + begin, other.overlay.begin() + begin + cols, overlay.begin() + begin);
+        rowVersions[y] = other.rowVersions[y];
+    }
+    overlayRects = other.overlayRects;
+    trailVisible[0] = other.trailVisible[0];
+    trailVisible[1] = other.trailVisible[1];
+    version = other.version;
+}
+
+void CollisionGrid::touchRows(int y0, int y1) {
+    ++version;
+    source = nullptr;
+    for (int y = std::max(y0, 0); y <= std::min(y1, rows - 1); ++y) {
+        rowVersions[y] = version;
+    }
+}
+
+// Forget one player's trail (respawn clears it)
+void CollisionGrid::clearOwner(int owner) {
+    uint8_t tag = static_cast<uint8_t>(owner == 0 ? CellType::TrailP1 : CellType::TrailP2);
+    std::replace(trail.begin(), trail.end(), tag, static_cast<uint8_t>(CellType::Empty));
+    touchRows(0, rows - 1);
+}
+
+CollisionGrid::Rect CollisionGrid::cellRect(float minX, float minY, float maxX, float maxY) const {
+    Rect r;
+    r.x0 = std::max(0, static_cast<int>(std::floor(minX / cellSize)));
+    r.y0 = std::max(0, static_cast<int>(std::floor(minY / cellSize)));
+    r.x1 = std::min(cols - 1, static_cast<int>(std::floor(maxX / cellSize)));
+    r.y1 = std::min(rows - 1, static_cast<int>(std::floor(maxY / cellSize)));
+    return r;
+}
+
+bool CollisionGrid::anyTrail(float minX, float minY, float maxX, float maxY) const {
+    Rect r = cellRect(minX, minY, maxX, maxY);
+    for (int cy = r.y0; cy <= r.y1; ++cy) {
+        const uint8_t* row = &trail[static_cast<size_t>(cy) * cols];
+        for (int cx = r.x0; cx <= r.x1; ++cx) {
+            if (row[cx] != static_cast<uint8_t>(CellType::Empty)) return true;
+        }
+    }
+    return false;
+}
+
+// Mark every cell whose center lies within radius of the segment
+void CollisionGrid::stampSegment(std::vector<uint8_t>& layer, const Vec2& from, const Vec2& to, float radius, CellType value) {
+    Rect r = cellRect(std::min(from.x, to.x) - radius, std::min(from.y, to.y) - radius,
+                      std::max(from.x, to.x) + radius, std::max(from.y, to.y) + radius);
+    Vec2 seg = to - from;
+    float lenSq = seg.dot(seg);
+    float radiusSq = radius * radius;
+    for (int cy = r.y0; cy <= r.y1; ++cy) {
+        for (int cx = r.x0; cx <= r.x1; ++cx) {
+            Vec2 center((cx + 0.5f) * cellSize, (cy + 0.5f) * cellSize);
+            float t = lenSq > 0.0f ? std::clamp((center - from).dot(seg) / lenSq, 0.0f, 1.0f) : 0.0f;
+            Vec2 d = center - (from + seg * t);
+            if (d.dot(d) <= radiusSq) {
+                layer[static_cast<size_t>(cy) * cols + cx] = static_cast<uint8_t>(value);
+            }
+        }
+    }
+    touchRows(r.y0, r.y1);
+}
+
+void CollisionGrid::addTrailSegment(const Vec2& from, const Vec2& to, int owner) {
+    // Trails are drawn as TRAIL_SIZE wide lines
+    float radius = std::max(config.TRAIL_SIZE / 2.0f, cellSize / 2.0f);
+    stampSegment(trail, from, to, radius, owner == 0 ? CellType::TrailP1 : CellType::TrailP2);
+}
+
+// Circles erase whatever trail is under them, same as CircleManager::clearTrails does to Player::trail
+bool CollisionGrid::eraseCircle(const Vec2& center, float radius) {
+    Rect r = cellRect(center.x - radius, center.y - radius, center.x + radius, center.y + radius);
+    float radiusSq = radius * radius;
+    uint8_t erased = 0;
+    for (int cy = r.y0; cy <= r.y1; ++cy) {
+        uint8_t* row = &trail[static_cast<size_t>(cy) * cols];
+        for (int cx = r.x0; cx <= r.x1; ++cx) {
+            Vec2 d((cx + 0.5f) * cellSize - center.x, (cy + 0.5f) * cellSize - center.y);
+            if (d.dot(d) < radiusSq) {
+                erased |= row[cx];
+                row[cx] = static_cast<uint8_t>(CellType::Empty);
+            }
+        }
+    }
+    touchRows(r.y0, r.y1);
+    return erased != 0;
+}
+
+void CollisionGrid::stampDisc(const Vec2& center, float radius, CellType value) {
+    Rect r = cellRect(center.x - radius, center.y - radius, center.x + radius, center.y + radius);
+    float radiusSq = radius * radius;
+    for (int cy = r.y0; cy <= r.y1; ++cy) {
+        uint8_t* row = &overlay[static_cast<size_t>(cy) * cols];
+        for (int cx = r.x0; cx <= r.x1; ++cx) {
+            Vec2 d((cx + 0.5f) * cellSize - center.x, (cy + 0.5f) * cellSize - center.y);
+            if (d.dot(d) <= radiusSq) {
+                row[cx] = static_cast<uint8_t>(value);
+            }
+        }
+    }
+    overlayRects.push_back(r);
+    touchRows(r.y0, r.y1);
+}
+
+void CollisionGrid::stampRect(float minX, float minY, float maxX, float maxY, CellType value) {
+    Rect r = cellRect(minX, minY, maxX, maxY);
+    for (int cy = r.y0; cy <= r.y1; ++cy) {
+        uint8_t* row = &overlay[static_cast<size_t>(cy) * cols];
+        for (int cx = r.x0; cx <= r.x1; ++cx) {
+            row[cx] = static_cast<uint8_t>(value);
+        }
+    }
+    overlayRects.push_back(r);
+    touchRows(r.y0, r.y1);
+}
+
+// Restamp moving objects in the same order RenderManager::renderGame draws them
+void CollisionGrid::updateOverlay(const std::vector<Circle>& circles, const Collectible& collectible,
+                                  const Player& player1, const Player& player2) {
+    for (const Rect& r : overlayRects) {
+        for (int cy = r.y0; cy <= r.y1; ++cy) {
+            std::fill(&overlay[static_cast<size_t>(cy) * cols + r.x0],
+                      &overlay[static_cast<size_t>(cy) * cols + r.x1] + 1,
+                      static_cast<uint8_t>(CellType::Empty));
+        }
+        touchRows(r.y0, r.y1);
+    }
+    overlayRects.clear();
+
+    trailVisible[0] = !player1.isInvincible;
+    trailVisible[1] = !player2.isInvincible;
+
+    if (collectible.active) {
+        float half = collectible.size / 2.0f;
+        stampRect(collectible.pos.x - half, collectible.pos.y - half,
+                  collectible.pos.x + half, collectible.pos.y + half, CellType::Collectible);
+    }
+    for (const auto& circle : circles) {
+        stampDisc(circle.pos, circle.radius, circle.isYellow ? CellType::CircleDanger : CellType::CircleSafe);
+    }
+    float half = config.PLAYER_SIZE / 2.0f;
+    if (player1.alive) {
+        stampRect(player1.pos.x - half, player1.pos.y - half, player1.pos.x + half, player1.pos.y + half, CellType::HeadP1);
+    }
+    if (player2.alive) {
+        stampRect(player2.pos.x - half, player2.pos.y - half, player2.pos.x + half, player2.pos.y + half, CellType::HeadP2);
+    }
+}
+
+// What is at pos, ignoring the head of player self (0 or 1, -1 for none)
+CellType CollisionGrid::sample(const Vec2& pos, int self) const {
+    if (pos.x < 0.0f || pos.y < 0.0f) return CellType::Wall;
+    int cx = static_cast<int>(pos.x / cellSize);
+    int cy = static_cast<int>(pos.y / cellSize);
+    if (cx >= cols || cy >= rows) return CellType::Wall;
+
+    size_t index = static_cast<size_t>(cy) * cols + cx;
+    CellType top = static_cast<CellType>(overlay[index]);
+    bool ownHead = (self == 0 && top == CellType::HeadP1) || (self == 1 && top == CellType::HeadP2);
+    if (top != CellType::Empty && !ownHead) return top;
+
+    CellType line = static_cast<CellType>(trail[index]);
+    if (line == CellType::TrailP1 && trailVisible[0]) return line;
+    if (line == CellType::TrailP2 && trailVisible[1]) return line;
+    return CellType::Empty;
+}
+
+bool CollisionGrid::solidTrailAt(const Vec2& pos) const {
+    if (pos.x < 0.0f || pos.y < 0.0f) return false;
+    int cx = static_cast<int>(pos.x / cellSize);
+    int cy = static_cast<int>(pos.y / cellSize);
+    if (cx >= cols || cy >= rows) return false;
+    CellType line = static_cast<CellType>(trail[static_cast<size_t>(cy) * cols + cx]);
+    return (line == CellType::TrailP1 && trailVisible[0]) || (line == CellType::TrailP2 && trailVisible[1]);
+}
+
+// Black, green and magenta are safe, everything else kills
+bool CollisionGrid::isDeadly(CellType cell) {
+    return cell != CellType::Empty && cell != CellType::Collectible && cell != CellType::CircleSafe;
+}
+
+bool CollisionGrid::isDangerToAI(CellType cell) {
+    return cell == CellType::TrailP1 || cell == CellType::TrailP2 || cell == CellType::HeadP1 ||
+           cell == CellType::HeadP2 || cell == CellType::CircleDanger;
+}
+
+// Names match the colors the AI used to read out of the framebuffer
+const char* CollisionGrid::colorName(CellType cell) {
+    switch (cell) {
+        case CellType::Empty: return "black";
+        case CellType::TrailP1: return "blue";
+        case CellType::TrailP2: return "red";
+        case CellType::Collectible: return "green";
+        case CellType::CircleSafe: return "magenta";
+        case CellType::CircleDanger: return "yellow";
+        case CellType::HeadP1: return "blue";
+        case CellType::HeadP2: return "red";
+        case CellType::Wall: return "wall";
+        case CellType::Other: return "other";
+    }
+    return "other";
+}
@@ -0,0 +1,225 @@
+#include "headless.h"
+#include "simulation.h"
+#include "ai.h"
+#include <SDL2/SDL.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <thread>
+
+InputFrame scriptedBotInput(const Simulation& sim, int slot) {
+    InputFrame input;
+    const Player& self = slot == 0 ? sim.player1 : sim.player2;
+    if (!self.alive) return input;
+
+    const float LOOK_AHEAD = 60.0f;
+    const float FEELER_ANGLE = static_cast<float>(M_PI) / 6.0f; // 30 degrees
+
+    // Blocked if the point is near a wall, in a circle or on a trail
+    auto blocked = [&](const Vec2& pos) {
+        if (pos.x < 20.0f || pos.x > sim.orthoWidth - 20.0f || pos.y < 20.0f || pos.y > sim.orthoHeight - 20.0f) {
+            return true;
+        }
+        return CollisionGrid::isDeadly(sim.sample(pos, slot));
+    };
+    auto rotate = [](const Vec2& v, float angle) {
+        return Vec2(v.x * std::cos(angle) - v.y * std::sin(angle), v.x * std::sin(angle) + v.y * std::cos(angle));
+    };
+
+    Vec2 head = self.pos + self.direction * (sim.config.PLAYER_SIZE / 2.0f);
+    bool frontBlocked = false;
+    for (float d = 8.0f; d <= LOOK_AHEAD; d += 8.0f) {
+        if (blocked(head + self.direction * d)) { frontBlocked = true; break; }
+    }
+
+    if (frontBlocked) {
+        // Turn hard toward the side that has more room
+        float leftRoom = 0.0f, rightRoom = 0.0f;
+        Vec2 leftDir = rotate(self.direction, -FEELER_ANGLE);
+        Vec2 rightDir = rotate(self.direction, FEELER_ANGLE);
+        for (float d = 8.0f; d <= LOOK_AHEAD * 2.0f && !blocked(head + leftDir * d); d += 8.0f) leftRoom = d;
+        for (float d = 8.0f; d <= LOOK_AHEAD * 2.0f && !blocked(head + rightDir * d); d += 8.0f) rightRoom = d;
+        if (leftRoom > rightRoom) input.leftTrigger[slot] = 1.0f;
+        else input.rightTrigger[slot] = 1.0f;
+    } else if (sim.collectible.active) {
+        Vec2 toTarget = (sim.collectible.pos - self.pos).normalized();
+        float cross = self.direction.x * toTarget.y - self.direction.y * toTarget.x;
+        float turn = std::min(std::abs(cross) * 4.0f, 1.0f);
+        if (cross < 0) input.leftTrigger[slot] = turn;
+        else input.rightTrigger[slot] = turn;
+    }
+    return input;
+}
+
+int runHeadless(const GameConfig& config, long ticks, uint32_t seed) {
+    const float TICK_DT = 1.0f / std::max(config.TICK_RATE, 1.0f);
+    Simulation sim(config, seed);
+    sim.reset(true);
+
+    long rounds = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < ticks; ++i) {
+        InputFrame input = scriptedBotInput(sim, 0);
+        InputFrame input2 = scriptedBotInput(sim, 1);
+        input.leftTrigger[1] = input2.leftTrigger[1];
+        input.rightTrigger[1] = input2.rightTrigger[1];
+        sim.step(input, TICK_DT);
+        if (sim.roundOver) {
+            ++rounds;
+            sim.reset(sim.setWinner != 0);
+        }
+    }
+    float seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+
+    std::printf("ticks=%ld seed=%u seconds=%.3f ticks_per_sec=%.0f\n",
+                ticks, seed, seconds, seconds > 0 ? ticks / seconds : 0.0f);
+    std::printf("rounds=%ld score=%d-%d sets=%d-%d checksum=%016llx\n",
+                rounds, sim.score1, sim.score2, sim.setScore1, sim.setScore2,
+                static_cast<unsigned long long>(sim.checksum()));
+    return 0;
+}
+
+namespace {
+struct MatchResult {
+    int winner;        // player slot, -1 for a draw
+    long rounds;
+    long roundsWon[2]; // rounds the other player crashed out of
+    long roundTicks;   // ticks played in finished rounds
+};
+
+// One match on its own board. Each AI decides on this thread before every tick, the way the
+// game does with AI_WORKER off; its profiler is added to profiles[slot] at the end.
+MatchResult playMatch(const GameConfig& config, long ticks, uint32_t seed, bool versusBot, AIProfiler* profiles) {
+    const float TICK_DT = 1.0f / std::max(config.TICK_RATE, 1.0f);
+    Simulation sim(config, seed);
+    sim.reset(true);
+    std::unique_ptr<AI> ais[2];
+    for (int slot = versusBot ? 1 : 0; slot < 2; ++slot) {
+        ais[slot] = std::make_unique<AI>(config, sim, slot);
+        sim.aiControlled[slot] = true;
+    }
+
+    MatchResult result{-1, 0, {0, 0}, 0};
+    long roundStart = 0;
+    for (long i = 0; i < ticks; ++i) {
+        InputFrame input = versusBot ? scriptedBotInput(sim, 0) : InputFrame();
+        for (int slot = 0; slot < 2; ++slot) {
+            if (!ais[slot]) continue;
+            ais[slot]->post(sim, PixelSnapshot(), 0, 0);
+            ais[slot]->applyUpdate(slot == 0 ? sim.player1 : sim.player2, input);
+        }
+        sim.step(input, TICK_DT);
+        if (sim.roundOver) {
+            ++result.rounds;
+            result.roundTicks += i + 1 - roundStart;
+            roundStart = i + 1;
+            if (sim.player1.alive && !sim.player2.alive) ++result.roundsWon[0];
+            if (sim.player2.alive && !sim.player1.alive) ++result.roundsWon[1];
+            sim.reset(sim.setWinner != 0);
+            for (auto& ai : ais) {
+                if (ai) ai->resetFlash();
+            }
+        }
+    }
+
+    // Sets decide the match, then points in the set being played
+    if (sim.setScore1 != sim.setScore2) {
+        result.winner = sim.setScore1 > sim.setScore2 ? 0 : 1;
+    } else if (sim.score1 != sim.score2) {
+        result.winner = sim.score1 > sim.score2 ? 0 : 1;
+    }
+    for (int slot = 0; slot < 2; ++slot) {
+        if (ais[slot]) profiles[slot].merge(ais[slot]->getProfiler());
+    }
+    return result;
+}
+
+void printCost(const AIProfiler& profile, int slot) {
+    std::printf("player %d decision cost:\n", slot + 1);
+    std::printf("  %-10s %8s %10s %10s %10s %10s %10s\n", "series", "count", "mean", "p50", "p95", "p99", "max");
+    auto row = [](const char* name, const char* unit, const AIProfiler::Summary& s) {
+        if (s.count == 0) return;
+        std::printf("  %-10s %8llu %10.1f %10.1f %10.1f %10.1f %10.1f %s\n", name,
+                    static_cast<unsigned long long>(s.count), s.mean, s.p50, s.p95, s.p99, s.max, unit);
+    };
+    for (int i = 0; i < AIProfiler::PHASE_COUNT; ++i) {
+        auto phase = static_cast<AIProfiler::Phase>(i);
+        row(AIProfiler::phaseName(phase), "us", profile.sessionPhase(phase));
+    }
+    for (int i = 0; i < AIProfiler::COUNTER_COUNT; ++i) {
+        auto counter = static_cast<AIProfiler::Counter>(i);
+        row(AIProfiler::counterName(counter), "per decision", profile.sessionCounter(counter));
+    }
+
+    // Whole decisions, one row per doubling
+    std::vector<std::pair<float, uint64_t>> rows;
+    uint64_t total = 0;
+    for (const auto& bucket : profile.histogram(AIProfiler::DECISION)) {
+        float top = bucket.first > 0.0f ? std::exp2(std::ceil(std::log2(bucket.first) - 1e-3f)) : 0.0f;
+        if (rows.empty() || rows.back().first != top) rows.emplace_back(top, 0);
+        rows.back().second += bucket.second;
+        total += bucket.second;
+    }
+    for (const auto& row : rows) {
+        float share = static_cast<float>(row.second) / std::max<uint64_t>(total, 1);
+        std::printf("  <= %9.0f us %8llu %5.1f%% %s\n", row.first, static_cast<unsigned long long>(row.second),
+                    share * 100.0f, std::string(static_cast<size_t>(std::lround(share * 50.0f)), '#').c_str());
+    }
+}
+}
+
+int runTournament(const GameConfig& config, int matches, long ticks, uint32_t seed, bool versusBot) {
+    // The matches fill the cores, so every AI thinks on the thread playing its match
+    GameConfig matchConfig = config;
+    matchConfig.AI_WORKER = false;
+    matchConfig.AI_THREADS = 0;
+    matchConfig.AI_PROFILE = true;
+    matchConfig.ENABLE_DEBUG = false;
+    matches = std::max(matches, 1);
+
+    int threads = std::clamp(static_cast<int>(std::thread::hardware_concurrency()), 1, matches);
+    std::vector<MatchResult> results(matches);
+    AIProfiler profiles[2] = {AIProfiler(true), AIProfiler(true)};
+    std::atomic<int> next(0);
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&] {
+            for (int match = next++; match < matches; match = next++) {
+                results[match] = playMatch(matchConfig, ticks, seed + static_cast<uint32_t>(match), versusBot, profiles);
+            }
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    float seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+
+    int wins[2] = {0, 0}, draws = 0;
+    long rounds = 0, roundsWon[2] = {0, 0}, roundTicks = 0;
+    for (const MatchResult& result : results) {
+        if (result.winner >= 0) ++wins[result.winner];
+        else ++draws;
+        rounds += result.rounds;
+        roundsWon[0] += result.roundsWon[0];
+        roundsWon[1] += result.roundsWon[1];
+        roundTicks += result.roundTicks;
+    }
+
+    std::printf("matches=%d ticks=%ld seed=%u opponent=%s threads=%d seconds=%.3f\n",
+                matches, ticks, seed, versusBot ? "bot" : "ai", threads, seconds);
+    for (int slot = 0; slot < 2; ++slot) {
+        std::printf("player %d (%s): wins=%d win_rate=%.3f rounds_won=%ld\n", slot + 1,
+                    slot == 0 && versusBot ? "bot" : "ai", wins[slot], static_cast<float>(wins[slot]) / matches,
+                    roundsWon[slot]);
+    }
+    std::printf("draws=%d rounds=%ld average_round_sec=%.2f\n", draws, rounds,
+                rounds > 0 ? roundTicks / static_cast<float>(rounds) / std::max(config.TICK_RATE, 1.0f) : 0.0f);
+    for (int slot = versusBot ? 1 : 0; slot < 2; ++slot) {
+        printCost(profiles[slot], slot);
+    }
+    return 0;
+}
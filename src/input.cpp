@@ -1,6 +1,5 @@
 #include "input.h"
 #include "game.h"
-#include <chrono>
 #include <cstring>
 
 InputManager::InputManager() : musicMuted(false) {
@@ -25,7 +24,7 @@ bool InputManager::handleInput(SDL_GameController* controllers[], int controller
                     //game->renderManager->togglePostProcessing();
                     break;
                 case SDLK_i:
-                    //game->toggleFPSDisplay();
+                    game->toggleAIStats();
                     break;
                 case SDLK_ESCAPE:
                     running = false;
@@ -79,12 +78,8 @@ bool InputManager::handleInput(SDL_GameController* controllers[], int controller
                     paused = !paused;
                     SDL_Log("Game %s", paused ? "paused" : "unpaused");
                 }
-                Player* player = nullptr;
-                if (controllerIndex == 0) player = &game->player1;
-                else if (controllerIndex == 1) player = &game->player2;
-                if (player && button == SDL_CONTROLLER_BUTTON_A) {
-                    float currentTimeSec = std::chrono::duration<float>(std::chrono::steady_clock::now().time_since_epoch()).count();
-                    game->activateNoCollision(player, currentTimeSec);
+                if (button == SDL_CONTROLLER_BUTTON_A) {
+                    game->requestFlash(controllerIndex);
                 }
             }
         } else if (event.type == SDL_CONTROLLERBUTTONUP) {
@@ -0,0 +1,257 @@
+#include "lookahead.h"
+#include "simulation.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <SDL2/SDL.h>
+
+namespace {
+const float LEVEL[5] = {-1.0f, -0.5f, 0.0f, 0.5f, 1.0f};
+const float DEATH_SCORE = -1000.0f;
+const float COLLECT_SCORE = 500.0f;
+const float DISTANCE_SCORE = 100.0f;  // lost for ending a board's diagonal from the collectible
+const float CLEARANCE_SCORE = 20.0f;  // won for ending CLEARANCE_REACH or more from anything
+const float CLEARANCE_REACH = 60.0f;
+
+// Rollout randomness from the search seed, the plan and the round alone, so the same
+// search gives the same answer however the rollouts land on threads
+uint32_t hash(uint32_t a, uint32_t b, uint32_t c) {
+    uint32_t h = a * 0x9E3779B1u ^ (b + 0x7F4A7C15u) * 0x85EBCA77u ^ (c + 0x165667B1u) * 0xC2B2AE3Du;
+    h ^= h >> 15;
+    h *= 0x2C1B3C6Du;
+    h ^= h >> 12;
+    h *= 0x297A2D39u;
+    h ^= h >> 15;
+    return h;
+}
+
+float uniform(uint32_t h) { // -1..1
+    return static_cast<float>(h >> 8) * (2.0f / 16777216.0f) - 1.0f;
+}
+
+Vec2 rotate(const Vec2& v, float c, float s) {
+    return Vec2(v.x * c - v.y * s, v.x * s + v.y * c);
+}
+}
+
+Lookahead::Lookahead(const GameConfig& config)
+    : config(config),
+      solid(nullptr),
+      field(nullptr),
+      bodies(),
+      selfPos(0.0f, 0.0f),
+      selfDir(1.0f, 0.0f),
+      otherPos(0.0f, 0.0f),
+      otherDir(1.0f, 0.0f),
+      otherAlive(false),
+      otherTurnRate(0.0f),
+      shieldTime(0.0f),
+      goalPos(0.0f, 0.0f),
+      goalHalf(0.0f),
+      goalActive(false),
+      width(0.0f),
+      height(0.0f),
+      stepDt(0.0f),
+      steps(0),
+      seed(0),
+      deadline(),
+      timed(false),
+      scores(),
+      finished() {}
+
+Lookahead::Result Lookahead::search(const Simulation& sim, int self, const std::function<bool(const Vec2&)>& solid,
+                                    const DistanceField* field, ThreadPool& pool, uint32_t seed,
+                                    std::chrono::steady_clock::time_point until) {
+    auto start = std::chrono::steady_clock::now();
+    const Player& me = self == 0 ? sim.player1 : sim.player2;
+    const Player& other = self == 0 ? sim.player2 : sim.player1;
+    int otherSlot = 1 - self;
+
+    this->solid = &solid;
+    this->field = field;
+    this->seed = seed;
+    bodies.clear();
+    for (const Circle& circle : sim.circles) {
+        bodies.push_back(Body{circle.pos, circle.vel, circle.radius,
+                              circle.isYellow ? 0.0f : std::max(0.0f, 3.0f - circle.magentaTimer)});
+    }
+    selfPos = me.pos;
+    selfDir = me.direction;
+    otherPos = other.pos;
+    otherDir = other.direction;
+    otherAlive = other.alive && !other.willDie;
+    otherTurnRate = sim.aiControlled[otherSlot] ? config.AI_TURN_SPEED * static_cast<float>(M_PI) / 180.0f
+                                                : config.TURN_SPEED;
+    shieldTime = me.noCollisionTimer;
+    goalPos = sim.collectible.pos;
+    goalHalf = sim.collectible.size / 2.0f;
+    goalActive = sim.collectible.active;
+    width = sim.orthoWidth;
+    height = sim.orthoHeight;
+    stepDt = ROLLOUT_TICKS / std::max(config.TICK_RATE, 1.0f);
+    steps = std::max(3, static_cast<int>(std::lround(config.AI_SEARCH_HORIZON / stepDt)));
+    timed = config.AI_SEARCH_BUDGET_MS > 0.0f || until != std::chrono::steady_clock::time_point::max();
+    deadline = config.AI_SEARCH_BUDGET_MS > 0.0f
+                   ? std::min(until, start + std::chrono::microseconds(static_cast<int64_t>(config.AI_SEARCH_BUDGET_MS * 1000.0f)))
+                   : until;
+
+    // Rollout i is round i / PLANS of plan i % PLANS, so whatever the budget cuts off is the
+    // last rounds and every plan has had about as many
+    int rounds = std::max(1, config.AI_SEARCH_ROLLOUTS);
+    scores.assign(static_cast<size_t>(rounds) * PLANS, 0.0f);
+    finished.assign(static_cast<size_t>(rounds) * PLANS, NOT_RUN);
+    pool.parallelFor(rounds * PLANS, [this](int i) {
+        int round = i / PLANS;
+        if (round > 0 && timed && std::chrono::steady_clock::now() >= deadline) return;
+        bool crashed = false;
+        scores[i] = rollout(i % PLANS, round, crashed);
+        finished[i] = crashed ? CRASHED : SURVIVED;
+    });
+
+    Result result{0.0f, -std::numeric_limits<float>::infinity(), 0, true};
+    for (int plan = 0; plan < PLANS; ++plan) {
+        float total = 0.0f;
+        int count = 0;
+        for (int round = 0; round < rounds; ++round) {
+            size_t i = static_cast<size_t>(round) * PLANS + plan;
+            if (finished[i] == NOT_RUN) continue;
+            total += scores[i];
+            ++count;
+            if (finished[i] == SURVIVED) result.trapped = false;
+        }
+        result.rollouts += count;
+        // Ties go to the gentler first level, so an open board does not make it weave
+        float mean = total / count;
+        float level = LEVEL[plan / LEVELS];
+        if (mean > result.score || (mean == result.score && std::abs(level) < std::abs(result.steer))) {
+            result.score = mean;
+            result.steer = level;
+        }
+    }
+    this->solid = nullptr;
+    this->field = nullptr;
+
+    if (config.ENABLE_DEBUG) {
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        SDL_Log("Lookahead: steer=%f, score=%f, rollouts=%d, trapped=%d, time=%fms",
+                result.steer, result.score, result.rollouts, result.trapped, ms);
+    }
+    return result;
+}
+
+// One playout of a plan, moving things the way PlayerManager::updatePlayers and
+// CircleManager::updateCircles do but ROLLOUT_TICKS at a time. New circles are not spawned and
+// circles do not erase trails. The AI's own new trail is not tracked: at AI_TURN_SPEED a
+// horizon shorter than a full turn cannot bring the head back onto it.
+float Lookahead::rollout(int plan, int round, bool& crashed) const {
+    float first = LEVEL[plan / LEVELS];
+    float second = LEVEL[plan % LEVELS];
+    // Round 0 holds the second level to the end against an opponent going straight
+    float last = round == 0 ? second : uniform(hash(seed, plan, round * 2));
+    float otherSteer = round == 0 ? 0.0f : uniform(hash(seed, plan, round * 2 + 1));
+
+    float turnRate = config.AI_TURN_SPEED * static_cast<float>(M_PI) / 180.0f;
+    float speed = config.PLAYER_SPEED;
+    float turn[3] = {first * turnRate * stepDt, second * turnRate * stepDt, last * turnRate * stepDt};
+    float cosTurn[3], sinTurn[3];
+    for (int k = 0; k < 3; ++k) {
+        cosTurn[k] = std::cos(turn[k]);
+        sinTurn[k] = std::sin(turn[k]);
+    }
+    float otherTurn = otherSteer * otherTurnRate * stepDt;
+    float otherCos = std::cos(otherTurn), otherSin = std::sin(otherTurn);
+
+    thread_local std::vector<Body> moving;
+    thread_local std::vector<Vec2> otherTrail;
+    moving.assign(bodies.begin(), bodies.end());
+    otherTrail.clear();
+
+    float berth = config.AI_BERTH;
+    float half = config.PLAYER_SIZE / 2.0f;
+    float trailReach = config.TRAIL_SIZE / 2.0f + speed * stepDt / 2.0f;
+    float horizon = steps * stepDt;
+    Vec2 pos = selfPos, dir = selfDir;
+    Vec2 otherAt = otherPos, otherHeading = otherDir;
+    float deathTime = -1.0f;
+    float collectTime = -1.0f;
+
+    for (int step = 0; step < steps && deathTime < 0.0f; ++step) {
+        float t = (step + 1) * stepDt;
+        int segment = std::min(2, step * 3 / steps);
+        dir = rotate(dir, cosTurn[segment], sinTurn[segment]).normalized();
+        pos += dir * speed * stepDt;
+
+        for (Body& body : moving) {
+            body.pos += body.vel * stepDt;
+            if (body.pos.x - body.radius < 10.0f || body.pos.x + body.radius > width - 10.0f) {
+                body.vel.x = -body.vel.x;
+                body.pos.x = std::clamp(body.pos.x, 10.0f + body.radius, width - 10.0f - body.radius);
+            }
+            if (body.pos.y - body.radius < 10.0f || body.pos.y + body.radius > height - 10.0f) {
+                body.vel.y = -body.vel.y;
+                body.pos.y = std::clamp(body.pos.y, 10.0f + body.radius, height - 10.0f - body.radius);
+            }
+        }
+        if (otherAlive) {
+            otherTrail.push_back(otherAt);
+            otherHeading = rotate(otherHeading, otherCos, otherSin).normalized();
+            otherAt += otherHeading * speed * stepDt;
+        }
+
+        if (goalActive && collectTime < 0.0f && std::abs(pos.x - goalPos.x) <= goalHalf &&
+            std::abs(pos.y - goalPos.y) <= goalHalf) {
+            collectTime = t;
+        }
+
+        // The game would pin the head against the berth: as good as lost
+        if (pos.x < berth || pos.x > width - berth || pos.y < berth || pos.y > height - berth) {
+            deathTime = t;
+            break;
+        }
+        if (t < shieldTime) continue;
+
+        Vec2 check = pos + dir * half;
+        if ((*solid)(check)) {
+            deathTime = t;
+            break;
+        }
+        for (const Body& body : moving) {
+            Vec2 d = check - body.pos;
+            if (body.yellowIn <= t && d.dot(d) <= body.radius * body.radius) {
+                deathTime = t;
+                break;
+            }
+        }
+        if (otherAlive) {
+            if (std::abs(check.x - otherAt.x) <= half && std::abs(check.y - otherAt.y) <= half) {
+                deathTime = t;
+            }
+            for (const Vec2& point : otherTrail) {
+                Vec2 d = check - point;
+                if (d.dot(d) <= trailReach * trailReach) {
+                    deathTime = t;
+                    break;
+                }
+            }
+        }
+    }
+
+    float score = 0.0f;
+    if (collectTime >= 0.0f) {
+        score += COLLECT_SCORE * (1.0f - 0.5f * collectTime / horizon);
+    }
+    crashed = deathTime >= 0.0f;
+    if (crashed) {
+        return score + DEATH_SCORE * (1.0f - 0.5f * deathTime / horizon);
+    }
+    if (goalActive && collectTime < 0.0f) {
+        float diagonal = std::sqrt(width * width + height * height);
+        score -= DISTANCE_SCORE * (goalPos - pos).magnitude() / diagonal;
+    }
+    float clearance = std::min({pos.x - berth, width - berth - pos.x, pos.y - berth, height - berth - pos.y});
+    if (field) {
+        clearance = std::min(clearance, field->trailDistance(pos));
+    }
+    score += CLEARANCE_SCORE * std::min(clearance, CLEARANCE_REACH) / CLEARANCE_REACH;
+    return score;
+}
@@ -1,5 +1,6 @@
 #include "game.h"
 #include "types.h"
+#include "headless.h"
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_image.h>
 #include <fstream>
@@ -51,6 +52,26 @@ GameConfig loadConfig(const std::string& filename) {
             else if (key == "DEATH_POINTS") config.DEATH_POINTS = value;
 			else if (key == "INVINCIBILITY_DURATION") config.INVINCIBILITY_DURATION = value;
 			else if (key == "AI_BERTH") config.AI_BERTH = value;
+            else if (key == "COLLISION_MODE") config.COLLISION_MODE = static_cast<int>(value);
+            else if (key == "GRID_CELL_SIZE") config.GRID_CELL_SIZE = value;
+            else if (key == "SEGMENT_INDEX_CELL_SIZE") config.SEGMENT_INDEX_CELL_SIZE = value;
+            else if (key == "READBACK_BUFFERS") config.READBACK_BUFFERS = static_cast<int>(value);
+            else if (key == "READBACK_ROI") config.READBACK_ROI = static_cast<bool>(value);
+            else if (key == "TRAIL_LAYER") config.TRAIL_LAYER = static_cast<bool>(value);
+            else if (key == "TICK_RATE") config.TICK_RATE = value;
+            else if (key == "MAX_SUBSTEPS") config.MAX_SUBSTEPS = static_cast<int>(value);
+            else if (key == "AI_WORKER") config.AI_WORKER = static_cast<bool>(value);
+            else if (key == "AI_ASTAR_BUDGET") config.AI_ASTAR_BUDGET = static_cast<int>(value);
+            else if (key == "DISTANCE_FIELD_CELL_SIZE") config.DISTANCE_FIELD_CELL_SIZE = value;
+            else if (key == "AI_THREADS") config.AI_THREADS = static_cast<int>(value);
+            else if (key == "AI_MODE") config.AI_MODE = static_cast<int>(value);
+            else if (key == "AI_SEARCH_HORIZON") config.AI_SEARCH_HORIZON = value;
+            else if (key == "AI_SEARCH_BUDGET_MS") config.AI_SEARCH_BUDGET_MS = value;
+            else if (key == "AI_SEARCH_ROLLOUTS") config.AI_SEARCH_ROLLOUTS = static_cast<int>(value);
+            else if (key == "AI_TERRITORY_CELL_SIZE") config.AI_TERRITORY_CELL_SIZE = value;
+            else if (key == "AI_DIFFICULTY") config.AI_DIFFICULTY = static_cast<int>(value);
+            else if (key == "AI_DECISION_BUDGET_US") config.AI_DECISION_BUDGET_US = value;
+            else if (key == "AI_PROFILE") config.AI_PROFILE = static_cast<bool>(value);
             else if (key == "ENABLE_DEBUG") config.ENABLE_DEBUG = static_cast<bool>(value);
         }
     }
@@ -60,6 +81,25 @@ GameConfig loadConfig(const std::string& filename) {
 }
 
 int main(int argc, char* argv[]) {
+    // ./linesplus --headless [ticks] [seed] runs the rules with no window, GPU or sound
+    if (argc > 1 && std::string(argv[1]) == "--headless") {
+        GameConfig config = loadConfig("game.ini");
+        if (config.COLLISION_MODE == 1) config.COLLISION_MODE = 0; // there are no pixels to read
+        long ticks = argc > 2 ? std::stol(argv[2]) : 120000;
+        uint32_t seed = argc > 3 ? static_cast<uint32_t>(std::stoul(argv[3])) : 1;
+        return runHeadless(config, ticks, seed);
+    }
+    // ./linesplus --tournament [matches] [ticks] [seed] [ai|bot] plays the AI against itself or the bot
+    if (argc > 1 && std::string(argv[1]) == "--tournament") {
+        GameConfig config = loadConfig("game.ini");
+        if (config.COLLISION_MODE == 1) config.COLLISION_MODE = 0;
+        int matches = argc > 2 ? std::stoi(argv[2]) : 16;
+        long ticks = argc > 3 ? std::stol(argv[3]) : 36000;
+        uint32_t seed = argc > 4 ? static_cast<uint32_t>(std::stoul(argv[4])) : 1;
+        bool versusBot = argc > 5 && std::string(argv[5]) == "bot";
+        return runTournament(config, matches, ticks, seed, versusBot);
+    }
+
     if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO | SDL_INIT_GAMECONTROLLER) < 0) {
         SDL_Log("SDL initialization failed: %s", SDL_GetError());
         return 1;
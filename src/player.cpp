@@ -1,33 +1,29 @@
 #include "player.h"
-#include "game.h"
+#include "simulation.h"
 #include <SDL2/SDL.h>
+#include <algorithm>
 #include <cmath>
 
 PlayerManager::PlayerManager(const GameConfig& config) : config(config) {}
 
-void PlayerManager::updatePlayers(SDL_GameController* controllers[], int controllerCount, Player& player1, Player& player2,
-                                 Collectible& collectible, std::vector<Explosion>& explosions, std::vector<Flash>& flashes,
-                                 int& score1, int& score2, int& roundScore1, int& roundScore2, std::mt19937& rng,
-                                 float dt, float currentTimeSec, AudioManager& audio, CollectibleManager& collectibleManager,
-                                 ExplosionManager& explosionManager, CircleManager& circleManager, std::vector<Circle>& circles,
-                                 std::chrono::steady_clock::time_point& lastCircleSpawn, Game* game,
-                                 const std::vector<unsigned char>& framebuffer, int drawableWidth, int drawableHeight, SDL_Color SDLaicolor) {
-    dt = std::min(dt, 0.008333f); // 120 FPS cap
-
-    for (auto* player : {&player1, &player2}) {
-        if (!player->alive && game->shouldRespawnPlayer(player, currentTimeSec)) {
+void PlayerManager::updatePlayers(const InputFrame& input, Simulation& sim, float dt,
+                                  const PixelSnapshot& framebuffer, int drawableWidth, int drawableHeight) {
+    for (auto* player : {&sim.player1, &sim.player2}) {
+        int index = sim.playerIndex(player);
+        if (!player->alive && sim.shouldRespawnPlayer(player)) {
             player->alive = true;
-            player->pos = game->getSpawnPosition();
+            player->pos = sim.getSpawnPosition();
+            player->prevPos = player->pos;
             player->direction = Vec2(1.0f, 0.0f);
-            player->trail.clear();
+            sim.clearTrail(player);
             player->noCollisionTimer = config.INVINCIBILITY_DURATION;
             player->isInvincible = true;
-            flashes.emplace_back(
-                explosionManager.createFlash(player->pos, rng, dt, currentTimeSec, {255, 0, 255, 255}));
-            audio.playLaserZap(currentTimeSec);
+            sim.flashes.emplace_back(
+                sim.explosionManager.createFlash(player->pos, sim.rng, dt, sim.time, {255, 0, 255, 255}));
+            sim.events |= SIM_EVENT_LASER_ZAP;
             if (config.ENABLE_DEBUG) {
-                SDL_Log("Invincibility started for player %s at (%f, %f), time=%f, magenta flash triggered",
-                        player == &player1 ? "1" : "2", player->pos.x, player->pos.y, currentTimeSec);
+                SDL_Log("Invincibility started for player %d at (%f, %f), time=%f, magenta flash triggered",
+                        index + 1, player->pos.x, player->pos.y, sim.time);
             }
         }
 
@@ -35,38 +31,36 @@ void PlayerManager::updatePlayers(SDL_GameController* controllers[], int control
 
         Vec2 newDir = player->direction;
         float speed = config.PLAYER_SPEED; // Assumed 200.0f to match AI_SPEED
-
-        if (player == &player2 && game->ai && game->ai->getMode()) {
-            // AI-controlled player2
-            game->ai->startUpdate(*player, player1, collectible, circles, dt, rng, *game,
-                                  framebuffer, drawableWidth, drawableHeight, game->SDLaicolor);
-            game->ai->waitForUpdate();
-            game->ai->applyUpdate(*player);
+        float leftTrigger = input.leftTrigger[index];
+        float rightTrigger = input.rightTrigger[index];
+        bool aiControlled = sim.aiControlled[index];
+
+        if (aiControlled) {
+            // AI steering, AI_TURN_SPEED is degrees per second
+            float rotation = (rightTrigger - leftTrigger) * config.AI_TURN_SPEED * static_cast<float>(M_PI) / 180.0f * dt;
+            if (std::abs(rotation) > 0) {
+                float cosTheta = std::cos(rotation);
+                float sinTheta = std::sin(rotation);
+                newDir = Vec2(
+                    player->direction.x * cosTheta - player->direction.y * sinTheta,
+                    player->direction.x * sinTheta + player->direction.y * cosTheta
+                ).normalized();
+            }
         } else {
             // Human-controlled player
-            int index = (player == &player1) ? 0 : 1;
-            float turn = 0.0f;
-            bool triggerFlash = false;
-
-            if (index < controllerCount && controllers[index] && SDL_GameControllerGetAttached(controllers[index])) {
-                Sint16 leftTrigger = SDL_GameControllerGetAxis(controllers[index], SDL_CONTROLLER_AXIS_TRIGGERLEFT);
-                Sint16 rightTrigger = SDL_GameControllerGetAxis(controllers[index], SDL_CONTROLLER_AXIS_TRIGGERRIGHT);
-                if (leftTrigger > 0 || rightTrigger > 0) {
-                    player->hasMoved = true;
-                }
-                turn = (rightTrigger - leftTrigger) / 32768.0f * config.TURN_SPEED * dt;
-                triggerFlash = SDL_GameControllerGetButton(controllers[index], SDL_CONTROLLER_BUTTON_A);
+            if (leftTrigger > 0 || rightTrigger > 0) {
+                player->hasMoved = true;
             }
-
+            float turn = (rightTrigger - leftTrigger) * config.TURN_SPEED * dt;
             float angle = atan2(player->direction.y, player->direction.x) + turn;
             newDir = Vec2(cos(angle), sin(angle)).normalized();
+        }
 
-            if (triggerFlash && player->canUseNoCollision && !player->isInvincible) {
-                game->activateNoCollision(player, currentTimeSec);
-                if (config.ENABLE_DEBUG) {
-                    SDL_Log("Player %s triggered flash at (%f, %f), time=%f",
-                            player == &player1 ? "1" : "2", player->pos.x, player->pos.y, currentTimeSec);
-                }
+        if (input.aButton[index] && player->canUseNoCollision && !player->isInvincible) {
+            sim.activateNoCollision(player);
+            if (config.ENABLE_DEBUG) {
+                SDL_Log("Player %d triggered flash at (%f, %f), time=%f",
+                        index + 1, player->pos.x, player->pos.y, sim.time);
             }
         }
 
@@ -75,45 +69,53 @@ void PlayerManager::updatePlayers(SDL_GameController* controllers[], int control
             player->noCollisionTimer -= dt;
             player->isInvincible = true;
             if (config.ENABLE_DEBUG) {
-                SDL_Log("Player %s noCollisionTimer: %f", player == &player1 ? "1" : "2", player->noCollisionTimer);
+                SDL_Log("Player %d noCollisionTimer: %f", index + 1, player->noCollisionTimer);
             }
             if (player->noCollisionTimer <= 0) {
                 player->noCollisionTimer = 0.0f;
                 player->isInvincible = false;
                 player->endFlash = std::make_unique<Flash>(
-                    explosionManager.createFlash(player->pos, rng, dt, currentTimeSec, {255, 0, 255, 255}));
-                flashes.emplace_back(*player->endFlash);
-                audio.playLaserZap(currentTimeSec);
+                    sim.explosionManager.createFlash(player->pos, sim.rng, dt, sim.time, {255, 0, 255, 255}));
+                sim.flashes.emplace_back(*player->endFlash);
+                sim.events |= SIM_EVENT_LASER_ZAP;
                 if (config.ENABLE_DEBUG) {
-                    SDL_Log("No-collision ended for player %s at (%f, %f), time=%f, magenta flash triggered",
-                            player == &player1 ? "1" : "2", player->pos.x, player->pos.y, currentTimeSec);
+                    SDL_Log("No-collision ended for player %d at (%f, %f), time=%f, magenta flash triggered",
+                            index + 1, player->pos.x, player->pos.y, sim.time);
                 }
             }
         }
 
         Vec2 nextPos = player->pos + newDir * speed * dt;
+        if (aiControlled) {
+            // The AI keeps its berth off the walls
+            nextPos.x = std::max(config.AI_BERTH, std::min(nextPos.x, sim.orthoWidth - config.AI_BERTH));
+            nextPos.y = std::max(config.AI_BERTH, std::min(nextPos.y, sim.orthoHeight - config.AI_BERTH));
+        }
 
-        // Check pixel collision
+        // Check collision
         if (player->hasMoved && !player->isInvincible && !player->spawnInvincibilityTimer) {
-            if (framebuffer.empty()) {
+            if (config.COLLISION_MODE == 1 && framebuffer.empty()) {
                 if (config.ENABLE_DEBUG) {
-                    SDL_Log("Warning: Framebuffer empty for player %s collision check", player == &player1 ? "1" : "2");
+                    SDL_Log("Warning: Framebuffer empty for player %d collision check", index + 1);
                 }
             } else {
-                game->checkCollision(player, nextPos, currentTimeSec, framebuffer, drawableWidth, drawableHeight);
+                sim.checkCollision(player, nextPos, framebuffer, drawableWidth, drawableHeight);
             }
         }
+        if (aiControlled) {
+            player->hasMoved = true; // the AI moves from its first tick, collisions count from the next
+        }
 
         // Check wall collision
-        if (!player->willDie && (nextPos.x < 10 || nextPos.x > game->orthoWidth - 10 ||
-                                 nextPos.y < 10 || nextPos.y > game->orthoHeight - 10)) {
+        if (!player->willDie && (nextPos.x < 10 || nextPos.x > sim.orthoWidth - 10 ||
+                                 nextPos.y < 10 || nextPos.y > sim.orthoHeight - 10)) {
             player->willDie = true;
-            explosions.emplace_back(explosionManager.createExplosion(nextPos, rng, dt, currentTimeSec, player->color));
-            audio.playExplosion(currentTimeSec);
-            game->deathTime = currentTimeSec;
+            sim.explosions.emplace_back(sim.explosionManager.createExplosion(nextPos, sim.rng, dt, sim.time, player->color));
+            sim.events |= SIM_EVENT_EXPLOSION;
+            sim.deathTime = sim.time;
             if (config.ENABLE_DEBUG) {
-                SDL_Log("Player %s hit wall at (%f, %f), explosion triggered, willDie=true, orthoWidth=%f, orthoHeight=%f",
-                        player == &player1 ? "1" : "2", nextPos.x, nextPos.y, game->orthoWidth, game->orthoHeight);
+                SDL_Log("Player %d hit wall at (%f, %f), explosion triggered, willDie=true, orthoWidth=%f, orthoHeight=%f",
+                        index + 1, nextPos.x, nextPos.y, sim.orthoWidth, sim.orthoHeight);
             }
         }
 
@@ -121,27 +123,27 @@ void PlayerManager::updatePlayers(SDL_GameController* controllers[], int control
         if (!player->willDie) {
             player->pos = nextPos;
             player->direction = newDir;
-            player->trail.push_back(player->pos);
+            sim.extendTrail(player);
         }
 
         if (player->willDie) {
-            game->handlePlayerDeath(player, currentTimeSec);
-            if (player == &player1) {
-                score2 += game->deathPoints;
-                roundScore2 += game->deathPoints;
+            player->deathPos = nextPos;
+            sim.handlePlayerDeath(player);
+            if (player == &sim.player1) {
+                sim.score2 += sim.deathPoints;
+                sim.roundScore2 += sim.deathPoints;
             } else {
-                score1 += game->deathPoints;
-                roundScore1 += game->deathPoints;
+                sim.score1 += sim.deathPoints;
+                sim.roundScore1 += sim.deathPoints;
             }
             if (config.ENABLE_DEBUG) {
-                SDL_Log("Player %s died at (%f, %f), willDie=true",
-                        player == &player1 ? "1" : "2", player->pos.x, player->pos.y);
+                SDL_Log("Player %d died at (%f, %f), willDie=true", index + 1, player->pos.x, player->pos.y);
             }
         }
     }
 
-    circleManager.updateCircles(dt, circles, rng, currentTimeSec, lastCircleSpawn, *game);
-    circleManager.clearTrails(circles, player1, player2);
-    explosionManager.updateFlashes(flashes, dt, currentTimeSec, {255, 0, 255, 255});
-    explosionManager.cleanupPlayerFlashes(player1, player2, currentTimeSec);
-}
\ No newline at end of file
+    sim.circleManager.updateCircles(dt, sim.circles, sim.rng, sim.time, sim.lastCircleSpawn, sim);
+    sim.circleManager.clearTrails(sim.circles, sim);
+    sim.explosionManager.updateFlashes(sim.flashes, dt, sim.time, {255, 0, 255, 255});
+    sim.explosionManager.cleanupPlayerFlashes(sim.player1, sim.player2, sim.time);
+}
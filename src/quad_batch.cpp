@@ -0,0 +1,65 @@
+#include "quad_batch.h"
+#include <algorithm>
+#include <cstddef>
+
+QuadBatch::QuadBatch() : vertices(), vbo(0), capacity(0) {}
+
+void QuadBatch::add(float x, float y, float width, float height, const SDL_Color& color, const TexRect& tex) {
+    appendQuad(vertices, x, y, width, height, color, tex);
+}
+
+void QuadBatch::appendQuad(std::vector<QuadVertex>& out, float x, float y, float width, float height,
+                           const SDL_Color& color, const TexRect& tex) {
+    out.push_back(QuadVertex{x, y, tex.u0, tex.v0, color.r, color.g, color.b, color.a});
+    out.push_back(QuadVertex{x + width, y, tex.u1, tex.v0, color.r, color.g, color.b, color.a});
+    out.push_back(QuadVertex{x + width, y + height, tex.u1, tex.v1, color.r, color.g, color.b, color.a});
+    out.push_back(QuadVertex{x, y + height, tex.u0, tex.v1, color.r, color.g, color.b, color.a});
+}
+
+void QuadBatch::enableArrays() {
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    glVertexPointer(2, GL_FLOAT, sizeof(QuadVertex), reinterpret_cast<const void*>(offsetof(QuadVertex, x)));
+    glTexCoordPointer(2, GL_FLOAT, sizeof(QuadVertex), reinterpret_cast<const void*>(offsetof(QuadVertex, u)));
+    glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(QuadVertex), reinterpret_cast<const void*>(offsetof(QuadVertex, r)));
+}
+
+void QuadBatch::disableArrays() {
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+}
+
+// The buffer is orphaned before each upload so the driver never waits on last frame's draw
+int QuadBatch::flush(GLuint texture) {
+    if (vertices.empty()) return 0;
+    if (vbo == 0) {
+        glGenBuffers(1, &vbo);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    capacity = std::max(capacity, vertices.size());
+    glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(QuadVertex), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, vertices.size() * sizeof(QuadVertex), vertices.data());
+
+    glEnable(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    enableArrays();
+    glDrawArrays(GL_QUADS, 0, static_cast<GLsizei>(vertices.size()));
+    disableArrays();
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glDisable(GL_TEXTURE_2D);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    vertices.clear();
+    return 1;
+}
+
+void QuadBatch::shutdown() {
+    if (vbo != 0) {
+        glDeleteBuffers(1, &vbo);
+        vbo = 0;
+    }
+    capacity = 0;
+    vertices.clear();
+}
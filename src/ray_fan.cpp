@@ -0,0 +1,256 @@
+#include "ray_fan.h"
+#include "simulation.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Float lanes and the handful of operations the march needs. Masks are lanes of all ones bits.
+namespace {
+#if defined(__AVX2__)
+using Lanes = __m256;
+constexpr int WIDTH = 8;
+inline Lanes splat(float v) { return _mm256_set1_ps(v); }
+inline Lanes load(const float* p) { return _mm256_loadu_ps(p); }
+inline void store(float* p, Lanes v) { _mm256_storeu_ps(p, v); }
+inline void storeInts(int* p, Lanes v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), _mm256_cvttps_epi32(v)); }
+inline Lanes add(Lanes a, Lanes b) { return _mm256_add_ps(a, b); }
+inline Lanes sub(Lanes a, Lanes b) { return _mm256_sub_ps(a, b); }
+inline Lanes mul(Lanes a, Lanes b) { return _mm256_mul_ps(a, b); }
+inline Lanes div(Lanes a, Lanes b) { return _mm256_div_ps(a, b); }
+inline Lanes min(Lanes a, Lanes b) { return _mm256_min_ps(a, b); }
+inline Lanes max(Lanes a, Lanes b) { return _mm256_max_ps(a, b); }
+inline Lanes sqrt(Lanes a) { return _mm256_sqrt_ps(a); }
+inline Lanes both(Lanes a, Lanes b) { return _mm256_and_ps(a, b); }
+inline Lanes either(Lanes a, Lanes b) { return _mm256_or_ps(a, b); }
+inline Lanes butNot(Lanes a, Lanes b) { return _mm256_andnot_ps(b, a); } // a and not b
+inline Lanes less(Lanes a, Lanes b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+inline Lanes lessEqual(Lanes a, Lanes b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+inline Lanes equal(Lanes a, Lanes b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+inline Lanes notEqual(Lanes a, Lanes b) { return _mm256_cmp_ps(a, b, _CMP_NEQ_UQ); }
+inline Lanes select(Lanes mask, Lanes a, Lanes b) { return _mm256_blendv_ps(b, a, mask); }
+inline bool any(Lanes mask) { return _mm256_movemask_ps(mask) != 0; }
+#elif defined(__SSE2__)
+using Lanes = __m128;
+constexpr int WIDTH = 4;
+inline Lanes splat(float v) { return _mm_set1_ps(v); }
+inline Lanes load(const float* p) { return _mm_loadu_ps(p); }
+inline void store(float* p, Lanes v) { _mm_storeu_ps(p, v); }
+inline void storeInts(int* p, Lanes v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), _mm_cvttps_epi32(v)); }
+inline Lanes add(Lanes a, Lanes b) { return _mm_add_ps(a, b); }
+inline Lanes sub(Lanes a, Lanes b) { return _mm_sub_ps(a, b); }
+inline Lanes mul(Lanes a, Lanes b) { return _mm_mul_ps(a, b); }
+inline Lanes div(Lanes a, Lanes b) { return _mm_div_ps(a, b); }
+inline Lanes min(Lanes a, Lanes b) { return _mm_min_ps(a, b); }
+inline Lanes max(Lanes a, Lanes b) { return _mm_max_ps(a, b); }
+inline Lanes sqrt(Lanes a) { return _mm_sqrt_ps(a); }
+inline Lanes both(Lanes a, Lanes b) { return _mm_and_ps(a, b); }
+inline Lanes either(Lanes a, Lanes b) { return _mm_or_ps(a, b); }
+inline Lanes butNot(Lanes a, Lanes b) { return _mm_andnot_ps(b, a); } // a and not b
+inline Lanes less(Lanes a, Lanes b) { return _mm_cmplt_ps(a, b); }
+inline Lanes lessEqual(Lanes a, Lanes b) { return _mm_cmple_ps(a, b); }
+inline Lanes equal(Lanes a, Lanes b) { return _mm_cmpeq_ps(a, b); }
+inline Lanes notEqual(Lanes a, Lanes b) { return _mm_cmpneq_ps(a, b); }
+inline Lanes select(Lanes mask, Lanes a, Lanes b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+inline bool any(Lanes mask) { return _mm_movemask_ps(mask) != 0; }
+#else
+constexpr int WIDTH = 1; // no vector unit known: cast() walks the rays one by one
+#endif
+}
+
+const int RayFan::LANES = WIDTH;
+
+RayFan::RayFan()
+    : grid(nullptr),
+      field(nullptr),
+      minX(0.0f),
+      minY(0.0f),
+      maxX(0.0f),
+      maxY(0.0f),
+      boxes{},
+      boxCount(0),
+      ownHead(static_cast<uint8_t>(CellType::HeadP2)),
+      circleSlack(0.0f),
+      boxSlack(0.0f) {}
+
+void RayFan::prepare(const Simulation& sim, const DistanceField& distanceField, float berth, int self) {
+    grid = &sim.collisionGrid;
+    field = &distanceField;
+    minX = berth;
+    minY = berth;
+    maxX = sim.orthoWidth - berth;
+    maxY = sim.orthoHeight - berth;
+    ownHead = static_cast<uint8_t>(self == 0 ? CellType::HeadP1 : CellType::HeadP2);
+
+    // A disc marks cells whose centre it covers, a rect every cell it touches
+    float gridCell = grid->getCellSize();
+    circleSlack = distanceField.getCellSize() * 0.7072f + gridCell * 0.7072f;
+    boxSlack = gridCell * 1.4143f;
+
+    boxCount = 0;
+    if (sim.collectible.active) {
+        boxes[boxCount++] = Box{sim.collectible.pos.x, sim.collectible.pos.y, sim.collectible.size / 2.0f};
+    }
+    const Player& other = self == 0 ? sim.player2 : sim.player1;
+    if (other.alive) {
+        boxes[boxCount++] = Box{other.pos.x, other.pos.y, sim.config.PLAYER_SIZE / 2.0f};
+    }
+}
+
+float RayFan::clearDistance(const Vec2& pos) const {
+    float clear = field->trailDistance(pos);
+    clear = std::min(clear, field->circleDistance(pos) - circleSlack);
+    for (int i = 0; i < boxCount; ++i) {
+        float dx = std::max(std::abs(pos.x - boxes[i].x) - boxes[i].half, 0.0f);
+        float dy = std::max(std::abs(pos.y - boxes[i].y) - boxes[i].half, 0.0f);
+        clear = std::min(clear, std::sqrt(dx * dx + dy * dy) - boxSlack);
+    }
+    return clear;
+}
+
+// Distance along dir to the berth box edge; jumps stop just past it so the wall is reported
+float RayFan::wallExit(const Vec2& start, const Vec2& dir) const {
+    float exit = 1e30f;
+    if (dir.x > 0.0f) exit = std::min(exit, (maxX - start.x) / dir.x);
+    if (dir.x < 0.0f) exit = std::min(exit, (minX - start.x) / dir.x);
+    if (dir.y > 0.0f) exit = std::min(exit, (maxY - start.y) / dir.y);
+    if (dir.y < 0.0f) exit = std::min(exit, (minY - start.y) / dir.y);
+    return exit + 0.01f;
+}
+
+// What CollisionGrid::sample(pos, self) reports for the cell
+CellType RayFan::classify(size_t index) const {
+    uint8_t top = grid->overlayCells()[index];
+    if (top != static_cast<uint8_t>(CellType::Empty) && top != ownHead) return static_cast<CellType>(top);
+    CellType line = static_cast<CellType>(grid->trailCells()[index]);
+    if (line == CellType::TrailP1 && grid->isTrailVisible(0)) return line;
+    if (line == CellType::TrailP2 && grid->isTrailVisible(1)) return line;
+    return CellType::Empty;
+}
+
+void RayFan::castOne(const Vec2& start, const Vec2& dir, float maxDistance, Hit& out) const {
+    float exit = wallExit(start, dir);
+    float cellSize = grid->getCellSize();
+    out = Hit{maxDistance, CellType::Empty};
+    for (float t = 0.0f; t <= maxDistance;) {
+        Vec2 pos = start + dir * t;
+        if (pos.x < minX || pos.x > maxX || pos.y < minY || pos.y > maxY) {
+            out = Hit{t, CellType::Wall};
+            return;
+        }
+        int cx = std::min(static_cast<int>(pos.x / cellSize), grid->getCols() - 1);
+        int cy = std::min(static_cast<int>(pos.y / cellSize), grid->getRows() - 1);
+        CellType cell = classify(static_cast<size_t>(cy) * grid->getCols() + cx);
+        if (cell == CellType::Collectible || CollisionGrid::isDangerToAI(cell)) {
+            out = Hit{t, cell};
+            return;
+        }
+        t += std::max(STEP_SIZE, std::min(clearDistance(pos), exit - t));
+    }
+}
+
+void RayFan::cast(const Vec2& start, const Vec2* dirs, int count, float maxDistance, Hit* out) const {
+#if defined(__AVX2__) || defined(__SSE2__)
+    const float gridCell = grid->getCellSize();
+    const float fieldCell = field->getCellSize();
+    const int gridCols = grid->getCols(), gridRows = grid->getRows();
+    const int fieldCols = field->getCols(), fieldRows = field->getRows();
+    const uint8_t* overlay = grid->overlayCells();
+    const uint8_t* trail = grid->trailCells();
+    const float* trailPlane = field->trailPlane();
+    const float* circlePlane = field->circlePlane();
+    const Lanes zero = splat(0.0f);
+    const Lanes ones = equal(zero, zero);
+    const Lanes visible1 = grid->isTrailVisible(0) ? ones : zero;
+    const Lanes visible2 = grid->isTrailVisible(1) ? ones : zero;
+    auto is = [](Lanes cell, CellType type) { return equal(cell, splat(static_cast<float>(type))); };
+
+    for (int first = 0; first < count; first += WIDTH) {
+        int n = std::min(WIDTH, count - first);
+        alignas(32) float dxs[WIDTH], dys[WIDTH], exits[WIDTH], live[WIDTH];
+        for (int l = 0; l < WIDTH; ++l) {
+            const Vec2& dir = dirs[first + std::min(l, n - 1)]; // spare lanes repeat the last ray
+            dxs[l] = dir.x;
+            dys[l] = dir.y;
+            exits[l] = wallExit(start, dir);
+            live[l] = l < n ? 1.0f : 0.0f;
+        }
+        Lanes dx = load(dxs), dy = load(dys), exit = load(exits);
+        Lanes active = equal(load(live), splat(1.0f));
+        Lanes t = zero;
+        Lanes hitT = splat(maxDistance);
+        Lanes hitCell = splat(static_cast<float>(CellType::Empty));
+
+        while (true) {
+            active = both(active, lessEqual(t, splat(maxDistance)));
+            if (!any(active)) break;
+            Lanes px = add(splat(start.x), mul(dx, t));
+            Lanes py = add(splat(start.y), mul(dy, t));
+
+            Lanes outside = either(either(less(px, splat(minX)), less(splat(maxX), px)),
+                                   either(less(py, splat(minY)), less(splat(maxY), py)));
+            Lanes wall = both(active, outside);
+            hitT = select(wall, t, hitT);
+            hitCell = select(wall, splat(static_cast<float>(CellType::Wall)), hitCell);
+            active = butNot(active, outside);
+
+            // Cell lookups are per lane; lanes that are done read a clamped cell and are ignored
+            alignas(32) int gx[WIDTH], gy[WIDTH], fx[WIDTH], fy[WIDTH];
+            storeInts(gx, div(max(px, zero), splat(gridCell)));
+            storeInts(gy, div(max(py, zero), splat(gridCell)));
+            storeInts(fx, div(max(px, zero), splat(fieldCell)));
+            storeInts(fy, div(max(py, zero), splat(fieldCell)));
+            alignas(32) float tops[WIDTH], lines[WIDTH], trails[WIDTH], circles[WIDTH];
+            for (int l = 0; l < WIDTH; ++l) {
+                size_t g = static_cast<size_t>(std::min(gy[l], gridRows - 1)) * gridCols + std::min(gx[l], gridCols - 1);
+                size_t f = static_cast<size_t>(std::min(fy[l], fieldRows - 1)) * fieldCols + std::min(fx[l], fieldCols - 1);
+                tops[l] = overlay[g];
+                lines[l] = trail[g];
+                trails[l] = trailPlane[f];
+                circles[l] = circlePlane[f];
+            }
+
+            // The overlay wins unless it is empty or the AI's own head, then a drawn line
+            Lanes top = load(tops), line = load(lines);
+            Lanes useTop = both(notEqual(top, zero), notEqual(top, splat(static_cast<float>(ownHead))));
+            Lanes lineShown = either(both(is(line, CellType::TrailP1), visible1), both(is(line, CellType::TrailP2), visible2));
+            Lanes cell = select(useTop, top, select(lineShown, line, zero));
+            Lanes danger = either(either(is(cell, CellType::TrailP1), is(cell, CellType::TrailP2)),
+                                  either(either(is(cell, CellType::HeadP1), is(cell, CellType::HeadP2)),
+                                         is(cell, CellType::CircleDanger)));
+            Lanes stop = both(active, either(danger, is(cell, CellType::Collectible)));
+            hitT = select(stop, t, hitT);
+            hitCell = select(stop, cell, hitCell);
+            active = butNot(active, stop);
+
+            // Same step as clearDistance, lane by lane
+            Lanes clear = max(sub(load(trails), splat(fieldCell * 1.4143f)), zero);
+            clear = min(clear, sub(load(circles), splat(circleSlack)));
+            for (int i = 0; i < boxCount; ++i) {
+                Lanes half = splat(boxes[i].half);
+                Lanes ox = sub(px, splat(boxes[i].x)), oy = sub(py, splat(boxes[i].y));
+                Lanes bx = max(sub(max(ox, sub(zero, ox)), half), zero);
+                Lanes by = max(sub(max(oy, sub(zero, oy)), half), zero);
+                clear = min(clear, sub(sqrt(add(mul(bx, bx), mul(by, by))), splat(boxSlack)));
+            }
+            Lanes step = max(splat(STEP_SIZE), min(clear, sub(exit, t)));
+            t = select(active, add(t, step), t);
+        }
+
+        alignas(32) float ts[WIDTH], cells[WIDTH];
+        store(ts, hitT);
+        store(cells, hitCell);
+        for (int l = 0; l < n; ++l) {
+            out[first + l] = Hit{ts[l], static_cast<CellType>(static_cast<int>(cells[l]))};
+        }
+    }
+#else
+    for (int i = 0; i < count; ++i) {
+        castOne(start, dirs[i], maxDistance, out[i]);
+    }
+#endif
+}
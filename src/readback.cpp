@@ -0,0 +1,169 @@
+#include "readback.h"
+#include <SDL2/SDL.h>
+#include <algorithm>
+#include <stdexcept>
+
+ReadbackManager::ReadbackManager(const GameConfig& config)
+    : config(config),
+      bufferCount(config.READBACK_BUFFERS <= 0 ? 0 : std::clamp(config.READBACK_BUFFERS, 2, MAX_BUFFERS)),
+      pbos{0, 0, 0},
+      writeIndex(0),
+      framesQueued(0),
+      mappedIndex(-1),
+      width(0),
+      height(0),
+      pixels(),
+      regions(),
+      tileMask(),
+      bytesLastFrame(0) {}
+
+void ReadbackManager::addRegion(float minX, float minY, float maxX, float maxY) {
+    if (config.READBACK_ROI) {
+        regions.push_back(Region{minX, minY, maxX, maxY});
+    }
+}
+
+// Read only the tiles that any requested region touches, one glReadPixels per run of
+// neighbouring tiles in a tile row. Pixels land at their full-frame offsets so lookups do not change.
+void ReadbackManager::readRegions(unsigned char* dest, float orthoWidth, float orthoHeight) {
+    int tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+    int tilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+    tileMask.assign(static_cast<size_t>(tilesX) * tilesY, 0);
+
+    for (const Region& r : regions) {
+        // Ortho y points down, window y points up
+        float x0 = std::max(0.0f, r.minX / orthoWidth * width);
+        float x1 = std::min(width - 1.0f, r.maxX / orthoWidth * width);
+        float y0 = std::max(0.0f, (1.0f - r.maxY / orthoHeight) * height);
+        float y1 = std::min(height - 1.0f, (1.0f - r.minY / orthoHeight) * height);
+        if (x0 > x1 || y0 > y1) continue;
+        for (int ty = static_cast<int>(y0) / TILE_SIZE; ty <= static_cast<int>(y1) / TILE_SIZE; ++ty) {
+            for (int tx = static_cast<int>(x0) / TILE_SIZE; tx <= static_cast<int>(x1) / TILE_SIZE; ++tx) {
+                tileMask[static_cast<size_t>(ty) * tilesX + tx] = 1;
+            }
+        }
+    }
+
+    glPixelStorei(GL_PACK_ROW_LENGTH, width);
+    for (int ty = 0; ty < tilesY; ++ty) {
+        int y = ty * TILE_SIZE;
+        int h = std::min(TILE_SIZE, height - y);
+        int tx = 0;
+        while (tx < tilesX) {
+            if (!tileMask[static_cast<size_t>(ty) * tilesX + tx]) { ++tx; continue; }
+            int runStart = tx;
+            while (tx < tilesX && tileMask[static_cast<size_t>(ty) * tilesX + tx]) ++tx;
+            int x = runStart * TILE_SIZE;
+            int w = std::min(tx * TILE_SIZE, width) - x;
+            glPixelStorei(GL_PACK_SKIP_PIXELS, x);
+            glPixelStorei(GL_PACK_SKIP_ROWS, y);
+            glReadPixels(x, y, w, h, GL_RGB, GL_UNSIGNED_BYTE, dest);
+            bytesLastFrame += static_cast<size_t>(w) * h * 3;
+        }
+    }
+    glPixelStorei(GL_PACK_ROW_LENGTH, 0);
+    glPixelStorei(GL_PACK_SKIP_PIXELS, 0);
+    glPixelStorei(GL_PACK_SKIP_ROWS, 0);
+}
+
+// (Re)create storage for the current drawable size. GL objects are made here and not in
+// the constructor because the GL context does not exist yet when Game builds its members.
+void ReadbackManager::allocate(int drawableWidth, int drawableHeight) {
+    width = drawableWidth;
+    height = drawableHeight;
+    size_t size = static_cast<size_t>(width) * height * 3;
+    if (size > std::vector<unsigned char>().max_size()) {
+        SDL_Log("Error: Framebuffer size %zu exceeds max vector size %zu", size, std::vector<unsigned char>().max_size());
+        throw std::length_error("Framebuffer too large for vector");
+    }
+
+    if (bufferCount == 0) {
+        pixels.resize(size);
+        framesQueued = 0;
+        return;
+    }
+
+    if (pbos[0] == 0) {
+        glGenBuffers(bufferCount, pbos);
+    }
+    for (int i = 0; i < bufferCount; ++i) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos[i]);
+        glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    writeIndex = 0;
+    framesQueued = 0;
+    if (config.ENABLE_DEBUG) {
+        SDL_Log("Readback ring: %d pixel buffers of %zu bytes", bufferCount, size);
+    }
+}
+
+PixelSnapshot ReadbackManager::readFrame(int drawableWidth, int drawableHeight, float orthoWidth, float orthoHeight) {
+    release();
+    if (drawableWidth != width || drawableHeight != height) {
+        allocate(drawableWidth, drawableHeight);
+    }
+
+    size_t size = static_cast<size_t>(width) * height * 3;
+    glPixelStorei(GL_PACK_ALIGNMENT, 1); // rows are tightly packed RGB
+    bytesLastFrame = 0;
+
+    // Every buffer gets one whole frame first so no region reads garbage
+    bool partial = config.READBACK_ROI && !regions.empty() && framesQueued >= std::max(bufferCount, 1);
+
+    if (bufferCount == 0) {
+        if (partial) {
+            readRegions(pixels.data(), orthoWidth, orthoHeight);
+        } else {
+            glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+            bytesLastFrame = size;
+        }
+        framesQueued = 1;
+        regions.clear();
+        return PixelSnapshot{pixels.data(), size};
+    }
+
+    // Queue this frame's read; it completes in the background
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos[writeIndex]);
+    if (partial) {
+        readRegions(nullptr, orthoWidth, orthoHeight);
+    } else {
+        glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+        bytesLastFrame = size;
+    }
+    regions.clear();
+    writeIndex = (writeIndex + 1) % bufferCount;
+    framesQueued = std::min(framesQueued + 1, bufferCount);
+
+    // The oldest buffer in the ring is the one to map, once the ring has filled up
+    PixelSnapshot snapshot;
+    if (framesQueued == bufferCount) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos[writeIndex]);
+        const void* mapped = glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+        if (mapped) {
+            mappedIndex = writeIndex;
+            snapshot = PixelSnapshot{static_cast<const unsigned char*>(mapped), size};
+        } else if (config.ENABLE_DEBUG) {
+            SDL_Log("glMapBuffer failed for readback buffer %d", writeIndex);
+        }
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    return snapshot;
+}
+
+void ReadbackManager::release() {
+    if (mappedIndex < 0) return;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos[mappedIndex]);
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    mappedIndex = -1;
+}
+
+void ReadbackManager::shutdown() {
+    release();
+    if (pbos[0] != 0) {
+        glDeleteBuffers(bufferCount, pbos);
+        std::fill(pbos, pbos + MAX_BUFFERS, 0);
+    }
+    width = height = 0;
+}
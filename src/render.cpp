@@ -2,46 +2,87 @@
 #include "game.h"
 #include <GL/gl.h>
 #include <chrono>
+#include <algorithm>
+#include <cctype>
 #include <cmath>
 
-RenderManager::RenderManager(const GameConfig& config) : config(config) {}
+RenderManager::RenderManager(const GameConfig& config)
+    : config(config),
+      trailBuffers(),
+      trailLayer(config),
+      quads(),
+      circles(),
+      atlas(),
+      textCache(),
+      labels(),
+      drawCalls(0),
+      drawCallsLastFrame(0) {}
 
-void RenderManager::drawSquare(float x, float y, float size, const SDL_Color& color) const {
-    glColor4ub(color.r, color.g, color.b, color.a);
-    glBegin(GL_QUADS);
-    glVertex2f(x, y);
-    glVertex2f(x + size, y);
-    glVertex2f(x + size, y + size);
-    glVertex2f(x, y + size);
-    glEnd();
+void RenderManager::shutdown() {
+    for (auto& buffer : trailBuffers) {
+        buffer.shutdown();
+    }
+    trailLayer.shutdown();
+    quads.shutdown();
+    circles.shutdown();
+    textCache.shutdown();
+    atlas.shutdown();
 }
 
-void RenderManager::drawBlackCircle(float x, float y, float radius) const {
-    glColor4ub(0, 0, 0, 255); // Black, safe color
-    glBegin(GL_TRIANGLE_FAN);
-    glVertex2f(x, y);
-    for (int i = 0; i <= 20; ++i) {
-        float angle = 2.0f * M_PI * i / 20.0f;
-        glVertex2f(x + radius * cos(angle), y + radius * sin(angle));
-    }
-    glEnd();
+void RenderManager::beginFrame() {
+    drawCalls = 0;
+}
+
+void RenderManager::endFrame() {
+    flushCircles();
+    flushQuads();
+    drawCallsLastFrame = drawCalls;
+    textCache.endFrame();
 }
 
-void RenderManager::drawCircle(float x, float y, float radius, const SDL_Color& color) const {
-    // Draw black circle to erase trails
-    drawBlackCircle(x, y, radius);
-    // Draw colored circle (magenta or yellow)
-    glColor4ub(color.r, color.g, color.b, color.a);
-    glBegin(GL_TRIANGLE_FAN);
-    glVertex2f(x, y);
-    for (int i = 0; i <= 20; ++i) {
-        float angle = 2.0f * M_PI * i / 20.0f;
-        glVertex2f(x + radius * cos(angle), y + radius * sin(angle));
+const std::string& RenderManager::label(Label id, int a, int b) {
+    LabelText& cached = labels[id];
+    if (cached.built && cached.a == a && cached.b == b) return cached.text;
+    switch (id) {
+        case SCORE: cached.text = std::to_string(a) + "-" + std::to_string(b); break;
+        case SETS1:
+        case SETS2: cached.text = "W:" + std::to_string(a); break;
+        case ROUND: cached.text = "+" + std::to_string(a) + " - +" + std::to_string(b); break;
+        case COUNTDOWN: cached.text = std::to_string(a); break;
+        default: cached.text.clear(); break;
     }
-    glEnd();
+    cached.a = a;
+    cached.b = b;
+    cached.built = true;
+    return cached.text;
+}
+
+// Painter's order: whichever batch was filled first is drawn first
+void RenderManager::flushQuads() {
+    drawCalls += quads.flush(atlas.texture());
+}
+
+void RenderManager::flushCircles() {
+    drawCalls += circles.flush();
+}
+
+void RenderManager::drawSquare(float x, float y, float size, const SDL_Color& color) {
+    if (!circles.empty()) flushCircles();
+    quads.add(x, y, size, size, color, GlyphAtlas::solid());
+}
+
+void RenderManager::drawBlackCircle(float x, float y, float radius) {
+    drawCircle(x, y, radius, {0, 0, 0, 255}); // Black, safe color
 }
 
-void RenderManager::drawExplosion(const Explosion& explosion, float currentTimeSec) const {
+// Circles drawn in a row all go black first and then all take their colors. Each black covers
+// no more than its own color does, so the picture is the same as drawing them one at a time.
+void RenderManager::drawCircle(float x, float y, float radius, const SDL_Color& color) {
+    flushQuads();
+    circles.add(x, y, radius, color);
+}
+
+void RenderManager::drawExplosion(const Explosion& explosion, float currentTimeSec) {
     float elapsed = currentTimeSec - explosion.startTime;
     if (elapsed > config.EXPLOSION_DURATION) return;
     for (const auto& particle : explosion.particles) {
@@ -52,55 +93,74 @@ void RenderManager::drawExplosion(const Explosion& explosion, float currentTimeS
     }
 }
 
-void RenderManager::drawText(const std::string& text, float x, float y, float squareSize, const SDL_Color& color) const {
-    float currentX = x;
-    for (char c : text) {
-        if (FONT.find(c) == FONT.end()) continue;
-        const auto& pattern = FONT.at(c);
-        for (int row = 0; row < 5; ++row) {
-            for (int col = 0; col < 5; ++col) {
-                if (pattern[row * 5 + col]) {
-                    drawSquare(currentX + col * squareSize, y + row * squareSize, squareSize, color);
-                }
-            }
-        }
-        currentX += 6 * squareSize; // Fixed-width: 5 pixels + 1 pixel spacing
+void RenderManager::drawText(std::string_view text, float x, float y, float squareSize, const SDL_Color& color) {
+    flushCircles();
+    flushQuads();
+    drawCalls += textCache.draw(text, x, y, squareSize, color, atlas.texture());
+}
+
+// Glyph quads into the frame's batch: no mesh to build or keep, no draw of its own
+void RenderManager::batchText(std::string_view text, float x, float y, float squareSize, const SDL_Color& color) {
+    if (!circles.empty()) flushCircles();
+    TextCache::buildMesh(text, x, y, squareSize, color, quads.pending());
+}
+
+// One line per phase in microseconds and per counter per decision, over the last
+// AIProfiler::WINDOW decisions: count, p50, p95, p99. Then the draw calls of the last frame.
+void RenderManager::drawAIStats(const AIProfiler& profiler, float x, float y) {
+    const float squareSize = 2.0f;
+    const float lineHeight = 7 * squareSize;
+    const SDL_Color color = {255, 255, 255, 255};
+    auto pad = [](std::string text, size_t width) {
+        text.resize(std::max(width, text.size()), ' ');
+        return text;
+    };
+    auto line = [&](const char* name, const AIProfiler::Summary& s) {
+        std::string upper = name;
+        for (char& c : upper) c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+        std::string text = pad(upper, 10) + pad(std::to_string(s.count), 5) +
+                           pad(std::to_string(std::lround(s.p50)), 8) + pad(std::to_string(std::lround(s.p95)), 8) +
+                           std::to_string(std::lround(s.p99));
+        batchText(text, x, y, squareSize, color);
+        y += lineHeight;
+    };
+    drawText(pad("AI US", 10) + pad("N", 5) + pad("P50", 8) + pad("P95", 8) + "P99", x, y, squareSize, color);
+    y += lineHeight;
+    for (int i = 0; i < AIProfiler::PHASE_COUNT; ++i) {
+        auto phase = static_cast<AIProfiler::Phase>(i);
+        line(AIProfiler::phaseName(phase), profiler.phase(phase));
+    }
+    for (int i = 0; i < AIProfiler::COUNTER_COUNT; ++i) {
+        auto counter = static_cast<AIProfiler::Counter>(i);
+        line(AIProfiler::counterName(counter), profiler.counter(counter));
     }
+    batchText(pad("DRAWS", 10) + std::to_string(drawCallsLastFrame), x, y, squareSize, color);
 }
 
-void RenderManager::drawPlayer(const Player& player) const {
+void RenderManager::drawPlayer(const Player& player, float alpha) {
     if (!player.alive) return;
-    drawSquare(player.pos.x - config.PLAYER_SIZE / 2, player.pos.y - config.PLAYER_SIZE / 2, config.PLAYER_SIZE, player.color);
+    Vec2 pos = player.prevPos + (player.pos - player.prevPos) * alpha;
+    drawSquare(pos.x - config.PLAYER_SIZE / 2, pos.y - config.PLAYER_SIZE / 2, config.PLAYER_SIZE, player.color);
 }
 
-void RenderManager::drawTrail(const Player& player, int skipRecent) const {
-    if (!player.alive || player.trail.size() < 2) return;
+void RenderManager::drawTrail(const Player& player, int slot) {
+    if (!player.alive || player.trail.size() == 0) return;
 
+    flushCircles();
+    flushQuads();
     glColor4ub(player.color.r, player.color.g, player.color.b, player.color.a);
     glLineWidth(config.TRAIL_SIZE);
-    glBegin(GL_LINES);
-
-    // Draw trail segments, checking for gaps (large distances)
-    for (size_t i = 0; i < player.trail.size() - 1 - skipRecent; ++i) {
-        const auto& current = player.trail[i];
-        const auto& next = player.trail[i + 1];
-        // Skip drawing if points are too far apart (indicating a gap from clearTrails)
-        float distance = (next - current).magnitude();
-        if (distance < 50.0f) { // Threshold to detect gaps
-            glVertex2f(current.x, current.y);
-            glVertex2f(next.x, next.y);
-        }
-    }
-
-    glEnd();
+    trailBuffers[slot].draw(player.trail);
     glLineWidth(1.0f);
+    ++drawCalls;
 }
 
-void RenderManager::drawCollectibleGreenSquare(const Collectible& collectible) const {
+void RenderManager::drawCollectibleGreenSquare(const Collectible& collectible) {
     drawSquare(collectible.pos.x - collectible.size / 2, collectible.pos.y - collectible.size / 2, collectible.size, {0, 255, 0, 255});
 }
 
-void RenderManager::renderSplashScreen(GLuint texture) const {
+void RenderManager::renderSplashScreen(GLuint texture) {
+    beginFrame();
     glEnable(GL_TEXTURE_2D);
     glBindTexture(GL_TEXTURE_2D, texture);
     glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
@@ -111,22 +171,26 @@ void RenderManager::renderSplashScreen(GLuint texture) const {
     glTexCoord2f(0, 1); glVertex2f(0, config.HEIGHT);
     glEnd();
     glDisable(GL_TEXTURE_2D);
+    ++drawCalls;
+    endFrame();
 }
 
-void RenderManager::renderGame(const Game& game, float currentTimeSec) const {
+void RenderManager::renderGame(const Game& game, float currentTimeSec, float alpha) {
     int drawableWidth, drawableHeight;
     SDL_GL_GetDrawableSize(game.window, &drawableWidth, &drawableHeight);
     glViewport(0, 0, drawableWidth, drawableHeight);
     glMatrixMode(GL_PROJECTION);
     glLoadIdentity();
-    glOrtho(0, game.orthoWidth, game.orthoHeight, 0, -1, 1);
+    glOrtho(0, game.sim.orthoWidth, game.sim.orthoHeight, 0, -1, 1);
     glMatrixMode(GL_MODELVIEW);
     glLoadIdentity();
+    beginFrame();
+    bool layered = trailLayer.update(game.sim, drawableWidth, drawableHeight, trailBuffers, drawCalls);
 
-    for (const auto& explosion : game.explosions) {
+    for (const auto& explosion : game.sim.explosions) {
         drawExplosion(explosion, currentTimeSec);
     }
-    for (const auto& flash : game.flashes) {
+    for (const auto& flash : game.sim.flashes) {
         float elapsed = currentTimeSec - flash.startTime;
         if (elapsed > 0.3f) continue;
         for (const auto& particle : flash.particles) {
@@ -137,30 +201,42 @@ void RenderManager::renderGame(const Game& game, float currentTimeSec) const {
         }
     }
     // Draw trails before circles to allow circles to overwrite them
-    if (!game.player1.isInvincible) drawTrail(game.player1);
-    if (!game.player2.isInvincible) drawTrail(game.player2);
-    drawCollectibleGreenSquare(game.collectible);
-    for (const auto& circle : game.circles) {
-        drawCircle(circle.pos.x, circle.pos.y, circle.radius, circle.SDLcirclecolor);
+    if (layered) {
+        flushCircles();
+        flushQuads();
+        trailLayer.composite(drawCalls);
+    } else {
+        if (!game.sim.player1.isInvincible) drawTrail(game.sim.player1, 0);
+        if (!game.sim.player2.isInvincible) drawTrail(game.sim.player2, 1);
+    }
+    drawCollectibleGreenSquare(game.sim.collectible);
+    for (const auto& circle : game.sim.circles) {
+        Vec2 pos = circle.prevPos + (circle.pos - circle.prevPos) * alpha;
+        drawCircle(pos.x, pos.y, circle.radius, circle.SDLcirclecolor);
+    }
+    drawPlayer(game.sim.player1, alpha);
+    drawPlayer(game.sim.player2, alpha);
+
+    if (game.showAIStats) {
+        drawAIStats(game.ai->getProfiler(), 10, 40);
     }
-    drawPlayer(game.player1);
-    drawPlayer(game.player2);
 
     if (game.paused) {
         float squareSize = 8.0f;
         drawText("PAUSED", config.WIDTH / 2 - 6 * 6 * squareSize / 2, config.HEIGHT / 2 - 50, squareSize, {255, 255, 255, 255});
-        std::string totalText = std::to_string(game.score1) + "-" + std::to_string(game.score2);
+        const std::string& totalText = label(SCORE, game.sim.score1, game.sim.score2);
         float totalTextWidth = totalText.size() * 6 * squareSize;
         drawText(totalText, config.WIDTH / 2 - totalTextWidth / 2, config.HEIGHT / 2, squareSize, {255, 255, 255, 255});
-        drawText("W:" + std::to_string(game.setScore1), 10, 10, squareSize, {0, 0, 255, 255});
-        std::string setScore2Text = "W:" + std::to_string(game.setScore2);
+        drawText(label(SETS1, game.sim.setScore1), 10, 10, squareSize, {0, 0, 255, 255});
+        const std::string& setScore2Text = label(SETS2, game.sim.setScore2);
         float setScore2Width = setScore2Text.size() * 6 * squareSize;
         drawText(setScore2Text, config.WIDTH - setScore2Width - 10, 10, squareSize, {255, 0, 0, 255});
     }
+    endFrame();
 }
 
-void RenderManager::renderGameOver(const Game& game, float orthoWidth, float orthoHeight) const {
-    float currentTimeSec = std::chrono::duration<float>(std::chrono::steady_clock::now().time_since_epoch()).count();
+void RenderManager::renderGameOver(const Game& game, float orthoWidth, float orthoHeight) {
+    float currentTimeSec = game.sim.time;
     int drawableWidth, drawableHeight;
     SDL_GL_GetDrawableSize(game.window, &drawableWidth, &drawableHeight);
     glViewport(0, 0, drawableWidth, drawableHeight);
@@ -169,33 +245,34 @@ void RenderManager::renderGameOver(const Game& game, float orthoWidth, float ort
     glOrtho(0, orthoWidth, orthoHeight, 0, -1, 1);
     glMatrixMode(GL_MODELVIEW);
     glLoadIdentity();
+    beginFrame();
 
-    for (const auto& explosion : game.explosions) {
+    for (const auto& explosion : game.sim.explosions) {
         drawExplosion(explosion, currentTimeSec);
     }
 
     float squareSize = 8.0f;
-    drawText("W:" + std::to_string(game.setScore1), 10, 10, squareSize, {0, 0, 255, 255});
-    std::string setScore2Text = "W:" + std::to_string(game.setScore2);
+    drawText(label(SETS1, game.sim.setScore1), 10, 10, squareSize, {0, 0, 255, 255});
+    const std::string& setScore2Text = label(SETS2, game.sim.setScore2);
     float setScore2Width = setScore2Text.size() * 6 * squareSize;
     drawText(setScore2Text, orthoWidth - setScore2Width - 10, 10, squareSize, {255, 0, 0, 255});
 
-    std::string winText;
+    std::string_view winText;
     SDL_Color winColor = {255, 255, 255, 255};
-    if (game.score1 >= config.WINNING_SCORE && game.score2 >= config.WINNING_SCORE) {
+    if (game.sim.score1 >= config.WINNING_SCORE && game.sim.score2 >= config.WINNING_SCORE) {
         winText = "OVERALL DRAW!";
-    } else if (game.score1 >= config.WINNING_SCORE) {
+    } else if (game.sim.score1 >= config.WINNING_SCORE) {
         winText = "PLAYER ONE WINS THE SET";
         winColor = {0, 0, 255, 255};
-    } else if (game.score2 >= config.WINNING_SCORE) {
+    } else if (game.sim.score2 >= config.WINNING_SCORE) {
         winText = "PLAYER TWO WINS THE SET";
         winColor = {255, 0, 0, 255};
-    } else if (!game.player1.alive && !game.player2.alive) {
+    } else if (!game.sim.player1.alive && !game.sim.player2.alive) {
         winText = "DRAW!";
-    } else if (!game.player1.alive) {
+    } else if (!game.sim.player1.alive) {
         winText = "P2 WIN";
         winColor = {255, 0, 0, 255};
-    } else if (!game.player2.alive) {
+    } else if (!game.sim.player2.alive) {
         winText = "P1 WIN";
         winColor = {0, 0, 255, 255};
     }
@@ -203,21 +280,22 @@ void RenderManager::renderGameOver(const Game& game, float orthoWidth, float ort
     float winTextY = orthoHeight / 2 - 60;
     drawText(winText, orthoWidth / 2 - winTextWidth / 2, winTextY, squareSize, winColor);
 
-    std::string totalText = std::to_string(game.score1) + "-" + std::to_string(game.score2);
+    const std::string& totalText = label(SCORE, game.sim.score1, game.sim.score2);
     float totalTextWidth = totalText.size() * 6 * squareSize;
     float totalTextY = winTextY + squareSize * 5 + 20;
     drawText(totalText, orthoWidth / 2 - totalTextWidth / 2, totalTextY, squareSize, {255, 255, 255, 255});
 
-    std::string roundText = "+" + std::to_string(game.roundScore1) + " - +" + std::to_string(game.roundScore2);
+    const std::string& roundText = label(ROUND, game.sim.roundScore1, game.sim.roundScore2);
     float roundTextWidth = roundText.size() * 6 * squareSize;
     float roundTextY = totalTextY + squareSize * 5 + 20;
     drawText(roundText, orthoWidth / 2 - roundTextWidth / 2, roundTextY, squareSize, {255, 255, 255, 255});
 
     int countdown = 5 - static_cast<int>(std::chrono::duration<float>(std::chrono::steady_clock::now() - game.gameOverTime).count());
     if (countdown >= 0) {
-        std::string countdownText = std::to_string(std::max(1, countdown));
+        const std::string& countdownText = label(COUNTDOWN, std::max(1, countdown));
         float countdownWidth = countdownText.size() * 6 * squareSize;
         float countdownY = roundTextY + squareSize * 5 + 20;
         drawText(countdownText, orthoWidth / 2 - countdownWidth / 2, countdownY, squareSize, {255, 255, 255, 255});
     }
+    endFrame();
 }
\ No newline at end of file
@@ -0,0 +1,356 @@
+#include "segment_index.h"
+#include <SDL2/SDL.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// Squared distance from p to segment ab
+static float distanceSqToSegment(const Vec2& p, const Vec2& a, const Vec2& b) {
+    Vec2 ab = b - a;
+    float lenSq = ab.dot(ab);
+    float t = lenSq > 0.0f ? std::clamp((p - a).dot(ab) / lenSq, 0.0f, 1.0f) : 0.0f;
+    Vec2 d = p - (a + ab * t);
+    return d.dot(d);
+}
+
+// Closest points between segments p1q1 and p2q2 (Ericson, Real-Time Collision Detection 5.1.9).
+// Returns the parameter along p1q1, 0 to 1.
+static float closestParamOnFirst(const Vec2& p1, const Vec2& q1, const Vec2& p2, const Vec2& q2) {
+    const float EPSILON = 1e-8f;
+    Vec2 d1 = q1 - p1;
+    Vec2 d2 = q2 - p2;
+    Vec2 r = p1 - p2;
+    float a = d1.dot(d1);
+    float e = d2.dot(d2);
+    float f = d2.dot(r);
+    if (a <= EPSILON) return 0.0f;
+    float c = d1.dot(r);
+    if (e <= EPSILON) return std::clamp(-c / a, 0.0f, 1.0f);
+    float b = d1.dot(d2);
+    float denom = a * e - b * b;
+    float s = denom != 0.0f ? std::clamp((b * f - c * e) / denom, 0.0f, 1.0f) : 0.0f;
+    float t = (b * s + f) / e;
+    if (t < 0.0f) {
+        s = std::clamp(-c / a, 0.0f, 1.0f);
+    } else if (t > 1.0f) {
+        s = std::clamp((b - c) / a, 0.0f, 1.0f);
+    }
+    return s;
+}
+
+SegmentIndex::SegmentIndex(const GameConfig& config)
+    : config(config),
+      cellSize(std::max(config.SEGMENT_INDEX_CELL_SIZE, 4.0f)),
+      halfWidth(config.TRAIL_SIZE / 2.0f),
+      cols(0),
+      rows(0),
+      cells(),
+      entries(),
+      freeEntries(),
+      unswept(),
+      queryStamp(),
+      queryCounter(0),
+      liveCount(0) {
+    resize(static_cast<float>(config.WIDTH), static_cast<float>(config.HEIGHT));
+}
+
+void SegmentIndex::resize(float orthoWidth, float orthoHeight) {
+    cols = std::max(1, static_cast<int>(std::ceil(orthoWidth / cellSize)));
+    rows = std::max(1, static_cast<int>(std::ceil(orthoHeight / cellSize)));
+    cells.assign(static_cast<size_t>(cols) * rows, std::vector<uint32_t>());
+    entries.clear();
+    freeEntries.clear();
+    unswept.clear();
+    queryStamp.clear();
+    liveCount = 0;
+    if (config.ENABLE_DEBUG) {
+        SDL_Log("Segment index resized: %dx%d cells, cellSize=%f", cols, rows, cellSize);
+    }
+}
+
+void SegmentIndex::clear() {
+    for (auto& cell : cells) cell.clear();
+    entries.clear();
+    freeEntries.clear();
+    unswept.clear();
+    queryStamp.clear();
+    liveCount = 0;
+}
+
+void SegmentIndex::copyFrom(const SegmentIndex& other) {
+    cellSize = other.cellSize;
+    halfWidth = other.halfWidth;
+    cols = other.cols;
+    rows = other.rows;
+    cells = other.cells;
+    entries = other.entries;
+    freeEntries = other.freeEntries;
+    unswept = other.unswept;
+    queryStamp = other.queryStamp;
+    queryCounter = other.queryCounter;
+    liveCount = other.liveCount;
+}
+
+SegmentIndex::CellRange SegmentIndex::cellRange(float minX, float minY, float maxX, float maxY) const {
+    CellRange r;
+    r.x0 = std::clamp(static_cast<int>(std::floor(minX / cellSize)), 0, cols - 1);
+    r.y0 = std::clamp(static_cast<int>(std::floor(minY / cellSize)), 0, rows - 1);
+    r.x1 = std::clamp(static_cast<int>(std::floor(maxX / cellSize)), 0, cols - 1);
+    r.y1 = std::clamp(static_cast<int>(std::floor(maxY / cellSize)), 0, rows - 1);
+    return r;
+}
+
+// Does segment ab, grown by reach, overlap the cell? (slab clip against the grown cell)
+bool SegmentIndex::strokeTouchesCell(const Vec2& a, const Vec2& b, float reach, int cx, int cy) const {
+    float minX = cx * cellSize - reach, maxX = (cx + 1) * cellSize + reach;
+    float minY = cy * cellSize - reach, maxY = (cy + 1) * cellSize + reach;
+    float t0 = 0.0f, t1 = 1.0f;
+    Vec2 d = b - a;
+    const float start[2] = {a.x, a.y};
+    const float delta[2] = {d.x, d.y};
+    const float lo[2] = {minX, minY};
+    const float hi[2] = {maxX, maxY};
+    for (int axis = 0; axis < 2; ++axis) {
+        if (std::abs(delta[axis]) < 1e-8f) {
+            if (start[axis] < lo[axis] || start[axis] > hi[axis]) return false;
+            continue;
+        }
+        float ta = (lo[axis] - start[axis]) / delta[axis];
+        float tb = (hi[axis] - start[axis]) / delta[axis];
+        if (ta > tb) std::swap(ta, tb);
+        t0 = std::max(t0, ta);
+        t1 = std::min(t1, tb);
+        if (t0 > t1) return false;
+    }
+    return true;
+}
+
+void SegmentIndex::addToCells(uint32_t id, const Vec2& a, const Vec2& b) {
+    CellRange r = cellRange(std::min(a.x, b.x) - halfWidth, std::min(a.y, b.y) - halfWidth,
+                            std::max(a.x, b.x) + halfWidth, std::max(a.y, b.y) + halfWidth);
+    for (int cy = r.y0; cy <= r.y1; ++cy) {
+        for (int cx = r.x0; cx <= r.x1; ++cx) {
+            if (!strokeTouchesCell(a, b, halfWidth, cx, cy)) continue;
+            std::vector<uint32_t>& cell = cells[static_cast<size_t>(cy) * cols + cx];
+            if (std::find(cell.begin(), cell.end(), id) == cell.end()) {
+                cell.push_back(id);
+            }
+        }
+    }
+}
+
+// The cells addToCells listed it in. A stretched entry was listed piece by piece along the same
+// line, so the whole segment covers them; the slack is for rounding where the pieces join.
+void SegmentIndex::removeFromCells(uint32_t id, const Vec2& a, const Vec2& b) {
+    float reach = halfWidth + ROUNDING_SLACK;
+    CellRange r = cellRange(std::min(a.x, b.x) - reach, std::min(a.y, b.y) - reach,
+                            std::max(a.x, b.x) + reach, std::max(a.y, b.y) + reach);
+    for (int cy = r.y0; cy <= r.y1; ++cy) {
+        for (int cx = r.x0; cx <= r.x1; ++cx) {
+            if (!strokeTouchesCell(a, b, reach, cx, cy)) continue;
+            std::vector<uint32_t>& cell = cells[static_cast<size_t>(cy) * cols + cx];
+            auto it = std::find(cell.begin(), cell.end(), id);
+            if (it != cell.end()) {
+                *it = cell.back();
+                cell.pop_back();
+            }
+        }
+    }
+}
+
+uint32_t SegmentIndex::insert(const Vec2& a, const Vec2& b, int owner, uint32_t slot, uint32_t tick) {
+    uint32_t id;
+    if (!freeEntries.empty()) {
+        id = freeEntries.back();
+        freeEntries.pop_back();
+    } else {
+        id = static_cast<uint32_t>(entries.size());
+        entries.emplace_back();
+        queryStamp.push_back(0);
+    }
+    entries[id] = Entry{a, b, tick, slot, static_cast<uint8_t>(owner), true, false};
+    addToCells(id, a, b);
+    markUnswept(id);
+    ++liveCount;
+    return id;
+}
+
+void SegmentIndex::stretch(uint32_t id, const Vec2& newEnd, uint32_t tick) {
+    Entry& e = entries[id];
+    addToCells(id, e.b, newEnd);
+    e.b = newEnd;
+    e.tick = tick;
+    markUnswept(id);
+}
+
+void SegmentIndex::markUnswept(uint32_t id) {
+    if (entries[id].unswept) return;
+    entries[id].unswept = true;
+    unswept.push_back(id);
+}
+
+void SegmentIndex::reshape(uint32_t id, const Vec2& a, const Vec2& b) {
+    Entry& e = entries[id];
+    removeFromCells(id, e.a, e.b);
+    e.a = a;
+    e.b = b;
+    addToCells(id, a, b);
+}
+
+void SegmentIndex::remove(uint32_t id) {
+    Entry& e = entries[id];
+    if (!e.live) return;
+    removeFromCells(id, e.a, e.b);
+    e.live = false;
+    freeEntries.push_back(id);
+    --liveCount;
+}
+
+void SegmentIndex::removeOwner(int owner) {
+    for (uint32_t id = 0; id < entries.size(); ++id) {
+        if (entries[id].live && entries[id].owner == owner) {
+            remove(id);
+        }
+    }
+}
+
+// Const, so no query stamps: cells list each id once, and duplicates across cells are sorted out
+void SegmentIndex::queryBox(float minX, float minY, float maxX, float maxY, std::vector<uint32_t>& out) const {
+    out.clear();
+    CellRange r = cellRange(minX, minY, maxX, maxY);
+    for (int cy = r.y0; cy <= r.y1; ++cy) {
+        for (int cx = r.x0; cx <= r.x1; ++cx) {
+            for (uint32_t id : cells[static_cast<size_t>(cy) * cols + cx]) {
+                if (entries[id].live) out.push_back(id);
+            }
+        }
+    }
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+}
+
+void SegmentIndex::querySwept(const Vec2& prevCenter, const Vec2& center, float radius, bool swept,
+                              std::vector<uint32_t>& out) {
+    out.clear();
+    if (++queryCounter == 0) {
+        std::fill(queryStamp.begin(), queryStamp.end(), 0);
+        queryCounter = 1;
+    }
+    float reach = radius + halfWidth;
+    auto consider = [&](uint32_t id) {
+        if (queryStamp[id] == queryCounter) return;
+        queryStamp[id] = queryCounter;
+        const Entry& e = entries[id];
+        if (e.live && distanceSqToSegment(center, e.a, e.b) <= reach * reach) {
+            out.push_back(id);
+        }
+    };
+
+    // Trails are cut along their centre line, so a cell whose corners were all inside the
+    // circle last time holds no old centre line. A unit of slack covers cut points on the edge.
+    float coveredSq = std::max(0.0f, radius - 1.0f);
+    coveredSq *= coveredSq;
+    auto inPrevious = [&](float x, float y) {
+        Vec2 d = Vec2(x, y) - prevCenter;
+        return d.dot(d) <= coveredSq;
+    };
+
+    CellRange r = cellRange(center.x - radius, center.y - radius, center.x + radius, center.y + radius);
+    for (int cy = r.y0; cy <= r.y1; ++cy) {
+        for (int cx = r.x0; cx <= r.x1; ++cx) {
+            if (swept) {
+                float x0 = cx * cellSize, y0 = cy * cellSize;
+                float x1 = x0 + cellSize, y1 = y0 + cellSize;
+                if (inPrevious(x0, y0) && inPrevious(x1, y0) && inPrevious(x0, y1) && inPrevious(x1, y1)) continue;
+            }
+            for (uint32_t id : cells[static_cast<size_t>(cy) * cols + cx]) {
+                consider(id);
+            }
+        }
+    }
+    if (swept) {
+        for (uint32_t id : unswept) {
+            consider(id);
+        }
+    }
+}
+
+void SegmentIndex::finishSweep() {
+    for (uint32_t id : unswept) {
+        entries[id].unswept = false;
+    }
+    unswept.clear();
+}
+
+int SegmentIndex::ownerAt(const Vec2& pos, uint32_t solidMask, int self, uint32_t selfSinceTick) const {
+    if (pos.x < 0.0f || pos.y < 0.0f) return -1;
+    int cx = static_cast<int>(pos.x / cellSize);
+    int cy = static_cast<int>(pos.y / cellSize);
+    if (cx >= cols || cy >= rows) return -1;
+
+    for (uint32_t id : cells[static_cast<size_t>(cy) * cols + cx]) {
+        const Entry& e = entries[id];
+        if (!(solidMask & (1u << e.owner))) continue;
+        if (e.owner == self && e.tick >= selfSinceTick) continue;
+        if (distanceSqToSegment(pos, e.a, e.b) <= halfWidth * halfWidth) {
+            return e.owner;
+        }
+    }
+    return -1;
+}
+
+// Walks the cells along the ray (Amanatides and Woo) and stops once the nearest hit so far
+// is closer than the cell being left
+SegmentIndex::RayHit SegmentIndex::raycast(const Vec2& start, const Vec2& dir, float maxDistance, uint32_t solidMask) const {
+    RayHit hit{maxDistance, -1};
+    if (maxDistance <= 0.0f) return hit;
+
+    const float INF = std::numeric_limits<float>::max();
+    Vec2 end = start + dir * maxDistance;
+    int cx = std::clamp(static_cast<int>(std::floor(start.x / cellSize)), 0, cols - 1);
+    int cy = std::clamp(static_cast<int>(std::floor(start.y / cellSize)), 0, rows - 1);
+    int stepX = dir.x > 0 ? 1 : -1;
+    int stepY = dir.y > 0 ? 1 : -1;
+    float tMaxX = dir.x != 0.0f ? ((cx + (dir.x > 0 ? 1 : 0)) * cellSize - start.x) / dir.x : INF;
+    float tMaxY = dir.y != 0.0f ? ((cy + (dir.y > 0 ? 1 : 0)) * cellSize - start.y) / dir.y : INF;
+    float tDeltaX = dir.x != 0.0f ? cellSize / std::abs(dir.x) : INF;
+    float tDeltaY = dir.y != 0.0f ? cellSize / std::abs(dir.y) : INF;
+    float widthSq = halfWidth * halfWidth;
+
+    while (true) {
+        for (uint32_t id : cells[static_cast<size_t>(cy) * cols + cx]) {
+            const Entry& e = entries[id];
+            if (!(solidMask & (1u << e.owner))) continue;
+
+            // Closest approach first, then walk back to where the ray enters the stroke
+            float s = closestParamOnFirst(start, end, e.a, e.b);
+            if (distanceSqToSegment(start + dir * (s * maxDistance), e.a, e.b) > widthSq) continue;
+            float lo = 0.0f, hi = s * maxDistance;
+            if (distanceSqToSegment(start, e.a, e.b) > widthSq) {
+                for (int i = 0; i < 14; ++i) {
+                    float mid = 0.5f * (lo + hi);
+                    if (distanceSqToSegment(start + dir * mid, e.a, e.b) <= widthSq) hi = mid;
+                    else lo = mid;
+                }
+            } else {
+                hi = 0.0f;
+            }
+            if (hi < hit.distance) {
+                hit.distance = hi;
+                hit.owner = e.owner;
+            }
+        }
+
+        float tExit = std::min(tMaxX, tMaxY);
+        if ((hit.owner >= 0 && hit.distance <= tExit) || tExit > maxDistance) break;
+        if (tMaxX < tMaxY) {
+            cx += stepX;
+            tMaxX += tDeltaX;
+        } else {
+            cy += stepY;
+            tMaxY += tDeltaY;
+        }
+        if (cx < 0 || cy < 0 || cx >= cols || cy >= rows) break;
+    }
+    return hit;
+}
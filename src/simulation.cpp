@@ -0,0 +1,524 @@
+#include "simulation.h"
+#include <SDL2/SDL.h>
+#include <algorithm>
+#include <utility>
+
+Simulation::Simulation(const GameConfig& config, uint32_t seed)
+    : config(config),
+      collectibleManager(config),
+      circleManager(config),
+      explosionManager(config),
+      playerManager(config),
+      collisionGrid(config),
+      segmentIndex(config),
+      player1(),
+      player2(),
+      circles(),
+      collectible(),
+      explosions(),
+      flashes(),
+      rng(seed),
+      aiControlled{false, false},
+      score1{0},
+      score2{0},
+      roundScore1{0},
+      roundScore2{0},
+      setScore1{0},
+      setScore2{0},
+      time{0.0f},
+      tick{0},
+      roundStartTick{0},
+      tickDt{0.0f},
+      lastCircleSpawn{0.0f},
+      deathTime{0.0f},
+      orthoWidth{static_cast<float>(config.WIDTH)},
+      orthoHeight{static_cast<float>(config.HEIGHT)},
+      winningScore{0.0f},
+      greenSquarePoints{0.0f},
+      deathPoints{0.0f},
+      roundOver{false},
+      setWinner{0},
+      events{0},
+      trailChanges(),
+      trailChangeBase{0},
+      collectibleCollectedThisFrame{false},
+      pendingCollectibleRespawn{false} {}
+
+// Advance the world by one tick
+void Simulation::step(const InputFrame& input, float dt, const PixelSnapshot& framebuffer,
+                      int drawableWidth, int drawableHeight) {
+    tickDt = dt;
+    time += dt;
+    ++tick;
+    events = 0;
+    setWinner = 0;
+
+    player1.prevPos = player1.pos;
+    player2.prevPos = player2.pos;
+    // Circles move twice a tick, with the players and again after them
+    for (Circle& circle : circles) {
+        circle.prevPos = circle.pos;
+    }
+
+    // Reset per-frame flags
+    player1.collectedGreenThisFrame = false;
+    player2.collectedGreenThisFrame = false;
+    player1.scoredDeathThisFrame = false;
+    player2.scoredDeathThisFrame = false;
+    collectibleCollectedThisFrame = false;
+
+    if (config.COLLISION_MODE != 2) {
+        collisionGrid.updateOverlay(circles, collectible, player1, player2);
+    }
+    playerManager.updatePlayers(input, *this, dt, framebuffer, drawableWidth, drawableHeight);
+    update();
+}
+
+void Simulation::advanceClock(float dt) {
+    time += dt;
+    explosionManager.updateExplosions(explosions, dt, time, {255, 0, 255, 255});
+    explosionManager.updateFlashes(flashes, dt, time, {255, 0, 255, 255});
+}
+
+void Simulation::update() {
+    float dt = tickDt;
+
+    // Update AI noCollisionTimer
+    for (Player* player : {&player1, &player2}) {
+        if (!aiControlled[playerIndex(player)] || player->noCollisionTimer <= 0) continue;
+        player->noCollisionTimer -= dt;
+        if (player->noCollisionTimer <= 0) {
+            player->noCollisionTimer = 0;
+            player->isInvincible = false;
+            player->canUseNoCollision = true;
+            player->endFlash = std::make_unique<Flash>(
+                explosionManager.createFlash(player->pos, rng, dt, time, {255, 0, 255, 255}));
+            events |= SIM_EVENT_LASER_ZAP;
+            if (config.ENABLE_DEBUG) {
+                SDL_Log("AI no-collision ended at time %f, canUseNoCollision=%d",
+                        time, player->canUseNoCollision);
+            }
+        }
+    }
+
+    // Handle deferred collectible respawn
+    if (pendingCollectibleRespawn) {
+        collectible = collectibleManager.spawnCollectible(rng, *this);
+        collectible.active = true;
+        pendingCollectibleRespawn = false;
+        if (config.ENABLE_DEBUG) {
+            SDL_Log("Deferred collectible respawned at pos=(%f, %f), active=%d",
+                    collectible.pos.x, collectible.pos.y, collectible.active);
+        }
+    }
+
+    // Update circles (handled by CircleManager)
+    circleManager.updateCircles(dt, circles, rng, time, lastCircleSpawn, *this);
+
+    // Clear trails under circles
+    circleManager.clearTrails(circles, *this);
+    explosionManager.updateExplosions(explosions, dt, time, {255, 0, 255, 255});
+
+    // Crashes take effect once both players have moved
+    for (Player* player : {&player1, &player2}) {
+        if (player->willDie && player->alive) {
+            player->alive = false;
+        }
+    }
+
+    if (score1 >= config.WINNING_SCORE) {
+        setScore1 += 1;
+        setWinner = 1;
+    } else if (score2 >= config.WINNING_SCORE) {
+        setScore2 += 1;
+        setWinner = 2;
+    }
+    if (setWinner) {
+        roundOver = true;
+        events |= SIM_EVENT_WINNER;
+        score1 = score2 = 0;
+    } else if (!player1.alive || !player2.alive) {
+        roundOver = true;
+    }
+}
+
+// Check collision for a player at the next position
+void Simulation::checkCollision(Player* player, Vec2 nextPos, const PixelSnapshot& framebuffer, int drawableWidth, int drawableHeight) {
+    if (!player->alive || player->willDie) return;
+
+    // Geometric check for green square collection
+    if (collectible.active && !collectibleCollectedThisFrame) {
+        // Normalize coordinates to ortho space
+        Vec2 normalizedPlayerPos = nextPos;
+        Vec2 normalizedCollectiblePos = collectible.pos;
+        float halfSize = collectible.size / 2.0f;
+
+        bool withinX = normalizedPlayerPos.x >= normalizedCollectiblePos.x - halfSize &&
+                       normalizedPlayerPos.x <= normalizedCollectiblePos.x + halfSize;
+        bool withinY = normalizedPlayerPos.y >= normalizedCollectiblePos.y - halfSize &&
+                       normalizedPlayerPos.y <= normalizedCollectiblePos.y + halfSize;
+
+        if (withinX && withinY) {
+            handleGreenSquareCollection(player);
+        } else if (config.ENABLE_DEBUG) {
+            SDL_Log("Green square check failed for player %s: playerPos=(%f, %f), collectible=(%f, %f, size=%f), withinX=%d, withinY=%d, active=%d, drawable=(%d, %d)",
+                    player == &player1 ? "1" : "2", normalizedPlayerPos.x, normalizedPlayerPos.y,
+                    normalizedCollectiblePos.x, normalizedCollectiblePos.y, collectible.size,
+                    withinX, withinY, collectible.active, drawableWidth, drawableHeight);
+        }
+    }
+
+    // Collision check at the head - black green magenta safe colors
+    Vec2 checkPos = nextPos + player->direction * (config.PLAYER_SIZE / 2.0f);
+    checkPos.x = std::max(10.0f, std::min(checkPos.x, orthoWidth - 10.0f));
+    checkPos.y = std::max(10.0f, std::min(checkPos.y, orthoHeight - 10.0f));
+
+    CellType cell;
+    if (config.COLLISION_MODE == 1) {
+        // Framebuffer-based
+        float x_read = (checkPos.x / orthoWidth) * drawableWidth;
+        float y_read = (1 - checkPos.y / orthoHeight) * drawableHeight;
+
+        x_read = std::max(0.0f, std::min(x_read, static_cast<float>(drawableWidth - 1)));
+        y_read = std::max(0.0f, std::min(y_read, static_cast<float>(drawableHeight - 1)));
+
+        int index = (static_cast<int>(y_read) * drawableWidth + static_cast<int>(x_read)) * 3;
+        cell = CollisionGrid::classifyPixel(framebuffer[index], framebuffer[index + 1], framebuffer[index + 2]);
+
+        if (config.ENABLE_DEBUG) {
+            SDL_Log("Collision check at gamePos=(%f, %f), screenPos=(%f, %f), cell=%s, collectible.active=%d",
+                    checkPos.x, checkPos.y, x_read, y_read, CollisionGrid::colorName(cell), collectible.active);
+        }
+    } else {
+        // Collision grid or trail segments
+        cell = sample(checkPos, playerIndex(player));
+
+        if (config.ENABLE_DEBUG) {
+            SDL_Log("Collision check at gamePos=(%f, %f), cell=%s, collectible.active=%d",
+                    checkPos.x, checkPos.y, CollisionGrid::colorName(cell), collectible.active);
+        }
+    }
+
+    if (player->noCollisionTimer > 0) return;
+
+    if (CollisionGrid::isDeadly(cell)) {
+        player->willDie = true;
+        explosions.emplace_back(explosionManager.createExplosion(nextPos, rng, tickDt, time, {255, 0, 255, 255}));
+        events |= SIM_EVENT_EXPLOSION;
+        deathTime = time;
+        if (config.ENABLE_DEBUG) {
+            SDL_Log("Player %s died at (%f, %f) due to %s, hasMoved=%d",
+                    player == &player1 ? "1" : "2", nextPos.x, nextPos.y, CollisionGrid::colorName(cell), player->hasMoved);
+        }
+    }
+}
+
+// Handle collection of green square
+void Simulation::handleGreenSquareCollection(Player* player) {
+    if (!player->collectedGreenThisFrame && !collectibleCollectedThisFrame && collectible.active) {
+        player->collectedGreenThisFrame = true;
+        collectibleCollectedThisFrame = true;
+        collectible.active = false; // Disable collectible until respawn
+        pendingCollectibleRespawn = true; // Defer respawn to update()
+        int points = 1; // Green square always awards 1 point
+        if (player == &player1) {
+            score1 += points;
+            roundScore1 += points;
+        } else {
+            score2 += points;
+            roundScore2 += points;
+        }
+        events |= SIM_EVENT_BOOP;
+        if (config.ENABLE_DEBUG) {
+            SDL_Log("Green square collected by player %s at pos=(%f, %f), time=%f, score1=%d, score2=%d, collectible.active=%d",
+                    player == &player1 ? "1" : "2", player->pos.x, player->pos.y, time, score1, score2, collectible.active);
+        }
+    } else if (config.ENABLE_DEBUG) {
+        SDL_Log("Green square collection skipped for player %s at time=%f, already collected=%d, collectible.active=%d",
+                player == &player1 ? "1" : "2", time, collectibleCollectedThisFrame, collectible.active);
+    }
+}
+
+// Handle player death
+void Simulation::handlePlayerDeath(Player* player) {
+    if (!player->scoredDeathThisFrame) {
+        player->scoredDeathThisFrame = true;
+        bool simultaneousDeath = (player1.willDie || !player1.alive) && (player2.willDie || !player2.alive);
+        if (!simultaneousDeath) {
+            if (player == &player1 && player2.alive) {
+                score2 += static_cast<int>(deathPoints);
+                roundScore2 += static_cast<int>(deathPoints);
+                if (config.ENABLE_DEBUG) {
+                    SDL_Log("Player 1 died, score2 += %d, total score2=%d, player1.alive=%d, player2.alive=%d",
+                            static_cast<int>(deathPoints), score2, player1.alive, player2.alive);
+                }
+            } else if (player == &player2 && player1.alive) {
+                score1 += static_cast<int>(deathPoints);
+                roundScore1 += static_cast<int>(deathPoints);
+                if (config.ENABLE_DEBUG) {
+                    SDL_Log("Player 2 died, score1 += %d, total score1=%d, player1.alive=%d, player2.alive=%d",
+                            static_cast<int>(deathPoints), score1, player1.alive, player2.alive);
+                }
+            }
+        } else if (config.ENABLE_DEBUG) {
+            SDL_Log("Simultaneous death detected, no points awarded, player1.alive=%d, player2.alive=%d",
+                    player1.alive, player2.alive);
+        }
+    } else if (config.ENABLE_DEBUG) {
+        SDL_Log("Death scoring skipped for player %s at time=%f, already scored this frame",
+                player == &player1 ? "1" : "2", time);
+    }
+}
+
+// Start a new round; scores carry over unless the set was won
+void Simulation::reset(bool clearScores) {
+    // Keep the trails and clear them, so their edit numbers go on and readers know to start over
+    Trail trail1 = std::move(player1.trail);
+    Trail trail2 = std::move(player2.trail);
+    trail1.clear();
+    trail2.clear();
+    player1 = Player{
+        Vec2(200, orthoHeight / 2),      // pos
+        Vec2(1, 0),                      // direction
+        SDL_Color{0, 0, 255, 255},      // color
+        std::move(trail1),               // trail
+        true,                            // alive
+        false,                           // willDie
+        false,                           // hasMoved
+        Vec2(0, 0),                      // deathPos
+        0.0f,                            // noCollisionTimer
+        true,                            // canUseNoCollision
+        false,                           // isInvincible
+        false,                           // collectedGreenThisFrame
+        false,                           // scoredDeathThisFrame
+        0.0f,                            // spawnInvincibilityTimer
+        nullptr,                         // endFlash
+        false,                           // hitOpponentHead
+        Vec2(200, orthoHeight / 2)       // prevPos
+    };
+    player2 = Player{
+        Vec2(orthoWidth - 200, orthoHeight / 2), // pos
+        Vec2(-1, 0),                      // direction
+        SDL_Color{255, 0, 0, 255},       // color
+        std::move(trail2),               // trail
+        true,                            // alive
+        false,                           // willDie
+        false,                           // hasMoved
+        Vec2(0, 0),                      // deathPos
+        0.0f,                            // noCollisionTimer
+        true,                            // canUseNoCollision
+        false,                           // isInvincible
+        false,                           // collectedGreenThisFrame
+        false,                           // scoredDeathThisFrame
+        0.0f,                            // spawnInvincibilityTimer
+        nullptr,                         // endFlash
+        false,                           // hitOpponentHead
+        Vec2(orthoWidth - 200, orthoHeight / 2) // prevPos
+    };
+
+    collisionGrid.clear();
+    segmentIndex.clear();
+    noteTrailChange(0.0f, 0.0f, orthoWidth, orthoHeight);
+    circles.clear();
+    circleManager.spawnInitialCircle(rng, circles, *this);
+    collectible = collectibleManager.spawnCollectible(rng, *this);
+    collectible.active = true; // Ensure collectible is active
+    explosions.clear();
+    flashes.clear();
+
+    roundScore1 = roundScore2 = 0;
+    if (clearScores) {
+        score1 = score2 = 0;
+    }
+    lastCircleSpawn = time;
+    deathTime = 0.0f;
+    roundStartTick = tick;
+    roundOver = false;
+    setWinner = 0;
+    collectibleCollectedThisFrame = false;
+    pendingCollectibleRespawn = false;
+
+    if (config.ENABLE_DEBUG) {
+        SDL_Log("Simulation reset, new collectible pos=(%f, %f), size=%f, active=%d",
+                collectible.pos.x, collectible.pos.y, collectible.size, collectible.active);
+    }
+}
+
+// Respawn circles to match current ortho dimensions
+void Simulation::respawnCircles() {
+    circles.clear();
+    circleManager.spawnInitialCircle(rng, circles, *this);
+}
+
+// Activate no-collision mode for a player
+void Simulation::activateNoCollision(Player* player) {
+    if (player->canUseNoCollision && player->noCollisionTimer <= 0 && player->alive) {
+        player->noCollisionTimer = 2.0f; // 2 seconds
+        player->canUseNoCollision = false; // you used it
+        player->isInvincible = true;
+        flashes.emplace_back(explosionManager.createFlash(player->pos, rng, tickDt, time, {255, 0, 255, 255}));
+        events |= SIM_EVENT_LASER_ZAP;
+        if (config.ENABLE_DEBUG) {
+            SDL_Log("Player flash activated at time %f, noCollisionTimer=%f", time, player->noCollisionTimer);
+        }
+    }
+}
+
+// Grow a player's trail to its current position and mark it in the segment index and collision grid
+void Simulation::extendTrail(Player* player) {
+    int owner = playerIndex(player);
+    Vec2 from = player->trail.hasTip() ? player->trail.tip() : player->pos;
+    Trail::Growth growth = player->trail.extend(player->pos);
+    if (growth == Trail::Growth::Appended) {
+        size_t slot = static_cast<size_t>(player->trail.tipSlot());
+        uint32_t id = segmentIndex.insert(from, player->pos, owner, static_cast<uint32_t>(slot), static_cast<uint32_t>(tick));
+        player->trail.setIndexId(slot, id);
+    } else if (growth == Trail::Growth::Stretched) {
+        const TrailSegment& segment = player->trail[static_cast<size_t>(player->trail.tipSlot())];
+        segmentIndex.stretch(segment.indexId, segment.b, static_cast<uint32_t>(tick));
+    }
+    if (config.COLLISION_MODE != 2) {
+        collisionGrid.addTrailSegment(from, player->pos, owner);
+    }
+    float reach = config.TRAIL_SIZE;
+    noteTrailChange(std::min(from.x, player->pos.x) - reach, std::min(from.y, player->pos.y) - reach,
+                    std::max(from.x, player->pos.x) + reach, std::max(from.y, player->pos.y) + reach);
+}
+
+void Simulation::clearTrail(Player* player) {
+    int owner = playerIndex(player);
+    player->trail.clear();
+    segmentIndex.removeOwner(owner);
+    if (config.COLLISION_MODE != 2) {
+        collisionGrid.clearOwner(owner);
+    }
+    noteTrailChange(0.0f, 0.0f, orthoWidth, orthoHeight);
+}
+
+// Nobody may be reading (no AI), so a long list folds into one box over the whole board
+void Simulation::noteTrailChange(float minX, float minY, float maxX, float maxY) {
+    const size_t MAX_CHANGES = 4096;
+    if (trailChanges.size() >= MAX_CHANGES) {
+        trailChangeBase += trailChanges.size();
+        trailChanges.clear();
+        minX = minY = 0.0f;
+        maxX = orthoWidth;
+        maxY = orthoHeight;
+    }
+    trailChanges.push_back(ChangedArea{minX, minY, maxX, maxY});
+}
+
+void Simulation::dropTrailChanges(uint64_t upTo) {
+    if (upTo <= trailChangeBase) return;
+    size_t count = static_cast<size_t>(std::min<uint64_t>(upTo - trailChangeBase, trailChanges.size()));
+    trailChanges.erase(trailChanges.begin(), trailChanges.begin() + count);
+    trailChangeBase += count;
+}
+
+uint32_t Simulation::solidTrailMask() const {
+    return (player1.isInvincible ? 0u : 1u) | (player2.isInvincible ? 0u : 2u);
+}
+
+// Only the trails, for looking ahead while the heads, circles and collectible move
+bool Simulation::solidTrailAt(const Vec2& pos, int self) const {
+    if (config.COLLISION_MODE != 2) return collisionGrid.solidTrailAt(pos);
+    uint32_t recent = tick > 1 ? static_cast<uint32_t>(tick - 1) : 0;
+    return segmentIndex.ownerAt(pos, solidTrailMask(), self, recent) >= 0;
+}
+
+// Same answer the collision grid gives. With COLLISION_MODE=2 it is worked out from the objects
+// in the order RenderManager::renderGame draws them: heads over circles over the collectible over trails.
+CellType Simulation::sample(const Vec2& pos, int self) const {
+    if (config.COLLISION_MODE != 2) return collisionGrid.sample(pos, self);
+    if (pos.x < 0.0f || pos.y < 0.0f || pos.x >= orthoWidth || pos.y >= orthoHeight) return CellType::Wall;
+
+    float half = config.PLAYER_SIZE / 2.0f;
+    auto onHead = [&](const Player& player) {
+        return player.alive && std::abs(pos.x - player.pos.x) <= half && std::abs(pos.y - player.pos.y) <= half;
+    };
+    if (self != 1 && onHead(player2)) return CellType::HeadP2;
+    if (self != 0 && onHead(player1)) return CellType::HeadP1;
+    for (auto it = circles.rbegin(); it != circles.rend(); ++it) {
+        if ((pos - it->pos).dot(pos - it->pos) <= it->radius * it->radius) {
+            return it->isYellow ? CellType::CircleDanger : CellType::CircleSafe;
+        }
+    }
+    if (collectible.active && std::abs(pos.x - collectible.pos.x) <= collectible.size / 2.0f &&
+        std::abs(pos.y - collectible.pos.y) <= collectible.size / 2.0f) {
+        return CellType::Collectible;
+    }
+    // A player's own segments from the last two ticks are under its head, not in front of it
+    uint32_t recent = tick > 1 ? static_cast<uint32_t>(tick - 1) : 0;
+    int owner = segmentIndex.ownerAt(pos, solidTrailMask(), self, recent);
+    if (owner == 0) return CellType::TrailP1;
+    if (owner == 1) return CellType::TrailP2;
+    return CellType::Empty;
+}
+
+// FNV-1a over the state that decides a round, for comparing runs
+uint64_t Simulation::checksum() const {
+    uint64_t hash = 1469598103934665603ull;
+    auto mix = [&hash](const void* data, size_t size) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+    };
+    auto mixFloat = [&mix](float value) { mix(&value, sizeof(value)); };
+
+    for (const Player* player : {&player1, &player2}) {
+        mixFloat(player->pos.x);
+        mixFloat(player->pos.y);
+        mixFloat(player->direction.x);
+        mixFloat(player->direction.y);
+        uint32_t trailSize = static_cast<uint32_t>(player->trail.size());
+        mix(&trailSize, sizeof(trailSize));
+        uint8_t flags = (player->alive ? 1 : 0) | (player->willDie ? 2 : 0) | (player->isInvincible ? 4 : 0);
+        mix(&flags, sizeof(flags));
+    }
+    for (const Circle& circle : circles) {
+        mixFloat(circle.pos.x);
+        mixFloat(circle.pos.y);
+    }
+    mixFloat(collectible.pos.x);
+    mixFloat(collectible.pos.y);
+    int scores[4] = {score1, score2, setScore1, setScore2};
+    mix(scores, sizeof(scores));
+    mix(&tick, sizeof(tick));
+    return hash;
+}
+
+void Simulation::copyWorldFrom(const Simulation& other) {
+    for (int i = 0; i < 2; ++i) {
+        const Player& from = i == 0 ? other.player1 : other.player2;
+        Player& to = i == 0 ? player1 : player2;
+        to.pos = from.pos;
+        to.prevPos = from.prevPos;
+        to.direction = from.direction;
+        to.color = from.color;
+        to.alive = from.alive;
+        to.willDie = from.willDie;
+        to.hasMoved = from.hasMoved;
+        to.noCollisionTimer = from.noCollisionTimer;
+        to.canUseNoCollision = from.canUseNoCollision;
+        to.isInvincible = from.isInvincible;
+        to.spawnInvincibilityTimer = from.spawnInvincibilityTimer;
+        aiControlled[i] = other.aiControlled[i];
+    }
+    circles = other.circles;
+    collectible = other.collectible;
+    time = other.time;
+    tick = other.tick;
+    roundStartTick = other.roundStartTick;
+    tickDt = other.tickDt;
+    orthoWidth = other.orthoWidth;
+    orthoHeight = other.orthoHeight;
+    trailChanges = other.trailChanges;
+    trailChangeBase = other.trailChangeBase;
+    if (config.COLLISION_MODE == 0) {
+        collisionGrid.copyChangedFrom(other.collisionGrid);
+    } else if (config.COLLISION_MODE == 2) {
+        segmentIndex.copyFrom(other.segmentIndex);
+    }
+}
@@ -0,0 +1,292 @@
+#include "territory.h"
+#include "simulation.h"
+#include <SDL2/SDL.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+Territory::Territory(const GameConfig& config)
+    : config(config),
+      factor(0),
+      cellSize(0.0f),
+      cols(0),
+      rows(0),
+      words(0),
+      stride(0),
+      trailFree(),
+      folded(false),
+      foldedVersion(0),
+      foldedSolid(0),
+      foldedWidth(0.0f),
+      foldedHeight(0.0f),
+      free(),
+      seen(),
+      front(),
+      next(),
+      owned(),
+      narrow(),
+      last{{0, 0}, 0, {0, 0}, 0.0f} {}
+
+namespace {
+// Set a bit in row for each cell in [x0, x1] whose K bytes of band hold no solid trail.
+// band has at least 8 readable bytes past the last cell.
+template <int K>
+void foldBand(const uint8_t* band, int x0, int x1, uint8_t solid, uint64_t* row) {
+    uint64_t mask = solid * 0x0101010101010101ull;
+    if (K < 8) mask &= (uint64_t(1) << (8 * K)) - 1;
+    for (int x = x0; x <= x1; ++x) {
+        uint64_t bytes;
+        std::memcpy(&bytes, band + x * K, sizeof(bytes));
+        row[x >> 6] |= uint64_t((bytes & mask) == 0) << (x & 63);
+    }
+}
+
+void foldBandAny(const uint8_t* band, int factor, int x0, int x1, uint8_t solid, uint64_t* row) {
+    for (int x = x0; x <= x1; ++x) {
+        uint8_t any = 0;
+        for (int i = x * factor; i < (x + 1) * factor; ++i) {
+            any |= band[i];
+        }
+        row[x >> 6] |= uint64_t((any & solid) == 0) << (x & 63);
+    }
+}
+
+// One BFS step over words [begin, end): both fronts grow a cell each way into open cells not
+// reached yet, cells both reach are contested and taken by neither. Nonzero if either grew.
+// The buffers never overlap, which lets the compiler do several words at once.
+uint64_t stepWords(const uint64_t* __restrict f0, const uint64_t* __restrict f1, uint64_t* __restrict n0,
+                   uint64_t* __restrict n1, uint64_t* __restrict o0, uint64_t* __restrict o1,
+                   const uint64_t* __restrict open, uint64_t* __restrict reached, size_t begin, size_t end,
+                   size_t stride) {
+    uint64_t any = 0;
+    for (size_t i = begin; i < end; ++i) {
+        uint64_t g0 = (f0[i] << 1) | (f0[i - 1] >> 63) | (f0[i] >> 1) | (f0[i + 1] << 63) |
+                      f0[i - stride] | f0[i + stride];
+        uint64_t g1 = (f1[i] << 1) | (f1[i - 1] >> 63) | (f1[i] >> 1) | (f1[i + 1] << 63) |
+                      f1[i - stride] | f1[i + stride];
+        uint64_t unseen = open[i] & ~reached[i];
+        g0 &= unseen;
+        g1 &= unseen;
+        uint64_t tie = g0 & g1;
+        reached[i] |= g0 | g1;
+        g0 &= ~tie;
+        g1 &= ~tie;
+        n0[i] = g0;
+        n1[i] = g1;
+        o0[i] |= g0;
+        o1[i] |= g1;
+        any |= g0 | g1;
+    }
+    return any;
+}
+}
+
+void Territory::resize(int gridCols, int gridRows, int factor) {
+    this->factor = factor;
+    cols = (gridCols + factor - 1) / factor;
+    rows = (gridRows + factor - 1) / factor;
+    words = (cols + 63) / 64;
+    stride = words + 1;
+    size_t count = static_cast<size_t>(rows + 2) * stride;
+    for (auto* bits : {&trailFree, &free, &seen, &front[0], &front[1], &next[0], &next[1], &owned[0], &owned[1],
+                       &narrow}) {
+        bits->assign(count, 0);
+    }
+    folded = false;
+}
+
+bool Territory::cellAt(const Vec2& pos, int& x, int& y) const {
+    if (cols == 0 || pos.x < 0.0f || pos.y < 0.0f) return false;
+    x = static_cast<int>(pos.x / cellSize);
+    y = static_cast<int>(pos.y / cellSize);
+    return x < cols && y < rows;
+}
+
+// Cells inside the berth with no solid trail in any grid cell they cover. Only rows of cells over
+// grid rows written since the last fold are folded again, unless what counts as blocked changed.
+void Territory::foldTrails(const Simulation& sim) {
+    const CollisionGrid& grid = sim.collisionGrid;
+    int gridCols = grid.getCols();
+    int gridRows = grid.getRows();
+    const uint8_t* trail = grid.trailCells();
+    uint8_t solid = (grid.isTrailVisible(0) ? static_cast<uint8_t>(CellType::TrailP1) : 0) |
+                    (grid.isTrailVisible(1) ? static_cast<uint8_t>(CellType::TrailP2) : 0);
+    bool all = !folded || grid.getVersion() < foldedVersion || solid != foldedSolid ||
+               sim.orthoWidth != foldedWidth || sim.orthoHeight != foldedHeight;
+
+    int x0 = std::max(0, static_cast<int>(std::ceil(config.AI_BERTH / cellSize - 0.5f)));
+    int x1 = std::min(cols - 1, static_cast<int>(std::floor((sim.orthoWidth - config.AI_BERTH) / cellSize - 0.5f)));
+    int y0 = std::max(0, static_cast<int>(std::ceil(config.AI_BERTH / cellSize - 0.5f)));
+    int y1 = std::min(rows - 1, static_cast<int>(std::floor((sim.orthoHeight - config.AI_BERTH) / cellSize - 0.5f)));
+
+    // Fold each band of `factor` grid rows into one row of bytes, then each run of `factor` bytes into a bit
+    thread_local std::vector<uint8_t> band;
+    band.assign(static_cast<size_t>(cols) * factor + 8, 0);
+    if (all) {
+        std::fill(trailFree.begin(), trailFree.end(), 0);
+    }
+    for (int y = y0; y <= y1; ++y) {
+        int fineY = y * factor;
+        int fineEnd = std::min(gridRows, fineY + factor);
+        if (!all) {
+            bool written = false;
+            for (int fy = fineY; fy < fineEnd && !written; ++fy) {
+                written = grid.getRowVersion(fy) > foldedVersion;
+            }
+            if (!written) continue;
+        }
+        std::copy(trail + static_cast<size_t>(fineY) * gridCols, trail + static_cast<size_t>(fineY + 1) * gridCols,
+                  band.begin());
+        for (int fy = fineY + 1; fy < fineEnd; ++fy) {
+            const uint8_t* cells = trail + static_cast<size_t>(fy) * gridCols;
+            uint8_t* out = band.data();
+            for (int i = 0; i < gridCols; ++i) {
+                out[i] |= cells[i];
+            }
+        }
+        uint64_t* row = &trailFree[wordAt(0, y)];
+        std::fill(row, row + words, 0);
+        switch (factor) {
+            case 1: foldBand<1>(band.data(), x0, x1, solid, row); break;
+            case 2: foldBand<2>(band.data(), x0, x1, solid, row); break;
+            case 4: foldBand<4>(band.data(), x0, x1, solid, row); break;
+            case 8: foldBand<8>(band.data(), x0, x1, solid, row); break;
+            default: foldBandAny(band.data(), factor, x0, x1, solid, row); break;
+        }
+    }
+    folded = true;
+    foldedVersion = grid.getVersion();
+    foldedSolid = solid;
+    foldedWidth = sim.orthoWidth;
+    foldedHeight = sim.orthoHeight;
+}
+
+// Free cells: what the trails leave open, less cells whose centre is inside a yellow circle
+void Territory::buildBlocked(const Simulation& sim) {
+    foldTrails(sim);
+    free = trailFree;
+    for (const Circle& circle : sim.circles) {
+        if (!circle.isYellow) continue;
+        int cx0 = std::max(0, static_cast<int>((circle.pos.x - circle.radius) / cellSize));
+        int cx1 = std::min(cols - 1, static_cast<int>((circle.pos.x + circle.radius) / cellSize));
+        int cy0 = std::max(0, static_cast<int>((circle.pos.y - circle.radius) / cellSize));
+        int cy1 = std::min(rows - 1, static_cast<int>((circle.pos.y + circle.radius) / cellSize));
+        for (int y = cy0; y <= cy1; ++y) {
+            for (int x = cx0; x <= cx1; ++x) {
+                Vec2 d = Vec2((x + 0.5f) * cellSize, (y + 0.5f) * cellSize) - circle.pos;
+                if (d.dot(d) <= circle.radius * circle.radius) {
+                    free[wordAt(x, y)] &= ~(uint64_t(1) << (x & 63));
+                }
+            }
+        }
+    }
+}
+
+const Territory::Result& Territory::compute(const Simulation& sim) {
+    auto started = std::chrono::steady_clock::now();
+    const CollisionGrid& grid = sim.collisionGrid;
+    int finest = std::max(1, static_cast<int>(std::ceil(MIN_CELL_SIZE / grid.getCellSize() - 0.001f)));
+    int wanted = std::clamp(static_cast<int>(std::lround(config.AI_TERRITORY_CELL_SIZE / grid.getCellSize())), finest,
+                            std::max(finest, 8));
+    if (wanted != factor || (grid.getCols() + wanted - 1) / wanted != cols ||
+        (grid.getRows() + wanted - 1) / wanted != rows) {
+        resize(grid.getCols(), grid.getRows(), wanted);
+    }
+    cellSize = grid.getCellSize() * factor;
+    buildBlocked(sim);
+    for (auto* bits : {&seen, &front[0], &front[1], &next[0], &next[1], &narrow}) {
+        std::fill(bits->begin(), bits->end(), 0);
+    }
+
+    // Heads start their fronts; a head on a blocked cell still searches out of it, and two
+    // heads on one cell share it
+    int lo = rows, hi = -1;
+    const Player* players[2] = {&sim.player1, &sim.player2};
+    for (int p = 0; p < 2; ++p) {
+        int x, y;
+        if (!players[p]->alive || players[p]->willDie || !cellAt(players[p]->pos, x, y)) continue;
+        uint64_t bit = uint64_t(1) << (x & 63);
+        free[wordAt(x, y)] |= bit;
+        seen[wordAt(x, y)] |= bit;
+        if (!(front[1 - p][wordAt(x, y)] & bit)) {
+            front[p][wordAt(x, y)] |= bit;
+        } else {
+            front[1 - p][wordAt(x, y)] &= ~bit;
+        }
+        lo = std::min(lo, y);
+        hi = std::max(hi, y);
+    }
+    owned[0] = front[0];
+    owned[1] = front[1];
+
+    // One step grows both fronts by a cell in each of the four directions, over the band of rows
+    // on or next to a front as one flat run of words, pad words included
+    uint64_t* f0 = front[0].data();
+    uint64_t* f1 = front[1].data();
+    uint64_t* n0 = next[0].data();
+    uint64_t* n1 = next[1].data();
+    uint64_t* o0 = owned[0].data();
+    uint64_t* o1 = owned[1].data();
+    const uint64_t* open = free.data();
+    uint64_t* reached = seen.data();
+    auto rowEmpty = [&](const uint64_t* a, const uint64_t* b, int y) {
+        size_t at = wordAt(0, y);
+        for (int w = 0; w < words; ++w) {
+            if (a[at + w] | b[at + w]) return false;
+        }
+        return true;
+    };
+    while (lo <= hi) {
+        int from = std::max(0, lo - 1), to = std::min(rows - 1, hi + 1);
+        uint64_t any = stepWords(f0, f1, n0, n1, o0, o1, open, reached, wordAt(0, from) - 1, wordAt(0, to) + words,
+                                 stride);
+        std::fill(f0 + wordAt(0, lo) - 1, f0 + wordAt(0, hi) + words, 0);
+        std::fill(f1 + wordAt(0, lo) - 1, f1 + wordAt(0, hi) + words, 0);
+        std::swap(f0, n0);
+        std::swap(f1, n1);
+        if (!any) break;
+        lo = from;
+        hi = to;
+        while (lo <= hi && rowEmpty(f0, f1, lo)) ++lo;
+        while (hi >= lo && rowEmpty(f0, f1, hi)) --hi;
+    }
+    // Narrow cells: reached, walled on two opposite sides and open on the other two
+    size_t begin = wordAt(0, 0), end = wordAt(0, rows - 1) + words;
+    for (size_t i = begin; i < end; ++i) {
+        uint64_t left = (open[i] << 1) | (open[i - 1] >> 63);
+        uint64_t right = (open[i] >> 1) | (open[i + 1] << 63);
+        uint64_t up = open[i - stride], down = open[i + stride];
+        narrow[i] = reached[i] & ((~left & ~right & up & down) | (~up & ~down & left & right));
+    }
+
+    last = Result{{0, 0}, 0, {0, 0}, cellSize * cellSize};
+    for (size_t i = begin; i < end; ++i) {
+        last.owned[0] += __builtin_popcountll(o0[i]);
+        last.owned[1] += __builtin_popcountll(o1[i]);
+        last.contested += __builtin_popcountll(reached[i] & ~(o0[i] | o1[i]));
+        last.narrowCells[0] += __builtin_popcountll(narrow[i] & o0[i]);
+        last.narrowCells[1] += __builtin_popcountll(narrow[i] & o1[i]);
+    }
+
+    if (config.ENABLE_DEBUG) {
+        double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - started).count();
+        SDL_Log("Territory: owned=%d/%d, contested=%d, narrow=%d/%d, cells=%dx%d, time=%fus",
+                last.owned[0], last.owned[1], last.contested, last.narrowCells[0], last.narrowCells[1], cols, rows, us);
+    }
+    return last;
+}
+
+int Territory::ownerAt(const Vec2& pos) const {
+    int x, y;
+    if (!cellAt(pos, x, y)) return NOBODY;
+    if (test(owned[0], x, y)) return 0;
+    if (test(owned[1], x, y)) return 1;
+    if (test(seen, x, y)) return CONTESTED;
+    return NOBODY;
+}
+
+bool Territory::isNarrow(const Vec2& pos) const {
+    int x, y;
+    return cellAt(pos, x, y) && test(narrow, x, y);
+}
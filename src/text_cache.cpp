@@ -0,0 +1,97 @@
+#include "text_cache.h"
+#include "font.h"
+#include "glyph_atlas.h"
+
+TextCache::TextCache() : meshes(), scratch(), frame(0) {}
+
+uint32_t TextCache::packColor(const SDL_Color& color) {
+    return (static_cast<uint32_t>(color.r) << 24) | (static_cast<uint32_t>(color.g) << 16) |
+           (static_cast<uint32_t>(color.b) << 8) | color.a;
+}
+
+// FNV-1a; a collision only means the mesh is rebuilt
+uint64_t TextCache::keyOf(std::string_view text, float squareSize, uint32_t color) {
+    uint64_t hash = 1469598103934665603ull;
+    auto mix = [&hash](const void* data, size_t size) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            hash = (hash ^ bytes[i]) * 1099511628211ull;
+        }
+    };
+    mix(text.data(), text.size());
+    mix(&squareSize, sizeof(squareSize));
+    mix(&color, sizeof(color));
+    return hash;
+}
+
+void TextCache::buildMesh(std::string_view text, float x, float y, float squareSize, const SDL_Color& color,
+                          std::vector<QuadVertex>& out) {
+    float size = Font::SIZE * squareSize;
+    for (char c : text) {
+        uint32_t glyph = Font::glyph(c);
+        if (!(glyph & Font::DEFINED)) continue;
+        if (glyph != Font::DEFINED) {
+            QuadBatch::appendQuad(out, x, y, size, size, color, GlyphAtlas::glyph(c));
+        }
+        x += Font::ADVANCE * squareSize;
+    }
+}
+
+int TextCache::draw(std::string_view text, float x, float y, float squareSize, const SDL_Color& color, GLuint texture) {
+    uint32_t packed = packColor(color);
+    uint64_t key = keyOf(text, squareSize, packed);
+    auto found = meshes.find(key);
+    if (found == meshes.end() || found->second.text != text || found->second.squareSize != squareSize ||
+        found->second.color != packed) {
+        scratch.clear();
+        buildMesh(text, 0.0f, 0.0f, squareSize, color, scratch);
+        Mesh& mesh = meshes[key];
+        if (mesh.vbo == 0) {
+            glGenBuffers(1, &mesh.vbo);
+        }
+        mesh.text.assign(text.data(), text.size());
+        mesh.squareSize = squareSize;
+        mesh.color = packed;
+        mesh.vertices = static_cast<GLsizei>(scratch.size());
+        glBindBuffer(GL_ARRAY_BUFFER, mesh.vbo);
+        glBufferData(GL_ARRAY_BUFFER, scratch.size() * sizeof(QuadVertex), scratch.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        found = meshes.find(key);
+    }
+    Mesh& mesh = found->second;
+    mesh.lastDrawn = frame;
+    if (mesh.vertices == 0) return 0;
+
+    glPushMatrix();
+    glTranslatef(x, y, 0.0f);
+    glEnable(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glBindBuffer(GL_ARRAY_BUFFER, mesh.vbo);
+    QuadBatch::enableArrays();
+    glDrawArrays(GL_QUADS, 0, mesh.vertices);
+    QuadBatch::disableArrays();
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glDisable(GL_TEXTURE_2D);
+    glPopMatrix();
+    return 1;
+}
+
+void TextCache::endFrame() {
+    ++frame;
+    for (auto it = meshes.begin(); it != meshes.end();) {
+        if (frame - it->second.lastDrawn > KEEP_FRAMES) {
+            glDeleteBuffers(1, &it->second.vbo);
+            it = meshes.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void TextCache::shutdown() {
+    for (auto& entry : meshes) {
+        glDeleteBuffers(1, &entry.second.vbo);
+    }
+    meshes.clear();
+}
@@ -0,0 +1,124 @@
+#include "thread_pool.h"
+
+ThreadPool::ThreadPool(int helpers)
+    : workers(),
+      runs(),
+      mutex(),
+      wake(),
+      done(),
+      job(nullptr),
+      busy(0),
+      generation(0),
+      stopping(false) {
+    for (int i = 0; i <= helpers; ++i) {
+        runs.push_back(std::make_unique<Run>());
+    }
+    for (int i = 0; i < helpers; ++i) {
+        workers.emplace_back(&ThreadPool::workerLoop, this, i + 1);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+bool ThreadPool::takeOwn(int index, int& piece) {
+    Run& run = *runs[index];
+    std::lock_guard<std::mutex> lock(run.lock);
+    if (run.begin >= run.end) return false;
+    piece = run.begin++;
+    return true;
+}
+
+// Move the back half of the largest other run into this thread's own, which is empty.
+// Only one run is locked at a time, so two thieves can never wait on each other.
+bool ThreadPool::steal(int index) {
+    int count = static_cast<int>(runs.size());
+    while (true) {
+        int victim = -1;
+        int most = 0;
+        for (int k = 1; k < count; ++k) {
+            int other = (index + k) % count;
+            Run& run = *runs[other];
+            std::lock_guard<std::mutex> lock(run.lock);
+            if (run.end - run.begin > most) {
+                most = run.end - run.begin;
+                victim = other;
+            }
+        }
+        if (victim < 0) return false;
+
+        int begin, end;
+        {
+            Run& run = *runs[victim];
+            std::lock_guard<std::mutex> lock(run.lock);
+            int left = run.end - run.begin;
+            if (left <= 0) continue; // emptied since the scan, look again
+            end = run.end;
+            run.end -= (left + 1) / 2;
+            begin = run.end;
+        }
+        Run& own = *runs[index];
+        std::lock_guard<std::mutex> lock(own.lock);
+        own.begin = begin;
+        own.end = end;
+        return true;
+    }
+}
+
+void ThreadPool::runPieces(int index) {
+    int piece;
+    do {
+        while (takeOwn(index, piece)) {
+            (*job)(piece);
+        }
+    } while (steal(index));
+}
+
+void ThreadPool::parallelFor(int count, const std::function<void(int)>& fn) {
+    if (workers.empty() || count <= 1) {
+        for (int i = 0; i < count; ++i) fn(i);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job = &fn;
+        int threads = static_cast<int>(runs.size());
+        for (int i = 0; i < threads; ++i) {
+            Run& run = *runs[i];
+            std::lock_guard<std::mutex> runLock(run.lock);
+            run.begin = static_cast<int>(static_cast<int64_t>(count) * i / threads);
+            run.end = static_cast<int>(static_cast<int64_t>(count) * (i + 1) / threads);
+        }
+        busy = static_cast<int>(workers.size());
+        ++generation;
+    }
+    wake.notify_all();
+    runPieces(0);
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this] { return busy == 0; });
+    job = nullptr;
+}
+
+void ThreadPool::workerLoop(int index) {
+    uint64_t seen = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [&] { return stopping || generation != seen; });
+        if (stopping) return;
+        seen = generation;
+        lock.unlock();
+        runPieces(index);
+        lock.lock();
+        if (--busy == 0) {
+            done.notify_one();
+        }
+    }
+}
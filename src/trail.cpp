@@ -0,0 +1,143 @@
+#include "types.h"
+#include <cmath>
+
+// How far (ortho units) a point may sit off the line and still stretch the last segment
+static const float COLLINEAR_TOLERANCE = 0.05f;
+// Pieces shorter than this are dropped when a circle cuts a segment
+static const float MIN_PIECE_LENGTH = 1e-3f;
+
+void Trail::clear() {
+    chunks.clear();
+    freeSlots.clear();
+    used = 0;
+    liveCount = 0;
+    tipValid = false;
+    tipSegment = NO_SLOT;
+    // Skip a number so every reader starts over
+    editBase = editCount() + 1;
+    editLog.clear();
+}
+
+void Trail::edited(size_t slot) {
+    if (editLog.size() >= MAX_EDITS) {
+        editLog.erase(editLog.begin(), editLog.begin() + MAX_EDITS / 2);
+        editBase += MAX_EDITS / 2;
+    }
+    editLog.push_back(static_cast<uint32_t>(slot));
+}
+
+size_t Trail::addSegment(const Vec2& a, const Vec2& b) {
+    size_t slot;
+    if (!freeSlots.empty()) {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    } else {
+        if (used == chunks.size() * CHUNK_SIZE) {
+            chunks.emplace_back(new TrailSegment[CHUNK_SIZE]);
+        }
+        slot = used++;
+    }
+    at(slot) = TrailSegment{a, b, 0xFFFFFFFFu, true};
+    ++liveCount;
+    edited(slot);
+    return slot;
+}
+
+void Trail::removeSlot(size_t i) {
+    at(i).live = false;
+    freeSlots.push_back(i);
+    --liveCount;
+    edited(i);
+    if (tipSegment == static_cast<long>(i)) tipSegment = NO_SLOT;
+}
+
+Trail::Growth Trail::extend(const Vec2& point) {
+    if (!tipValid) {
+        // Start of a run
+        tipPos = point;
+        tipValid = true;
+        tipSegment = NO_SLOT;
+        return Growth::Started;
+    }
+    if (point == tipPos) return Growth::Unchanged;
+
+    // The segment keeps its line and b moves along it to the point's projection. Every point it
+    // took in was checked against that same line, so none strays further than the tolerance.
+    if (tipSegment != NO_SLOT) {
+        TrailSegment& last = at(static_cast<size_t>(tipSegment));
+        Vec2 step = point - last.b;
+        float lengthSq = tipDir.dot(tipDir);
+        float cross = tipDir.x * step.y - tipDir.y * step.x;
+        if (lengthSq > 0 && tipDir.dot(step) > 0 && std::abs(cross) <= COLLINEAR_TOLERANCE * std::sqrt(lengthSq)) {
+            last.b = last.a + tipDir * ((point - last.a).dot(tipDir) / lengthSq);
+            tipPos = point;
+            edited(static_cast<size_t>(tipSegment));
+            return Growth::Stretched;
+        }
+    }
+
+    tipSegment = static_cast<long>(addSegment(tipPos, point));
+    tipDir = point - tipPos;
+    tipPos = point;
+    return Growth::Appended;
+}
+
+// Remove the part of one segment inside the circle. A cut through the middle leaves two
+// pieces; the far piece goes in a new slot and keeps the tip if the segment had it.
+Trail::Cut Trail::cutCircle(size_t slot, const Vec2& center, float radius, long& newSlot) {
+    newSlot = NO_SLOT;
+    TrailSegment& segment = at(slot);
+    if (!segment.live) return Cut::Missed;
+
+    Vec2 d = segment.b - segment.a;
+    Vec2 f = segment.a - center;
+    float a = d.dot(d);
+    float c = f.dot(f) - radius * radius;
+    if (a <= 0) {
+        if (c >= 0) return Cut::Missed;
+        removeSlot(slot);
+        return Cut::Removed;
+    }
+    float b = 2.0f * f.dot(d);
+    float disc = b * b - 4.0f * a * c;
+    if (disc <= 0) return Cut::Missed;
+    float root = std::sqrt(disc);
+    float t1 = (-b - root) / (2.0f * a);
+    float t2 = (-b + root) / (2.0f * a);
+    if (t1 >= 1.0f || t2 <= 0.0f) return Cut::Missed;
+
+    float length = std::sqrt(a);
+    bool keepStart = t1 > 0.0f && t1 * length > MIN_PIECE_LENGTH;
+    bool keepEnd = t2 < 1.0f && (1.0f - t2) * length > MIN_PIECE_LENGTH;
+    Vec2 endStart = segment.a + d * t2;
+    Vec2 endEnd = segment.b;
+    bool wasTip = tipSegment == static_cast<long>(slot);
+
+    if (keepStart && keepEnd) {
+        segment.b = segment.a + d * t1;
+        edited(slot);
+        newSlot = static_cast<long>(addSegment(endStart, endEnd));
+        if (wasTip) tipSegment = newSlot;
+        return Cut::Split;
+    }
+    if (keepStart) {
+        segment.b = segment.a + d * t1;
+        if (wasTip) tipSegment = NO_SLOT; // the tip went with the erased part
+        edited(slot);
+        return Cut::Shortened;
+    }
+    if (keepEnd) {
+        segment.a = endStart;
+        edited(slot);
+        return Cut::Shortened;
+    }
+    removeSlot(slot);
+    return Cut::Removed;
+}
+
+bool Trail::breakTipInCircle(const Vec2& center, float radius) {
+    if (!tipValid || (tipPos - center).dot(tipPos - center) >= radius * radius) return false;
+    tipValid = false;
+    tipSegment = NO_SLOT;
+    return true;
+}
@@ -0,0 +1,138 @@
+#include "trail_buffer.h"
+#include <algorithm>
+#include <cstdint>
+
+TrailBuffer::TrailBuffer()
+    : vbo(0),
+      capacity(0),
+      vertices(),
+      positionOfSlot(),
+      slotAt(),
+      synced(nullptr),
+      seen(0),
+      dirty(),
+      dirtyAll(false) {}
+
+void TrailBuffer::draw(const Trail& trail) {
+    if (synced != &trail || seen < trail.firstLoggedEdit()) {
+        rebuild(trail);
+    } else {
+        for (uint64_t edit = seen; edit < trail.editCount(); ++edit) {
+            apply(trail, trail.editedSlot(edit));
+        }
+    }
+    seen = trail.editCount();
+    upload();
+
+    size_t segments = slotAt.size();
+    if (segments == 0) return;
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(2, GL_FLOAT, 0, nullptr);
+    glDrawArrays(GL_LINES, 0, static_cast<GLsizei>(segments * 2));
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void TrailBuffer::shutdown() {
+    if (vbo != 0) {
+        glDeleteBuffers(1, &vbo);
+        vbo = 0;
+    }
+    capacity = 0;
+    synced = nullptr;
+}
+
+// Gaps are not stored as segments, so every live slot goes in
+void TrailBuffer::rebuild(const Trail& trail) {
+    synced = &trail;
+    vertices.clear();
+    slotAt.clear();
+    positionOfSlot.assign(trail.slots(), ABSENT);
+    for (size_t slot = 0; slot < trail.slots(); ++slot) {
+        apply(trail, slot);
+    }
+    dirty.clear();
+    dirtyAll = true;
+}
+
+void TrailBuffer::apply(const Trail& trail, size_t slot) {
+    if (slot >= positionOfSlot.size()) {
+        positionOfSlot.resize(slot + 1, ABSENT);
+    }
+    int32_t position = positionOfSlot[slot];
+    bool live = slot < trail.slots() && trail[slot].live;
+    if (live) {
+        if (position == ABSENT) {
+            position = static_cast<int32_t>(slotAt.size());
+            positionOfSlot[slot] = position;
+            slotAt.push_back(static_cast<uint32_t>(slot));
+            vertices.resize(slotAt.size() * FLOATS_PER_SEGMENT);
+        }
+        write(static_cast<size_t>(position), trail[slot]);
+    } else if (position != ABSENT) {
+        // Fill the hole with the last segment
+        size_t last = slotAt.size() - 1;
+        if (static_cast<size_t>(position) != last) {
+            uint32_t moved = slotAt[last];
+            std::copy_n(vertices.begin() + last * FLOATS_PER_SEGMENT, FLOATS_PER_SEGMENT,
+                        vertices.begin() + position * FLOATS_PER_SEGMENT);
+            slotAt[position] = moved;
+            positionOfSlot[moved] = position;
+            dirty.push_back(static_cast<uint32_t>(position));
+        }
+        slotAt.pop_back();
+        vertices.resize(slotAt.size() * FLOATS_PER_SEGMENT);
+        positionOfSlot[slot] = ABSENT;
+    }
+}
+
+void TrailBuffer::write(size_t position, const TrailSegment& segment) {
+    float* out = &vertices[position * FLOATS_PER_SEGMENT];
+    out[0] = segment.a.x;
+    out[1] = segment.a.y;
+    out[2] = segment.b.x;
+    out[3] = segment.b.y;
+    if (!dirtyAll) {
+        dirty.push_back(static_cast<uint32_t>(position));
+    }
+}
+
+// Grows by doubling, which uploads everything once; otherwise one upload per run of written
+// positions, with runs closer than MERGE_GAP joined. Positions past the end were popped since.
+void TrailBuffer::upload() {
+    size_t segments = slotAt.size();
+    if (vbo == 0) {
+        glGenBuffers(1, &vbo);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    if (segments > capacity) {
+        capacity = std::max<size_t>(Trail::CHUNK_SIZE, capacity);
+        while (capacity < segments) capacity *= 2;
+        glBufferData(GL_ARRAY_BUFFER, capacity * FLOATS_PER_SEGMENT * sizeof(float), nullptr, GL_DYNAMIC_DRAW);
+        dirtyAll = true;
+    }
+    auto send = [&](size_t begin, size_t end) {
+        glBufferSubData(GL_ARRAY_BUFFER, begin * FLOATS_PER_SEGMENT * sizeof(float),
+                        (end - begin) * FLOATS_PER_SEGMENT * sizeof(float), &vertices[begin * FLOATS_PER_SEGMENT]);
+    };
+    if (dirtyAll) {
+        if (segments > 0) send(0, segments);
+    } else if (!dirty.empty()) {
+        std::sort(dirty.begin(), dirty.end());
+        size_t begin = SIZE_MAX, end = 0;
+        for (uint32_t position : dirty) {
+            if (position >= segments) break;
+            if (begin != SIZE_MAX && position > end + MERGE_GAP) {
+                send(begin, end);
+                begin = SIZE_MAX;
+            }
+            if (begin == SIZE_MAX) begin = position;
+            end = position + 1u;
+        }
+        if (begin != SIZE_MAX) send(begin, end);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    dirty.clear();
+    dirtyAll = false;
+}
@@ -0,0 +1,249 @@
+#include "trail_layer.h"
+#include "simulation.h"
+#include <SDL2/SDL.h>
+#include <algorithm>
+#include <cmath>
+
+TrailLayer::TrailLayer(const GameConfig& config)
+    : config(config),
+      framebuffer(0),
+      texture(0),
+      width(0),
+      height(0),
+      unsupported(!config.TRAIL_LAYER),
+      orthoWidth(0.0f),
+      orthoHeight(0.0f),
+      players{{nullptr, 0, false, {}}, {nullptr, 0, false, {}}},
+      tilesX(0),
+      tilesY(0),
+      reach(config.TRAIL_SIZE * 0.5f + 2.0f),
+      dirty(),
+      dirtyCount(0),
+      hits(),
+      lines(),
+      boxes(),
+      grownBoxes() {}
+
+bool TrailLayer::allocate(int drawableWidth, int drawableHeight) {
+    if (framebuffer != 0 && drawableWidth == width && drawableHeight == height) return true;
+    shutdown();
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, drawableWidth, drawableHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (!complete) {
+        SDL_Log("Trail layer: framebuffer incomplete, drawing trails directly");
+        shutdown();
+        unsupported = true;
+        return false;
+    }
+    width = drawableWidth;
+    height = drawableHeight;
+    tilesX = (width + TILE - 1) / TILE;
+    tilesY = (height + TILE - 1) / TILE;
+    dirty.assign(static_cast<size_t>(tilesX) * tilesY, 0);
+    dirtyCount = 0;
+    players[0].trail = players[1].trail = nullptr; // new texture, draw it all
+    return true;
+}
+
+void TrailLayer::noteEdit(Drawn& drawn, const Trail& trail, size_t slot) {
+    if (slot >= drawn.slots.size()) {
+        drawn.slots.resize(slot + 1, TrailSegment{Vec2(), Vec2(), 0, false});
+    }
+    TrailSegment& before = drawn.slots[slot];
+    TrailSegment after = slot < trail.slots() ? trail[slot] : TrailSegment{Vec2(), Vec2(), 0, false};
+    if (drawn.visible) {
+        if (before.live) markSegment(before.a, before.b);
+        if (after.live) markSegment(after.a, after.b);
+    }
+    before = after;
+}
+
+// In pieces no longer than a tile, so a long diagonal marks the tiles along it and not its box
+void TrailLayer::markSegment(const Vec2& a, const Vec2& b) {
+    float sx = width / orthoWidth, sy = height / orthoHeight;
+    Vec2 from(a.x * sx, a.y * sy);
+    Vec2 step = Vec2(b.x * sx, b.y * sy) - from;
+    int pieces = std::max(1, static_cast<int>(std::ceil(step.magnitude() / TILE)));
+    step = step * (1.0f / pieces);
+    for (int i = 0; i < pieces; ++i) {
+        Vec2 to = from + step;
+        int tx0 = std::max(0, static_cast<int>(std::floor((std::min(from.x, to.x) - reach) / TILE)));
+        int ty0 = std::max(0, static_cast<int>(std::floor((std::min(from.y, to.y) - reach) / TILE)));
+        int tx1 = std::min(tilesX - 1, static_cast<int>(std::floor((std::max(from.x, to.x) + reach) / TILE)));
+        int ty1 = std::min(tilesY - 1, static_cast<int>(std::floor((std::max(from.y, to.y) + reach) / TILE)));
+        for (int ty = ty0; ty <= ty1; ++ty) {
+            for (int tx = tx0; tx <= tx1; ++tx) {
+                uint8_t& tile = dirty[static_cast<size_t>(ty) * tilesX + tx];
+                dirtyCount += tile == 0;
+                tile = 1;
+            }
+        }
+        from = to;
+    }
+}
+
+bool TrailLayer::update(const Simulation& sim, int drawableWidth, int drawableHeight, TrailBuffer* buffers,
+                        int& drawCalls) {
+    if (unsupported || !allocate(drawableWidth, drawableHeight)) return false;
+
+    bool all = sim.orthoWidth != orthoWidth || sim.orthoHeight != orthoHeight;
+    for (int i = 0; i < 2; ++i) {
+        const Player& player = i == 0 ? sim.player1 : sim.player2;
+        const Drawn& drawn = players[i];
+        bool visible = player.alive && !player.isInvincible;
+        if (drawn.trail != &player.trail || drawn.seen < player.trail.firstLoggedEdit() || drawn.visible != visible) {
+            all = true;
+        }
+    }
+    if (!all) {
+        for (int i = 0; i < 2; ++i) {
+            const Trail& trail = i == 0 ? sim.player1.trail : sim.player2.trail;
+            for (uint64_t edit = players[i].seen; edit < trail.editCount(); ++edit) {
+                noteEdit(players[i], trail, trail.editedSlot(edit));
+            }
+            players[i].seen = trail.editCount();
+        }
+        all = dirtyCount * 2 > dirty.size();
+    }
+    if (!all && dirtyCount == 0) return true;
+
+    GLfloat clearColor[4];
+    glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    if (all) {
+        redraw(sim, buffers, drawCalls);
+    } else {
+        // Each run of marked tiles in a row joins the first box above that it touches, if the
+        // box stays at least half marked; boxes that take nothing from a row are repaired
+        auto flush = [&](const Box& box) {
+            repair(sim, box.x0 * TILE, box.y0 * TILE, std::min((box.x1 + 1) * TILE, width),
+                   std::min((box.y1 + 1) * TILE, height), drawCalls);
+        };
+        glEnable(GL_SCISSOR_TEST);
+        boxes.clear();
+        for (int ty = 0; ty <= tilesY; ++ty) {
+            const uint8_t* row = ty < tilesY ? &dirty[static_cast<size_t>(ty) * tilesX] : nullptr;
+            grownBoxes.clear();
+            for (int tx = 0; row && tx < tilesX; ++tx) {
+                if (!row[tx]) continue;
+                int end = tx;
+                while (end + 1 < tilesX && row[end + 1]) ++end;
+                Box run{tx, ty, end, ty, end - tx + 1, false};
+                for (Box& box : boxes) {
+                    if (box.grown || box.x1 < tx - 1 || box.x0 > end + 1) continue;
+                    Box joined{std::min(box.x0, tx), box.y0, std::max(box.x1, end), ty, box.marked + run.marked, false};
+                    if (joined.marked * 2 >= (joined.x1 - joined.x0 + 1) * (ty - box.y0 + 1)) {
+                        box.grown = true;
+                        run = joined;
+                    }
+                    break;
+                }
+                grownBoxes.push_back(run);
+                tx = end;
+            }
+            for (const Box& box : boxes) {
+                if (!box.grown) flush(box);
+            }
+            boxes.swap(grownBoxes);
+        }
+        glDisable(GL_SCISSOR_TEST);
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+    std::fill(dirty.begin(), dirty.end(), 0);
+    dirtyCount = 0;
+    return true;
+}
+
+void TrailLayer::redraw(const Simulation& sim, TrailBuffer* buffers, int& drawCalls) {
+    glClear(GL_COLOR_BUFFER_BIT);
+    orthoWidth = sim.orthoWidth;
+    orthoHeight = sim.orthoHeight;
+    glLineWidth(config.TRAIL_SIZE);
+    for (int i = 0; i < 2; ++i) {
+        const Player& player = i == 0 ? sim.player1 : sim.player2;
+        Drawn& drawn = players[i];
+        drawn.trail = &player.trail;
+        drawn.seen = player.trail.editCount();
+        drawn.visible = player.alive && !player.isInvincible;
+        drawn.slots.resize(player.trail.slots());
+        for (size_t slot = 0; slot < player.trail.slots(); ++slot) {
+            drawn.slots[slot] = player.trail[slot];
+        }
+        if (drawn.visible && player.trail.size() > 0) {
+            glColor4ub(player.color.r, player.color.g, player.color.b, player.color.a);
+            buffers[i].draw(player.trail);
+            ++drawCalls;
+        }
+    }
+    glLineWidth(1.0f);
+}
+
+// Clear a box of tiles and draw every segment whose stroke reaches into it
+void TrailLayer::repair(const Simulation& sim, int x0, int y0, int x1, int y1, int& drawCalls) {
+    glScissor(x0, height - y1, x1 - x0, y1 - y0);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    float ux = orthoWidth / width, uy = orthoHeight / height;
+    sim.segmentIndex.queryBox((x0 - reach) * ux, (y0 - reach) * uy, (x1 + reach) * ux, (y1 + reach) * uy, hits);
+    if (hits.empty()) return;
+    glLineWidth(config.TRAIL_SIZE);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    for (int owner = 0; owner < 2; ++owner) {
+        if (!players[owner].visible) continue;
+        const Trail& trail = owner == 0 ? sim.player1.trail : sim.player2.trail;
+        lines.clear();
+        for (uint32_t id : hits) {
+            const SegmentIndex::Entry& entry = sim.segmentIndex.entry(id);
+            if (entry.owner != owner) continue;
+            const TrailSegment& segment = trail[entry.slot];
+            lines.insert(lines.end(), {segment.a.x, segment.a.y, segment.b.x, segment.b.y});
+        }
+        if (lines.empty()) continue;
+        const SDL_Color& color = owner == 0 ? sim.player1.color : sim.player2.color;
+        glColor4ub(color.r, color.g, color.b, color.a);
+        glVertexPointer(2, GL_FLOAT, 0, lines.data());
+        glDrawArrays(GL_LINES, 0, static_cast<GLsizei>(lines.size() / 2));
+        ++drawCalls;
+    }
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glLineWidth(1.0f);
+}
+
+// Texel rows run bottom up, the board top down
+void TrailLayer::composite(int& drawCalls) const {
+    glEnable(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glColor4ub(255, 255, 255, 255);
+    glBegin(GL_QUADS);
+    glTexCoord2f(0, 1); glVertex2f(0, 0);
+    glTexCoord2f(1, 1); glVertex2f(orthoWidth, 0);
+    glTexCoord2f(1, 0); glVertex2f(orthoWidth, orthoHeight);
+    glTexCoord2f(0, 0); glVertex2f(0, orthoHeight);
+    glEnd();
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glDisable(GL_TEXTURE_2D);
+    ++drawCalls;
+}
+
+void TrailLayer::shutdown() {
+    if (framebuffer != 0) {
+        glDeleteFramebuffers(1, &framebuffer);
+        framebuffer = 0;
+    }
+    if (texture != 0) {
+        glDeleteTextures(1, &texture);
+        texture = 0;
+    }
+    width = height = 0;
+}